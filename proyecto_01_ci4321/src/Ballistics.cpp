@@ -0,0 +1,273 @@
+#include "Ballistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#define BALLISTICS_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BALLISTICS_SSE2
+#include <emmintrin.h>
+#endif
+
+// Cada iteracion del kernel integra un lote de 8 proyectiles
+const int batchSize = 8;
+
+BallisticsSettings defaultBallistics()
+{
+	BallisticsSettings settings;
+	settings.gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+	settings.drag = 0.002f;
+	settings.worldMin = glm::vec3(-256.0f, -1.0f, -256.0f);
+	settings.worldMax = glm::vec3(256.0f, 128.0f, 256.0f);
+	return settings;
+}
+
+ProjectileSystem::ProjectileSystem(const BallisticsSettings& settings)
+	: settings(settings)
+{
+	count = 0;
+}
+
+void ProjectileSystem::Spawn(glm::vec3 position, glm::vec3 velocity, float lifetime, int tag)
+{
+	// Se crece de a un lote; los carriles de relleno se integran pero nunca
+	// se informan
+	if (count == (int)life.size()) {
+		size_t size = life.size() + batchSize;
+		for (vector<float>* array : { &positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ, &life }) {
+			array->resize(size, 0.0f);
+		}
+		tags.resize(size, -1);
+	}
+
+	positionX[count] = position.x;
+	positionY[count] = position.y;
+	positionZ[count] = position.z;
+	velocityX[count] = velocity.x;
+	velocityY[count] = velocity.y;
+	velocityZ[count] = velocity.z;
+	life[count] = lifetime;
+	tags[count] = tag;
+	count++;
+}
+
+void ProjectileSystem::Remove(int index)
+{
+	int last = --count;
+	positionX[index] = positionX[last];
+	positionY[index] = positionY[last];
+	positionZ[index] = positionZ[last];
+	velocityX[index] = velocityX[last];
+	velocityY[index] = velocityY[last];
+	velocityZ[index] = velocityZ[last];
+	life[index] = life[last];
+	tags[index] = tags[last];
+}
+
+void ProjectileSystem::Clear()
+{
+	count = 0;
+}
+
+int ProjectileSystem::Find(int tag) const
+{
+	for (int i = 0; i < count; i++) {
+		if (tags[i] == tag) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+#if defined(BALLISTICS_AVX2)
+
+typedef __m256 Lane;
+#define LANE_SET(value) _mm256_set1_ps(value)
+
+#elif defined(BALLISTICS_SSE2)
+
+typedef __m128 Lane;
+#define LANE_SET(value) _mm_set1_ps(value)
+
+#else
+
+typedef float Lane;
+#define LANE_SET(value) (value)
+
+#endif
+
+// Constantes del paso ya replicadas en registros. Se arman una vez por
+// Update: dentro del bucle el compilador no puede sacarlas de 'settings'
+// porque las escrituras a los arreglos podrian pisarla
+struct BatchConstants
+{
+	Lane gravityX, gravityY, gravityZ;
+	Lane drag;
+	Lane deltaTime;
+	Lane minX, minY, minZ;
+	Lane maxX, maxY, maxZ;
+};
+
+static BatchConstants batchConstants(const BallisticsSettings& settings, float deltaTime)
+{
+	BatchConstants constants;
+	constants.gravityX = LANE_SET(settings.gravity.x);
+	constants.gravityY = LANE_SET(settings.gravity.y);
+	constants.gravityZ = LANE_SET(settings.gravity.z);
+	constants.drag = LANE_SET(settings.drag);
+	constants.deltaTime = LANE_SET(deltaTime);
+	constants.minX = LANE_SET(settings.worldMin.x);
+	constants.minY = LANE_SET(settings.worldMin.y);
+	constants.minZ = LANE_SET(settings.worldMin.z);
+	constants.maxX = LANE_SET(settings.worldMax.x);
+	constants.maxY = LANE_SET(settings.worldMax.y);
+	constants.maxZ = LANE_SET(settings.worldMax.z);
+	return constants;
+}
+
+#if defined(BALLISTICS_AVX2)
+
+static inline int integrateBatch(float* px, float* py, float* pz, float* vx, float* vy, float* vz, float* life,
+	const BatchConstants& k)
+{
+	__m256 velX = _mm256_loadu_ps(vx), velY = _mm256_loadu_ps(vy), velZ = _mm256_loadu_ps(vz);
+	__m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(velX, velX), _mm256_mul_ps(velY, velY)), _mm256_mul_ps(velZ, velZ)));
+	__m256 damping = _mm256_mul_ps(k.drag, speed);
+
+	// v += (g - k|v|v) dt; p += v dt
+	velX = _mm256_add_ps(velX, _mm256_mul_ps(_mm256_sub_ps(k.gravityX, _mm256_mul_ps(damping, velX)), k.deltaTime));
+	velY = _mm256_add_ps(velY, _mm256_mul_ps(_mm256_sub_ps(k.gravityY, _mm256_mul_ps(damping, velY)), k.deltaTime));
+	velZ = _mm256_add_ps(velZ, _mm256_mul_ps(_mm256_sub_ps(k.gravityZ, _mm256_mul_ps(damping, velZ)), k.deltaTime));
+	__m256 posX = _mm256_add_ps(_mm256_loadu_ps(px), _mm256_mul_ps(velX, k.deltaTime));
+	__m256 posY = _mm256_add_ps(_mm256_loadu_ps(py), _mm256_mul_ps(velY, k.deltaTime));
+	__m256 posZ = _mm256_add_ps(_mm256_loadu_ps(pz), _mm256_mul_ps(velZ, k.deltaTime));
+	__m256 remaining = _mm256_sub_ps(_mm256_loadu_ps(life), k.deltaTime);
+
+	_mm256_storeu_ps(vx, velX);
+	_mm256_storeu_ps(vy, velY);
+	_mm256_storeu_ps(vz, velZ);
+	_mm256_storeu_ps(px, posX);
+	_mm256_storeu_ps(py, posY);
+	_mm256_storeu_ps(pz, posZ);
+	_mm256_storeu_ps(life, remaining);
+
+	__m256 outside = _mm256_cmp_ps(remaining, _mm256_setzero_ps(), _CMP_LE_OQ);
+	outside = _mm256_or_ps(outside, _mm256_cmp_ps(posX, k.minX, _CMP_LT_OQ));
+	outside = _mm256_or_ps(outside, _mm256_cmp_ps(posY, k.minY, _CMP_LT_OQ));
+	outside = _mm256_or_ps(outside, _mm256_cmp_ps(posZ, k.minZ, _CMP_LT_OQ));
+	outside = _mm256_or_ps(outside, _mm256_cmp_ps(posX, k.maxX, _CMP_GT_OQ));
+	outside = _mm256_or_ps(outside, _mm256_cmp_ps(posY, k.maxY, _CMP_GT_OQ));
+	outside = _mm256_or_ps(outside, _mm256_cmp_ps(posZ, k.maxZ, _CMP_GT_OQ));
+	return _mm256_movemask_ps(outside);
+}
+
+#elif defined(BALLISTICS_SSE2)
+
+static inline int integrateHalf(float* px, float* py, float* pz, float* vx, float* vy, float* vz, float* life,
+	const BatchConstants& k)
+{
+	__m128 velX = _mm_loadu_ps(vx), velY = _mm_loadu_ps(vy), velZ = _mm_loadu_ps(vz);
+	__m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velY, velY)), _mm_mul_ps(velZ, velZ)));
+	__m128 damping = _mm_mul_ps(k.drag, speed);
+
+	velX = _mm_add_ps(velX, _mm_mul_ps(_mm_sub_ps(k.gravityX, _mm_mul_ps(damping, velX)), k.deltaTime));
+	velY = _mm_add_ps(velY, _mm_mul_ps(_mm_sub_ps(k.gravityY, _mm_mul_ps(damping, velY)), k.deltaTime));
+	velZ = _mm_add_ps(velZ, _mm_mul_ps(_mm_sub_ps(k.gravityZ, _mm_mul_ps(damping, velZ)), k.deltaTime));
+	__m128 posX = _mm_add_ps(_mm_loadu_ps(px), _mm_mul_ps(velX, k.deltaTime));
+	__m128 posY = _mm_add_ps(_mm_loadu_ps(py), _mm_mul_ps(velY, k.deltaTime));
+	__m128 posZ = _mm_add_ps(_mm_loadu_ps(pz), _mm_mul_ps(velZ, k.deltaTime));
+	__m128 remaining = _mm_sub_ps(_mm_loadu_ps(life), k.deltaTime);
+
+	_mm_storeu_ps(vx, velX);
+	_mm_storeu_ps(vy, velY);
+	_mm_storeu_ps(vz, velZ);
+	_mm_storeu_ps(px, posX);
+	_mm_storeu_ps(py, posY);
+	_mm_storeu_ps(pz, posZ);
+	_mm_storeu_ps(life, remaining);
+
+	__m128 outside = _mm_cmple_ps(remaining, _mm_setzero_ps());
+	outside = _mm_or_ps(outside, _mm_cmplt_ps(posX, k.minX));
+	outside = _mm_or_ps(outside, _mm_cmplt_ps(posY, k.minY));
+	outside = _mm_or_ps(outside, _mm_cmplt_ps(posZ, k.minZ));
+	outside = _mm_or_ps(outside, _mm_cmpgt_ps(posX, k.maxX));
+	outside = _mm_or_ps(outside, _mm_cmpgt_ps(posY, k.maxY));
+	outside = _mm_or_ps(outside, _mm_cmpgt_ps(posZ, k.maxZ));
+	return _mm_movemask_ps(outside);
+}
+
+// Con SSE2 el lote de 8 son dos registros de 4
+static inline int integrateBatch(float* px, float* py, float* pz, float* vx, float* vy, float* vz, float* life,
+	const BatchConstants& k)
+{
+	int low = integrateHalf(px, py, pz, vx, vy, vz, life, k);
+	int high = integrateHalf(px + 4, py + 4, pz + 4, vx + 4, vy + 4, vz + 4, life + 4, k);
+	return low | high << 4;
+}
+
+#else
+
+static inline int integrateBatch(float* px, float* py, float* pz, float* vx, float* vy, float* vz, float* life,
+	const BatchConstants& k)
+{
+	int deadMask = 0;
+	for (int lane = 0; lane < batchSize; lane++) {
+		float damping = k.drag * sqrtf(vx[lane] * vx[lane] + vy[lane] * vy[lane] + vz[lane] * vz[lane]);
+		vx[lane] += (k.gravityX - damping * vx[lane]) * k.deltaTime;
+		vy[lane] += (k.gravityY - damping * vy[lane]) * k.deltaTime;
+		vz[lane] += (k.gravityZ - damping * vz[lane]) * k.deltaTime;
+		px[lane] += vx[lane] * k.deltaTime;
+		py[lane] += vy[lane] * k.deltaTime;
+		pz[lane] += vz[lane] * k.deltaTime;
+		life[lane] -= k.deltaTime;
+
+		bool outside = life[lane] <= 0.0f
+			|| px[lane] < k.minX || py[lane] < k.minY || pz[lane] < k.minZ
+			|| px[lane] > k.maxX || py[lane] > k.maxY || pz[lane] > k.maxZ;
+		deadMask |= outside << lane;
+	}
+	return deadMask;
+}
+
+#endif
+
+void ProjectileSystem::Update(float deltaTime, vector<int>& expired)
+{
+	dead.clear();
+	BatchConstants constants = batchConstants(settings, deltaTime);
+
+	// Los arreglos miden un multiplo de 8, el ultimo lote nunca se sale
+	for (int i = 0; i < count; i += batchSize) {
+		int mask = integrateBatch(&positionX[i], &positionY[i], &positionZ[i], &velocityX[i], &velocityY[i], &velocityZ[i],
+			&life[i], constants);
+
+		for (int lane = 0; mask; lane++, mask >>= 1) {
+			if ((mask & 1) && i + lane < count) {
+				dead.push_back(i + lane);
+			}
+		}
+	}
+
+	// De atras hacia adelante: el que se mueve al hueco ya fue revisado
+	for (int i = (int)dead.size() - 1; i >= 0; i--) {
+		expired.push_back(tags[dead[i]]);
+		Remove(dead[i]);
+	}
+}
+
+glm::vec3 orientationAlong(glm::vec3 direction)
+{
+	float length = glm::length(direction);
+	if (length <= 0.0f) {
+		return glm::vec3(0.0f);
+	}
+	direction /= length;
+
+	// ModelMatrix aplica Rx(pitch) * Ry(yaw) al eje +z:
+	// (sin yaw, -sin pitch cos yaw, cos pitch cos yaw)
+	float yaw = asinf(std::clamp(direction.x, -1.0f, 1.0f));
+	float pitch = atan2f(-direction.y, direction.z);
+	return glm::vec3(pitch, yaw, 0.0f);
+}
@@ -0,0 +1,92 @@
+#ifndef BALLISTICS_H
+#define BALLISTICS_H
+
+#include <glm.hpp>
+
+#include <vector>
+
+using namespace std;
+
+// Fisica comun a todos los proyectiles: gravedad, arrastre cuadratico
+// (a = gravity - drag * |v| * v) y la caja del mundo fuera de la cual
+// desaparecen
+struct BallisticsSettings
+{
+	glm::vec3 gravity;
+	float drag;
+	glm::vec3 worldMin;
+	glm::vec3 worldMax;
+};
+
+// Valores del juego. El piso de la escena queda en worldMin.y
+BallisticsSettings defaultBallistics();
+
+// Proyectiles en estructura de arreglos: posicion, velocidad y vida en
+// arreglos separados, rellenos hasta un multiplo de 8 para integrar de a 8
+// por iteracion (un registro con AVX2, dos con SSE2). Los vivos ocupan
+// [0, Count()); al eliminar uno el ultimo ocupa su lugar, asi que los
+// indices no son estables: 'tag' identifica a cada proyectil para quien lo
+// lanzo.
+class ProjectileSystem
+{
+public:
+
+	ProjectileSystem(const BallisticsSettings& settings);
+
+	void Spawn(glm::vec3 position, glm::vec3 velocity, float lifetime, int tag);
+	void Remove(int index);
+	void Clear();
+
+	// Integra 'deltaTime' segundos (Euler semi-implicito). Los que salen del
+	// mundo o agotan su vida se eliminan y sus tags quedan en 'expired'
+	void Update(float deltaTime, vector<int>& expired);
+
+	// Indice del proyectil con 'tag', -1 si no esta
+	int Find(int tag) const;
+
+	inline int Count() const
+	{
+		return count;
+	};
+
+	inline glm::vec3 Position(int index) const
+	{
+		return glm::vec3(positionX[index], positionY[index], positionZ[index]);
+	};
+
+	inline glm::vec3 Velocity(int index) const
+	{
+		return glm::vec3(velocityX[index], velocityY[index], velocityZ[index]);
+	};
+
+	inline float Life(int index) const
+	{
+		return life[index];
+	};
+
+	inline int Tag(int index) const
+	{
+		return tags[index];
+	};
+
+	inline const BallisticsSettings& Settings() const
+	{
+		return settings;
+	};
+
+private:
+
+	BallisticsSettings settings;
+	int count;
+	vector<float> positionX, positionY, positionZ;
+	vector<float> velocityX, velocityY, velocityZ;
+	vector<float> life;
+	vector<int> tags;
+	vector<int> dead;
+};
+
+// Rotacion (pitch, yaw) que lleva el eje +z de un cilindro a 'direction',
+// con la convencion de Geometry::ModelMatrix
+glm::vec3 orientationAlong(glm::vec3 direction);
+
+#endif
@@ -0,0 +1,946 @@
+#include "Benchmark.h"
+#include "Geometry.h"
+#include "Snapshot.h"
+#include "JobSystem.h"
+#include "Bounds.h"
+#include "Broadphase.h"
+#include "Narrowphase.h"
+#include "Simulation.h"
+#include "Ballistics.h"
+#include "RenderQueue.h"
+#include "ClusteredLighting.h"
+#include "CascadedShadows.h"
+#include "DeferredShading.h"
+#include "DynamicResolution.h"
+#include "Terrain.h"
+#include "Texture.h"
+
+#include <GLFW/glfw3.h>
+
+#include <gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#endif
+
+using namespace std;
+
+// Mismo paso que la simulacion interactiva
+const float benchmarkStep = 1.0f / 60.0f;
+const int benchmarkTargets = 64;
+
+static double elapsedMs(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int runJobBenchmark(int entityCount, int frames)
+{
+	// Escena fija (misma semilla en cada corrida) para comparar entre hilos
+	mt19937 random(1234);
+	uniform_real_distribution<float> spread(-100.0f, 100.0f);
+	uniform_real_distribution<float> speed(-2.0f, 2.0f);
+	uniform_real_distribution<float> angle(0.0f, 6.28f);
+
+	vector<Cube> cubes;
+	cubes.reserve(entityCount);
+	vector<glm::vec3> velocities(entityCount);
+	for (int i = 0; i < entityCount; i++) {
+		cubes.push_back(Cube(1.0f, 1.0f, 1.0f));
+		cubes[i].SetPosition(glm::vec3(spread(random), 0.0f, spread(random)));
+		cubes[i].SetRotation(glm::vec3(0.0f, angle(random), 0.0f));
+		velocities[i] = glm::vec3(speed(random), 0.0f, speed(random));
+	}
+
+	vector<Geometry*> objects;
+	for (Cube& cube : cubes) {
+		objects.push_back(&cube);
+	}
+
+	vector<AABB> targets(benchmarkTargets);
+	for (AABB& target : targets) {
+		glm::vec3 center = glm::vec3(spread(random), 0.0f, spread(random));
+		target.min = center - glm::vec3(2.0f);
+		target.max = center + glm::vec3(2.0f);
+	}
+
+	// Camara sobre la escena mirando en diagonal: parte de los cubos queda fuera
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 30.0f, -60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = extractFrustum(projection * view);
+
+	vector<glm::vec3> startPositions(entityCount);
+	for (int i = 0; i < entityCount; i++) {
+		startPositions[i] = cubes[i].position;
+	}
+
+	int maxThreads = max(1, (int)thread::hardware_concurrency());
+	double baseline = 0.0;
+
+	cout << "Job system benchmark: " << entityCount << " entities, " << frames << " frames" << endl;
+	cout << "threads   update    draw list  commands  collisions  total     speedup" << endl;
+
+	for (int threadCount = 1; threadCount <= maxThreads; threadCount++) {
+		JobSystem jobs(threadCount - 1);
+		FrameSnapshot snapshot;
+		DrawListScratch scratch;
+		vector<DrawItem> drawList;
+		RenderQueue queue(100.0f);
+		vector<int> hits(entityCount);
+
+		for (int i = 0; i < entityCount; i++) {
+			cubes[i].SetPosition(startPositions[i]);
+		}
+
+		double updateMs = 0.0, drawListMs = 0.0, commandsMs = 0.0, collisionMs = 0.0;
+		long long visible = 0, collisions = 0;
+
+		for (int frame = 0; frame < frames; frame++) {
+			// Actualizacion de transformaciones
+			auto start = chrono::steady_clock::now();
+			jobs.ParallelFor(entityCount, 256, [&](int begin, int end) {
+				for (int i = begin; i < end; i++) {
+					cubes[i].SaveState();
+					cubes[i].position += velocities[i] * benchmarkStep;
+					cubes[i].rotation.y += benchmarkStep;
+				}
+			});
+			captureSnapshot(objects, snapshot);
+			updateMs += elapsedMs(start);
+
+			// Matrices, cajas en mundo, culling y lista de dibujo
+			start = chrono::steady_clock::now();
+			buildDrawList(objects, snapshot, 0.5f, frustum, jobs, scratch, drawList);
+			drawListMs += elapsedMs(start);
+			visible += drawList.size();
+
+			// Claves, orden y grabacion de comandos, sin reproducirlos
+			start = chrono::steady_clock::now();
+			queue.Clear();
+			queue.Submit(1, drawList, glm::vec3(0.0f, 30.0f, -60.0f), jobs);
+			queue.Sort();
+			queue.Record(jobs);
+			commandsMs += elapsedMs(start);
+
+			// Colisiones de cada entidad contra los objetivos
+			start = chrono::steady_clock::now();
+			jobs.ParallelFor(entityCount, 256, [&](int begin, int end) {
+				for (int i = begin; i < end; i++) {
+					AABB box = transformBounds(scratch.models[i], cubes[i].size);
+					int count = 0;
+					for (const AABB& target : targets) {
+						count += intersects(box, target);
+					}
+					hits[i] = count;
+				}
+			});
+			for (int count : hits) {
+				collisions += count;
+			}
+			collisionMs += elapsedMs(start);
+		}
+
+		double total = (updateMs + drawListMs + commandsMs + collisionMs) / frames;
+		if (threadCount == 1) {
+			baseline = total;
+		}
+
+		cout << fixed << setprecision(3)
+			<< setw(7) << threadCount
+			<< setw(10) << updateMs / frames
+			<< setw(11) << drawListMs / frames
+			<< setw(10) << commandsMs / frames
+			<< setw(12) << collisionMs / frames
+			<< setw(10) << total
+			<< setw(9) << setprecision(2) << baseline / total << "x"
+			<< "   (" << visible / frames << " visible, " << collisions << " hits)" << endl;
+	}
+
+	return 0;
+}
+
+int runBroadphaseBenchmark(int bodyCount, int frames)
+{
+	// Unos 16 m2 por cuerpo, cajas de 0.5 a 2 de lado
+	float half = sqrt(16.0f * bodyCount) * 0.5f;
+
+	mt19937 random(1234);
+	uniform_real_distribution<float> spread(-half, half);
+	uniform_real_distribution<float> height(0.0f, 4.0f);
+	uniform_real_distribution<float> speed(-4.0f, 4.0f);
+	uniform_real_distribution<float> extent(0.25f, 1.0f);
+
+	vector<glm::vec3> centers(bodyCount);
+	vector<glm::vec3> extents(bodyCount);
+	vector<glm::vec3> velocities(bodyCount);
+	for (int i = 0; i < bodyCount; i++) {
+		centers[i] = glm::vec3(spread(random), height(random), spread(random));
+		extents[i] = glm::vec3(extent(random));
+		velocities[i] = glm::vec3(speed(random), 0.0f, speed(random));
+	}
+
+	SpatialHashGrid grid(4.0f);
+	vector<AABB> boxes(bodyCount);
+	BoxSoA boxesSoA;
+	boxesSoA.Resize(bodyCount);
+	vector<pair<int, int>> candidates;
+	vector<pair<int, int>> pairs;
+
+	double updateMs = 0.0, pairsMs = 0.0, naiveMs = 0.0;
+	long long pairCount = 0, naiveCount = 0;
+	bool naive = bodyCount <= 10000;
+
+	for (int frame = 0; frame < frames; frame++) {
+		for (int i = 0; i < bodyCount; i++) {
+			centers[i] += velocities[i] * benchmarkStep;
+			// Rebote en los bordes para mantener la densidad
+			if (abs(centers[i].x) > half) {
+				velocities[i].x = -velocities[i].x;
+			}
+			if (abs(centers[i].z) > half) {
+				velocities[i].z = -velocities[i].z;
+			}
+			boxes[i].min = centers[i] - extents[i];
+			boxes[i].max = centers[i] + extents[i];
+			boxesSoA.Set(i, boxes[i]);
+		}
+
+		auto start = chrono::steady_clock::now();
+		for (int i = 0; i < bodyCount; i++) {
+			grid.Update(i, boxes[i]);
+		}
+		updateMs += elapsedMs(start);
+
+		start = chrono::steady_clock::now();
+		grid.FindPairs(candidates);
+		overlapPairs(boxesSoA, candidates, pairs);
+		pairsMs += elapsedMs(start);
+		pairCount += pairs.size();
+
+		if (naive) {
+			start = chrono::steady_clock::now();
+			long long count = 0;
+			for (int i = 0; i < bodyCount; i++) {
+				for (int j = i + 1; j < bodyCount; j++) {
+					count += intersects(boxes[i], boxes[j]);
+				}
+			}
+			naiveMs += elapsedMs(start);
+			naiveCount += count;
+		}
+	}
+
+	cout << fixed << setprecision(3)
+		<< "Broadphase benchmark: " << bodyCount << " bodies, " << frames << " frames, "
+		<< grid.CellCount() << " cells" << endl
+		<< "  grid update " << updateMs / frames << " ms, pairs " << pairsMs / frames
+		<< " ms, " << pairCount / frames << " pairs/frame" << endl;
+	if (naive) {
+		cout << "  all pairs   " << naiveMs / frames << " ms, " << naiveCount / frames << " pairs/frame";
+		cout << (naiveCount == pairCount ? "" : "  (MISMATCH)") << endl;
+	}
+
+	return naive && naiveCount != pairCount ? 1 : 0;
+}
+
+int runNarrowphaseBenchmark(int boxCount, int frames)
+{
+	// Objetivos cubicos y proyectiles cilindricos repartidos en un cubo de
+	// lado 100: cada proyectil se prueba contra todos los objetivos
+	mt19937 random(1234);
+	uniform_real_distribution<float> spread(-50.0f, 50.0f);
+	uniform_real_distribution<float> side(0.5f, 8.0f);
+
+	int projectileCount = max(1, boxCount / 10);
+	vector<Cube> targets;
+	vector<Cylinder> projectiles;
+	targets.reserve(boxCount);
+	projectiles.reserve(projectileCount);
+
+	BoxSoA targetBoxes;
+	targetBoxes.Resize(boxCount);
+	for (int i = 0; i < boxCount; i++) {
+		float size = side(random);
+		targets.push_back(Cube(size, size, size));
+		targets[i].SetPosition(glm::vec3(spread(random), spread(random), spread(random)));
+		targetBoxes.Set(i, collisionBounds(targets[i]));
+	}
+	for (int i = 0; i < projectileCount; i++) {
+		projectiles.push_back(Cylinder(0.5f, 4.0f, 8));
+		projectiles[i].SetPosition(glm::vec3(spread(random), spread(random), spread(random)));
+	}
+
+	// Uno contra muchos
+	double scalarMs = 0.0, batchMs = 0.0;
+	long long scalarHits = 0, batchHits = 0;
+	vector<int> hits;
+
+	for (int frame = 0; frame < frames; frame++) {
+		auto start = chrono::steady_clock::now();
+		for (Cylinder& projectile : projectiles) {
+			for (Cube& target : targets) {
+				scalarHits += CheckCollisionProjectile(target, projectile);
+			}
+		}
+		scalarMs += elapsedMs(start);
+
+		start = chrono::steady_clock::now();
+		for (Cylinder& projectile : projectiles) {
+			hits.clear();
+			overlapOneToMany(collisionBounds(projectile), targetBoxes, 0, boxCount, hits);
+			batchHits += hits.size();
+		}
+		batchMs += elapsedMs(start);
+	}
+
+	// Lista de pares candidatos: todos los proyectiles (al final del arreglo)
+	// contra todos los objetivos
+	BoxSoA allBoxes;
+	allBoxes.Resize(boxCount + projectileCount);
+	vector<pair<int, int>> candidates;
+	for (int i = 0; i < boxCount; i++) {
+		allBoxes.Set(i, collisionBounds(targets[i]));
+	}
+	for (int j = 0; j < projectileCount; j++) {
+		allBoxes.Set(boxCount + j, collisionBounds(projectiles[j]));
+		for (int i = 0; i < boxCount; i++) {
+			candidates.push_back(make_pair(i, boxCount + j));
+		}
+	}
+
+	double pairsMs = 0.0;
+	long long pairHits = 0;
+	vector<pair<int, int>> contacts;
+	for (int frame = 0; frame < frames; frame++) {
+		auto start = chrono::steady_clock::now();
+		overlapPairs(allBoxes, candidates, contacts);
+		pairsMs += elapsedMs(start);
+		pairHits += contacts.size();
+	}
+
+	long long tests = (long long)projectileCount * boxCount;
+	cout << fixed << setprecision(3)
+		<< "Narrowphase benchmark: " << projectileCount << " projectiles x " << boxCount << " targets ("
+		<< tests << " tests), " << frames << " frames" << endl
+		<< "  scalar CheckCollisionProjectile " << scalarMs / frames << " ms, " << scalarHits / frames << " hits" << endl
+		<< "  batched one-to-many            " << batchMs / frames << " ms, " << batchHits / frames << " hits" << endl
+		<< "  batched candidate pairs        " << pairsMs / frames << " ms, " << pairHits / frames << " hits" << endl;
+
+	bool match = scalarHits == batchHits && scalarHits == pairHits;
+	if (!match) {
+		cout << "  MISMATCH" << endl;
+	}
+	return match ? 0 : 1;
+}
+
+int runBallisticsBenchmark(int projectileCount, int steps)
+{
+	// Mundo sin limites para que ninguno desaparezca y ambos recorridos
+	// hagan el mismo trabajo
+	BallisticsSettings settings = defaultBallistics();
+	settings.worldMin = glm::vec3(-1e9f);
+	settings.worldMax = glm::vec3(1e9f);
+
+	struct ScalarProjectile
+	{
+		glm::vec3 position;
+		glm::vec3 velocity;
+		float life;
+	};
+
+	mt19937 random(1234);
+	uniform_real_distribution<float> spread(-100.0f, 100.0f);
+	uniform_real_distribution<float> speed(-30.0f, 30.0f);
+
+	ProjectileSystem system(settings);
+	vector<ScalarProjectile> scalar(projectileCount);
+	for (ScalarProjectile& projectile : scalar) {
+		float x = spread(random), y = spread(random), z = spread(random);
+		float vx = speed(random), vy = speed(random), vz = speed(random);
+		projectile = { glm::vec3(x, y, z), glm::vec3(vx, vy, vz), 1e9f };
+		system.Spawn(projectile.position, projectile.velocity, projectile.life, 0);
+	}
+
+	vector<int> expired;
+	double scalarMs = 0.0, batchMs = 0.0;
+	for (int step = 0; step < steps; step++) {
+		auto start = chrono::steady_clock::now();
+		for (ScalarProjectile& projectile : scalar) {
+			glm::vec3 acceleration = settings.gravity - settings.drag * glm::length(projectile.velocity) * projectile.velocity;
+			projectile.velocity += acceleration * benchmarkStep;
+			projectile.position += projectile.velocity * benchmarkStep;
+			projectile.life -= benchmarkStep;
+		}
+		scalarMs += elapsedMs(start);
+
+		start = chrono::steady_clock::now();
+		system.Update(benchmarkStep, expired);
+		batchMs += elapsedMs(start);
+	}
+
+	// Mismas cuentas en otro orden: solo difieren por redondeo
+	float maxError = 0.0f;
+	for (int i = 0; i < projectileCount; i++) {
+		maxError = max(maxError, glm::length(system.Position(i) - scalar[i].position));
+	}
+
+	double updates = (double)projectileCount * steps;
+	cout << fixed << setprecision(3)
+		<< "Ballistics benchmark: " << projectileCount << " projectiles, " << steps << " steps" << endl
+		<< "  scalar AoS loop  " << scalarMs / steps << " ms/step, " << setprecision(0) << updates / scalarMs << " updates/ms" << endl
+		<< setprecision(3)
+		<< "  SoA 8-wide       " << batchMs / steps << " ms/step, " << setprecision(0) << updates / batchMs << " updates/ms" << endl
+		<< setprecision(6) << "  max position difference " << maxError << endl;
+
+	bool match = expired.empty() && system.Count() == projectileCount && maxError < 1e-2f;
+	if (!match) {
+		cout << "  MISMATCH" << endl;
+	}
+	return match ? 0 : 1;
+}
+
+int runRenderQueueBenchmark(int objectCount, int frames)
+{
+	// Escena tipica: pocos programas y materiales, mallas repetidas y
+	// profundidades al azar, encoladas en el orden de la foto
+	mt19937 random(1234);
+	uniform_int_distribution<unsigned int> program(1, 3);
+	uniform_int_distribution<unsigned int> material(0, LAYER_COUNT - 1);
+	uniform_int_distribution<unsigned int> mesh(1, 64);
+	uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+	vector<SortKey> submitted(objectCount);
+	for (SortKey& key : submitted) {
+		unsigned int p = program(random), m = material(random), v = mesh(random);
+		key = makeSortKey(PASS_OPAQUE, p, m, v, depth(random));
+	}
+
+	vector<SortKey> keys, keyScratch, reference;
+	vector<unsigned int> values, valueScratch;
+	vector<pair<SortKey, unsigned int>> pairs(objectCount);
+	double radixMs = 0.0, stdMs = 0.0;
+	for (int frame = 0; frame < frames; frame++) {
+		keys = submitted;
+		values.resize(objectCount);
+		for (int i = 0; i < objectCount; i++) {
+			values[i] = i;
+			pairs[i] = { submitted[i], (unsigned int)i };
+		}
+
+		auto start = chrono::steady_clock::now();
+		radixSort(keys, values, keyScratch, valueScratch);
+		radixMs += elapsedMs(start);
+
+		start = chrono::steady_clock::now();
+		stable_sort(pairs.begin(), pairs.end(), [](const pair<SortKey, unsigned int>& a, const pair<SortKey, unsigned int>& b) {
+			return a.first < b.first;
+		});
+		stdMs += elapsedMs(start);
+	}
+
+	// Ambos son estables: deben dar exactamente el mismo orden
+	bool match = true;
+	for (int i = 0; i < objectCount; i++) {
+		match = match && keys[i] == pairs[i].first && values[i] == pairs[i].second;
+	}
+
+	RenderStats before = countStateChanges(submitted);
+	RenderStats after = countStateChanges(keys);
+	cout << fixed << setprecision(3)
+		<< "Render queue benchmark: " << objectCount << " draws, " << frames << " frames" << endl
+		<< "  radix sort       " << radixMs / frames << " ms/frame" << endl
+		<< "  std::stable_sort " << stdMs / frames << " ms/frame" << endl
+		<< "  state changes    program/material/mesh" << endl
+		<< "    submit order   " << before.programChanges << " / " << before.materialChanges << " / " << before.meshChanges << endl
+		<< "    sorted         " << after.programChanges << " / " << after.materialChanges << " / " << after.meshChanges << endl;
+	if (!match) {
+		cout << "  MISMATCH" << endl;
+	}
+	return match ? 0 : 1;
+}
+
+int runLightBinningBenchmark(int lightCount, int frames)
+{
+	mt19937 random(1234);
+	uniform_real_distribution<float> lateral(-60.0f, 60.0f);
+	uniform_real_distribution<float> ahead(1.0f, 150.0f);
+	uniform_real_distribution<float> radius(2.0f, 20.0f);
+	uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	ClusteredLighting lighting(0.1f, 1000.0f);
+	for (int i = 0; i < lightCount; i++) {
+		Light light;
+		float x = lateral(random), y = lateral(random) * 0.25f, z = ahead(random);
+		light.position = glm::vec3(x, y, z);
+		light.radius = radius(random);
+		light.color = glm::vec3(1.0f);
+		// Un cuarto son spots
+		light.spotCos = i % 4 == 0 ? 0.8f : -1.0f;
+		float dx = unit(random), dy = unit(random), dz = unit(random);
+		light.direction = glm::normalize(glm::vec3(dx, dy, dz) + glm::vec3(0.0f, 0.0f, 1e-3f));
+		lighting.AddLight(light);
+	}
+
+	// Camara en el origen mirando hacia +z, como la del juego al empezar
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	JobSystem jobs(max(0, (int)thread::hardware_concurrency() - 1));
+	double buildMs = 0.0;
+	for (int frame = 0; frame < frames; frame++) {
+		auto start = chrono::steady_clock::now();
+		lighting.Build(view, projection, jobs);
+		buildMs += elapsedMs(start);
+	}
+
+	cout << fixed << setprecision(3)
+		<< "Light binning benchmark: " << lightCount << " lights, " << clusterCount << " froxels, "
+		<< jobs.ThreadCount() << " threads" << endl
+		<< "  build            " << buildMs / frames << " ms/frame" << endl
+		<< "  light indices    " << lighting.IndexCount() << " (" << setprecision(2)
+		<< (double)lighting.IndexCount() / clusterCount << " per froxel, at most " << maxLightsPerCluster << ")" << endl;
+	return 0;
+}
+
+int runDeferredBenchmark(int frames)
+{
+	const int width = 1280, height = 720;
+	const int warmup = 10;
+	const float nearPlane = 0.1f, farPlane = 1000.0f;
+
+	// Contexto en una ventana oculta; sirve tambien un render por software
+	if (!glfwInit()) {
+		cout << "Deferred benchmark: glfwInit failed" << endl;
+		return EXIT_FAILURE;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(width, height, "Deferred benchmark", NULL, NULL);
+	if (!window) {
+		cout << "Deferred benchmark: no OpenGL context" << endl;
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(0);
+	if (glewInit() != GLEW_OK) {
+		cout << "Deferred benchmark: glewInit failed" << endl;
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
+	glEnable(GL_DEPTH_TEST);
+
+	{
+		// Materiales de un solo texel, un color por capa
+		unsigned char colors[LAYER_COUNT * 4];
+		for (int layer = 0; layer < LAYER_COUNT; layer++) {
+			colors[layer * 4 + 0] = (unsigned char)(90 + 60 * layer);
+			colors[layer * 4 + 1] = (unsigned char)(160 - 30 * layer);
+			colors[layer * 4 + 2] = 120;
+			colors[layer * 4 + 3] = 255;
+		}
+		unsigned int materials;
+		glGenTextures(1, &materials);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, materials);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 1, 1, LAYER_COUNT, 0, GL_RGBA, GL_UNSIGNED_BYTE, colors);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		// Filas de cubos y esferas que se tapan entre si delante de la
+		// camara, sobre un terreno
+		Heightmap heightmap;
+		heightmap.Generate(257, 1.0f, -1.0f, 4.0f, 1234);
+		const int rows = 40, columns = 21;
+		vector<Cube> cubes;
+		vector<Sphere> spheres;
+		cubes.reserve(rows * columns);
+		spheres.reserve(rows * columns);
+		vector<Geometry*> objects;
+		for (int row = 0; row < rows; row++) {
+			for (int column = -columns / 2; column <= columns / 2; column++) {
+				Geometry* object;
+				if ((row + column) % 2) {
+					cubes.push_back(Cube(2.0f, 2.0f, 2.0f));
+					object = &cubes.back();
+				}
+				else {
+					spheres.push_back(Sphere(1.2f, 36, 18, true));
+					object = &spheres.back();
+				}
+				object->SetPosition(glm::vec3(column * 3.0f, 1.0f + (row % 3), 6.0f + row * 3.0f));
+				object->SetRotation(glm::vec3(0.0f, row * 17.0f + column * 5.0f, 0.0f));
+				object->SetLayer((row * columns + column + columns / 2) % LAYER_COUNT);
+				object->SetupGL();
+				objects.push_back(object);
+			}
+		}
+		FrameSnapshot snapshot;
+		captureSnapshot(objects, snapshot);
+		vector<DrawItem> drawList;
+		for (Geometry* object : objects) {
+			DrawItem item = { object, object->ModelMatrix(object->position, object->rotation), object->layer };
+			drawList.push_back(item);
+		}
+
+		glm::vec3 eye = glm::vec3(0.0f, 4.0f, 0.0f);
+		glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f, 1.0f, 40.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / height, nearPlane, farPlane);
+		Frustum frustum = extractFrustum(projection * view);
+
+		Shader forwardShader("src/Shaders/VertexShader.vs", "src/Shaders/FragmentShader.fs");
+		Shader gbufferShader("src/Shaders/VertexShader.vs", "src/Shaders/GBufferFragmentShader.fs");
+		Terrain forwardTerrain(heightmap);
+		Terrain gbufferTerrain(heightmap, "src/Shaders/GBufferFragmentShader.fs");
+		for (Shader* shader : { &forwardShader, &gbufferShader }) {
+			shader->use();
+			shader->setInt("materials", 0);
+			shader->setMat4("view", view);
+			shader->setMat4("projection", projection);
+		}
+
+		// La escena va a un framebuffer propio a escala 1, como en el juego
+		ResolutionSettings settings = { 1000.0, 1.0f, 1.0f, 1.0f, 0.0f };
+		DynamicResolution resolution(width, height, settings);
+		DeferredShading deferred(width, height);
+		ClusteredLighting lighting(nearPlane, farPlane);
+		CascadedShadows shadows(nearPlane);
+		JobSystem jobs(max(0, (int)thread::hardware_concurrency() - 1));
+		RenderQueue queue(farPlane);
+
+		unsigned int timestamps[2];
+		glGenQueries(2, timestamps);
+
+		cout << fixed << setprecision(3)
+			<< "Deferred shading benchmark: " << width << "x" << height << ", " << objects.size()
+			<< " objects and terrain, " << frames << " frames" << endl
+			<< "  lights   forward ms   deferred ms   light indices" << endl;
+
+		mt19937 random(1234);
+		uniform_real_distribution<float> lateral(-30.0f, 30.0f);
+		uniform_real_distribution<float> above(0.5f, 6.0f);
+		uniform_real_distribution<float> ahead(4.0f, 125.0f);
+		uniform_real_distribution<float> radius(4.0f, 10.0f);
+		uniform_real_distribution<float> channel(0.2f, 1.0f);
+		for (int lightCount : { 0, 64, 256, 1024 }) {
+			lighting.Clear();
+			for (int i = 0; i < lightCount; i++) {
+				Light light;
+				float x = lateral(random), y = above(random), z = ahead(random);
+				light.position = glm::vec3(x, y, z);
+				light.radius = radius(random);
+				float r = channel(random), g = channel(random), b = channel(random);
+				light.color = glm::vec3(r, g, b) * 4.0f;
+				light.spotCos = -1.0f;
+				light.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+				lighting.AddLight(light);
+			}
+
+			double gpuMs[2] = { 0.0, 0.0 };
+			for (int path = 0; path < 2; path++) {
+				bool useDeferred = path == 1;
+				Shader& shader = useDeferred ? gbufferShader : forwardShader;
+				Terrain& terrain = useDeferred ? gbufferTerrain : forwardTerrain;
+				const Shader& lit = useDeferred ? deferred.GetLightingShader() : shader;
+
+				for (int frame = 0; frame < warmup + frames; frame++) {
+					resolution.BeginScene();
+					lighting.Build(view, projection, jobs);
+					lighting.Upload();
+					shadows.Fit(view, projection);
+					shadows.SelectCasters(objects, snapshot, 1.0f, jobs);
+					shadows.Render(terrain);
+					for (const Shader* program : { &lit, &terrain.GetShader() }) {
+						lighting.Apply(*program, glm::vec2(width, height));
+						shadows.Apply(*program);
+					}
+
+					queue.Clear();
+					queue.Submit(shader.ID, drawList, eye, jobs);
+					queue.Submit(PASS_TERRAIN, 0, [&]() {
+						terrain.Draw(view, projection, eye, frustum, materials);
+					});
+					if (useDeferred) {
+						queue.Submit(PASS_LIGHTING, 0, [&]() {
+							deferred.Resolve(view, projection);
+						});
+					}
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D_ARRAY, materials);
+
+					// Se mide solo la escena: objetos, terreno y luces
+					glQueryCounter(timestamps[0], GL_TIMESTAMP);
+					if (useDeferred) {
+						deferred.BeginGeometry();
+					}
+					queue.Sort();
+					queue.Execute(jobs);
+					glQueryCounter(timestamps[1], GL_TIMESTAMP);
+					resolution.EndScene();
+
+					GLuint64 begin = 0, end = 0;
+					glGetQueryObjectui64v(timestamps[0], GL_QUERY_RESULT, &begin);
+					glGetQueryObjectui64v(timestamps[1], GL_QUERY_RESULT, &end);
+					if (frame >= warmup) {
+						gpuMs[path] += (double)(end - begin) / 1.0e6;
+					}
+				}
+			}
+
+			cout << "  " << setw(6) << lightCount << "   " << setw(10) << gpuMs[0] / frames
+				<< "   " << setw(11) << gpuMs[1] / frames << "   " << setw(13) << lighting.IndexCount() << endl;
+		}
+
+		glDeleteQueries(2, timestamps);
+		glDeleteTextures(1, &materials);
+		for (Geometry* object : objects) {
+			object->CleanGL();
+		}
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
+
+// Memoria residente del proceso y su maximo, en bytes. Devuelve false si la
+// plataforma no la informa
+static bool processMemory(size_t& current, size_t& peak)
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return false;
+	}
+	current = counters.WorkingSetSize;
+	peak = counters.PeakWorkingSetSize;
+	return true;
+#else
+	ifstream status("/proc/self/status");
+	string line;
+	current = peak = 0;
+	while (getline(status, line)) {
+		if (line.compare(0, 6, "VmRSS:") == 0) {
+			current = stoull(line.substr(6)) * 1024;
+		}
+		else if (line.compare(0, 6, "VmHWM:") == 0) {
+			peak = stoull(line.substr(6)) * 1024;
+		}
+	}
+	return current > 0;
+#endif
+}
+
+// Muestras de una etapa, un valor por frame
+struct StageSamples
+{
+	const char* name;
+	vector<double> values = {};
+};
+
+static void writeStage(ostream& out, StageSamples& stage, bool last)
+{
+	vector<double>& values = stage.values;
+	sort(values.begin(), values.end());
+
+	double sum = 0.0;
+	for (double value : values) {
+		sum += value;
+	}
+	size_t count = values.size();
+	double mean = count ? sum / count : 0.0;
+	double p50 = count ? values[count / 2] : 0.0;
+	double p95 = count ? values[min(count - 1, count * 95 / 100)] : 0.0;
+	double worst = count ? values.back() : 0.0;
+
+	out << "    \"" << stage.name << "\": { \"mean\": " << mean << ", \"p50\": " << p50
+		<< ", \"p95\": " << p95 << ", \"max\": " << worst << ", \"total\": " << sum << " }"
+		<< (last ? "" : ",") << endl;
+}
+
+// Input aleatorio que se mantiene unos cuantos pasos, para que los tanques
+// recorran distancias apreciables en lugar de temblar en el lugar
+static TankInput randomInput(mt19937& random)
+{
+	uniform_int_distribution<int> coin(0, 3);
+	TankInput input = {};
+	int motion = coin(random);
+	input.forward = motion == 0 || motion == 1;
+	input.backwards = motion == 2;
+	int turn = coin(random);
+	input.bodyLeft = turn == 0;
+	input.bodyRight = turn == 1;
+	input.canonLeft = coin(random) == 0;
+	input.canonRight = coin(random) == 0;
+	input.fire = coin(random) == 0;
+	return input;
+}
+
+int runScenario(const ScenarioConfig& config)
+{
+	mt19937 random(config.seed);
+
+	// La arena crece con la cantidad de cuerpos para mantener la densidad
+	float arena = max(40.0f, sqrtf((float)(config.tankCount + config.targetCount)) * 6.0f);
+	uniform_real_distribution<float> spread(-arena, arena);
+	uniform_real_distribution<float> side(1.0f, 3.0f);
+	uniform_real_distribution<float> angle(0.0f, 6.28f);
+	uniform_real_distribution<float> drift(-0.3f, 0.3f);
+	uniform_real_distribution<float> elevation(0.2f, 0.8f);
+	uniform_int_distribution<int> hold(10, 90);
+
+	Simulation simulation(benchmarkStep);
+
+	vector<Tank> tanks(config.tankCount);
+	for (Tank& tank : tanks) {
+		tank.Translate(glm::vec3(spread(random), 0.0f, spread(random)));
+		simulation.AddTank(tank);
+	}
+
+	vector<Cube> targets;
+	targets.reserve(config.targetCount);
+	for (int i = 0; i < config.targetCount; i++) {
+		float size = side(random);
+		targets.push_back(Cube(size, size, size));
+		targets[i].SetPosition(glm::vec3(spread(random), 0.0f, spread(random)));
+		targets[i].SetRotation(glm::vec3(0.0f, angle(random), 0.0f));
+		simulation.AddTarget(targets[i]);
+	}
+
+	// Los proyectiles sueltos salen hacia +z en parabola, como los de los
+	// tanques, con algo de desvio lateral
+	vector<Cylinder> projectiles;
+	projectiles.reserve(config.projectileCount);
+	auto launch = [&](int i, float z) {
+		float lateral = drift(random);
+		float up = elevation(random);
+		float x = spread(random);
+		simulation.LaunchProjectile(i, glm::vec3(x, 0.0f, z), glm::vec3(lateral, up, 1.0f) * muzzleSpeed * 0.5f);
+	};
+	for (int i = 0; i < config.projectileCount; i++) {
+		projectiles.push_back(Cylinder(0.1f, 1.0f, 8));
+		simulation.AddProjectile(projectiles[i]);
+		launch(i, spread(random));
+	}
+
+	vector<TankInput> inputs(config.tankCount);
+	vector<int> holdSteps(config.tankCount, 0);
+
+	JobSystem jobs(max(0, (int)thread::hardware_concurrency() - 1));
+	FrameSnapshot snapshot;
+	DrawListScratch scratch;
+	vector<DrawItem> drawList;
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 30.0f, -60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = extractFrustum(projection * view);
+
+	StageSamples stages[] = {
+		{ "input" }, { "movement" }, { "broadphase" }, { "narrowphase" }, { "resolve" },
+		{ "snapshot" }, { "drawList" }, { "frame" }
+	};
+	const int stageCount = sizeof(stages) / sizeof(stages[0]);
+	for (StageSamples& stage : stages) {
+		stage.values.reserve(config.frames);
+	}
+
+	long long respawns = 0, drawn = 0;
+	size_t startMemory = 0, peakMemory = 0, endMemory = 0;
+	processMemory(startMemory, peakMemory);
+
+	for (int frame = 0; frame < config.frames; frame++) {
+		auto frameStart = chrono::steady_clock::now();
+
+		// Se reponen los objetivos y proyectiles que desaparecieron para que
+		// la carga no decaiga a lo largo de la corrida
+		auto start = chrono::steady_clock::now();
+		for (int i = 0; i < config.tankCount; i++) {
+			if (--holdSteps[i] <= 0) {
+				inputs[i] = randomInput(random);
+				holdSteps[i] = hold(random);
+			}
+			else {
+				inputs[i].fire = false;
+			}
+		}
+		for (Cube& target : targets) {
+			if (!target.visible) {
+				target.SetPosition(glm::vec3(spread(random), 0.0f, spread(random)));
+				target.visible = true;
+				respawns++;
+			}
+		}
+		for (int i = 0; i < config.projectileCount; i++) {
+			if (!projectiles[i].visible) {
+				launch(i, spread(random) * 0.5f - arena * 0.5f);
+				respawns++;
+			}
+		}
+		stages[0].values.push_back(elapsedMs(start));
+
+		simulation.Step(inputs);
+		const Simulation::StepTimings& timings = simulation.LastTimings();
+		stages[1].values.push_back(timings.movement);
+		stages[2].values.push_back(timings.broadphase);
+		stages[3].values.push_back(timings.narrowphase);
+		stages[4].values.push_back(timings.resolve);
+
+		start = chrono::steady_clock::now();
+		simulation.Capture(snapshot);
+		stages[5].values.push_back(elapsedMs(start));
+
+		start = chrono::steady_clock::now();
+		buildDrawList(simulation.Objects(), snapshot, 0.5f, frustum, jobs, scratch, drawList);
+		stages[6].values.push_back(elapsedMs(start));
+		drawn += drawList.size();
+
+		stages[7].values.push_back(elapsedMs(frameStart));
+	}
+
+	bool hasMemory = processMemory(endMemory, peakMemory);
+
+	ofstream out(config.outputPath);
+	if (!out) {
+		cout << "Scenario: could not write " << config.outputPath << endl;
+		return 1;
+	}
+
+	out << fixed << setprecision(4)
+		<< "{" << endl
+		<< "  \"scenario\": { \"tanks\": " << config.tankCount << ", \"targets\": " << config.targetCount
+		<< ", \"projectiles\": " << config.projectileCount << ", \"frames\": " << config.frames
+		<< ", \"seed\": " << config.seed << ", \"threads\": " << jobs.ThreadCount() << " }," << endl
+		<< "  \"objects\": " << simulation.Objects().size() << "," << endl
+		<< "  \"drawnPerFrame\": " << (config.frames ? (double)drawn / config.frames : 0.0) << "," << endl
+		<< "  \"respawns\": " << respawns << "," << endl
+		<< "  \"broadphaseCells\": " << simulation.BroadphaseCells() << "," << endl
+		<< "  \"stagesMs\": {" << endl;
+	for (int i = 0; i < stageCount; i++) {
+		writeStage(out, stages[i], i == stageCount - 1);
+	}
+	out << "  }," << endl;
+	if (hasMemory) {
+		out << "  \"memoryBytes\": { \"start\": " << startMemory << ", \"end\": " << endMemory
+			<< ", \"peak\": " << peakMemory << " }" << endl;
+	}
+	else {
+		out << "  \"memoryBytes\": null" << endl;
+	}
+	out << "}" << endl;
+
+	// writeStage dejo las muestras ordenadas
+	const vector<double>& frameTimes = stages[stageCount - 1].values;
+	cout << fixed << setprecision(3)
+		<< "Scenario: " << config.tankCount << " tanks, " << config.targetCount << " targets, "
+		<< config.projectileCount << " projectiles, " << config.frames << " frames, "
+		<< (frameTimes.empty() ? 0.0 : frameTimes[frameTimes.size() / 2]) << " ms/frame (p50) -> "
+		<< config.outputPath << endl;
+	return 0;
+}
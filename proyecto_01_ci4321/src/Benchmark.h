@@ -0,0 +1,54 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Escalado del JobSystem: simula una escena de 'entityCount' cubos durante
+// 'frames' frames con 1..N hilos y muestra el tiempo medio de cada etapa.
+// No abre ventana ni contexto de GL
+int runJobBenchmark(int entityCount, int frames);
+
+// Broadphase con 'bodyCount' cuerpos en movimiento a densidad constante:
+// tiempo de actualizacion de la grilla y de busqueda de pares. Hasta 10k
+// cuerpos tambien mide la prueba de todos contra todos
+int runBroadphaseBenchmark(int bodyCount, int frames);
+
+// Prueba de cajas por lotes (SoA/SIMD) contra CheckCollisionProjectile, de
+// uno contra muchos y sobre una lista de pares candidatos
+int runNarrowphaseBenchmark(int boxCount, int frames);
+
+// Integracion de 'projectileCount' proyectiles durante 'steps' pasos: el
+// kernel SoA de ProjectileSystem contra un bucle escalar sobre estructuras,
+// en actualizaciones por milisegundo de un solo nucleo
+int runBallisticsBenchmark(int projectileCount, int steps);
+
+// Orden de la cola de dibujo con 'objectCount' claves al azar: radix sort
+// contra std::stable_sort y cambios de estado antes y despues de ordenar
+int runRenderQueueBenchmark(int objectCount, int frames);
+
+// Reparto de 'lightCount' luces puntuales y spots al azar frente a la
+// camara entre los froxels de ClusteredLighting: tiempo por frame con todos
+// los hilos y luces por froxel
+int runLightBinningBenchmark(int lightCount, int frames);
+
+// Camino forward contra diferido con 0 a 1024 luces sobre filas de objetos
+// que se tapan entre si: tiempo de GPU de la escena (objetos, terreno y
+// luces) medido con timestamps. Abre una ventana oculta y necesita OpenGL
+int runDeferredBenchmark(int frames);
+
+// Escenario de carga: 'tankCount' tanques con input aleatorio, 'targetCount'
+// objetivos y 'projectileCount' proyectiles sueltos, todos generados con
+// 'seed'. Corre 'frames' pasos de la simulacion real mas la preparacion del
+// frame (foto y lista de dibujo) y escribe en 'outputPath' un JSON con el
+// tiempo de cada etapa y la memoria del proceso
+struct ScenarioConfig
+{
+	int tankCount;
+	int targetCount;
+	int projectileCount;
+	int frames;
+	unsigned int seed;
+	const char* outputPath;
+};
+
+int runScenario(const ScenarioConfig& config);
+
+#endif
@@ -0,0 +1,73 @@
+#include "Bounds.h"
+
+AABB transformBounds(const glm::mat4& model, glm::vec3 size)
+{
+	// El centro se transforma como punto y la extension con el valor
+	// absoluto de la parte lineal de la matriz (Arvo)
+	glm::vec3 center = glm::vec3(model[3]);
+	glm::vec3 halfSize = size * 0.5f;
+	glm::vec3 extent = glm::abs(glm::vec3(model[0])) * halfSize.x
+		+ glm::abs(glm::vec3(model[1])) * halfSize.y
+		+ glm::abs(glm::vec3(model[2])) * halfSize.z;
+
+	AABB box;
+	box.min = center - extent;
+	box.max = center + extent;
+	return box;
+}
+
+OBB transformOrientedBounds(const glm::mat4& model, glm::vec3 size)
+{
+	OBB box;
+	box.center = glm::vec3(model[3]);
+	for (int i = 0; i < 3; i++) {
+		glm::vec3 axis = glm::vec3(model[i]);
+		float length = glm::length(axis);
+		box.axes[i] = length > 0.0f ? axis / length : glm::vec3(0.0f);
+		box.halfSize[i] = size[i] * 0.5f * length;
+	}
+	return box;
+}
+
+Frustum extractFrustum(const glm::mat4& viewProjection)
+{
+	// Gribb-Hartmann: cada plano es la cuarta fila mas o menos otra fila
+	glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	Frustum frustum;
+	frustum.planes[0] = row3 + row0; // izquierdo
+	frustum.planes[1] = row3 - row0; // derecho
+	frustum.planes[2] = row3 + row1; // inferior
+	frustum.planes[3] = row3 - row1; // superior
+	frustum.planes[4] = row3 + row2; // cercano
+	frustum.planes[5] = row3 - row2; // lejano
+	return frustum;
+}
+
+bool intersects(const Frustum& frustum, const AABB& box)
+{
+	for (int i = 0; i < 6; i++) {
+		const glm::vec4& plane = frustum.planes[i];
+
+		// Vertice de la caja mas adentro segun la normal del plano
+		glm::vec3 inner;
+		inner.x = plane.x >= 0.0f ? box.max.x : box.min.x;
+		inner.y = plane.y >= 0.0f ? box.max.y : box.min.y;
+		inner.z = plane.z >= 0.0f ? box.max.z : box.min.z;
+
+		if (glm::dot(glm::vec3(plane), inner) + plane.w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool intersects(const AABB& one, const AABB& two)
+{
+	return one.min.x <= two.max.x && two.min.x <= one.max.x
+		&& one.min.y <= two.max.y && two.min.y <= one.max.y
+		&& one.min.z <= two.max.z && two.min.z <= one.max.z;
+}
@@ -0,0 +1,43 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <glm.hpp>
+
+// Caja alineada a los ejes en coordenadas de mundo
+struct AABB
+{
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// Caja orientada: centro, ejes unitarios en mundo y semiextension en cada eje
+struct OBB
+{
+	glm::vec3 center;
+	glm::vec3 axes[3];
+	glm::vec3 halfSize;
+};
+
+// Planos del frustum (a, b, c, d) con la normal hacia adentro
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+// Caja en mundo que envuelve una caja local centrada en el origen de lado
+// 'size' (ver Geometry::size) una vez transformada por 'model'
+AABB transformBounds(const glm::mat4& model, glm::vec3 size);
+
+// Caja orientada de una caja local centrada de lado 'size' transformada por
+// 'model' (la escala de la matriz pasa a la semiextension)
+OBB transformOrientedBounds(const glm::mat4& model, glm::vec3 size);
+
+// Extrae los planos de la matriz projection * view
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// false solo si la caja queda completamente fuera de algun plano
+bool intersects(const Frustum& frustum, const AABB& box);
+
+bool intersects(const AABB& one, const AABB& two);
+
+#endif
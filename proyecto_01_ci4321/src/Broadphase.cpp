@@ -0,0 +1,119 @@
+#include "Broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+{
+	inverseCellSize = 1.0f / cellSize;
+}
+
+uint64_t SpatialHashGrid::Key(int x, int y, int z)
+{
+	// 21 bits por eje alcanzan para +-1 millon de celdas
+	const uint64_t mask = (1 << 21) - 1;
+	return ((uint64_t)(x + (1 << 20)) & mask) << 42
+		| ((uint64_t)(y + (1 << 20)) & mask) << 21
+		| ((uint64_t)(z + (1 << 20)) & mask);
+}
+
+SpatialHashGrid::CellRange SpatialHashGrid::RangeOf(const AABB& box) const
+{
+	CellRange range;
+	range.min = glm::ivec3(glm::floor(box.min * inverseCellSize));
+	range.max = glm::ivec3(glm::floor(box.max * inverseCellSize));
+	return range;
+}
+
+void SpatialHashGrid::Insert(int id, const CellRange& range)
+{
+	for (int x = range.min.x; x <= range.max.x; x++) {
+		for (int y = range.min.y; y <= range.max.y; y++) {
+			for (int z = range.min.z; z <= range.max.z; z++) {
+				Cell& cell = cells[Key(x, y, z)];
+				cell.coord = glm::ivec3(x, y, z);
+				cell.bodies.push_back(id);
+			}
+		}
+	}
+}
+
+void SpatialHashGrid::Erase(int id, const CellRange& range)
+{
+	for (int x = range.min.x; x <= range.max.x; x++) {
+		for (int y = range.min.y; y <= range.max.y; y++) {
+			for (int z = range.min.z; z <= range.max.z; z++) {
+				auto found = cells.find(Key(x, y, z));
+				if (found == cells.end()) {
+					continue;
+				}
+
+				vector<int>& list = found->second.bodies;
+				auto position = std::find(list.begin(), list.end(), id);
+				if (position != list.end()) {
+					*position = list.back();
+					list.pop_back();
+				}
+				if (list.empty()) {
+					cells.erase(found);
+				}
+			}
+		}
+	}
+}
+
+void SpatialHashGrid::Update(int id, const AABB& box)
+{
+	if (id >= (int)bodies.size()) {
+		bodies.resize(id + 1);
+	}
+
+	Body& body = bodies[id];
+	CellRange range = RangeOf(box);
+
+	if (body.inGrid && range.min == body.range.min && range.max == body.range.max) {
+		return;
+	}
+
+	if (body.inGrid) {
+		Erase(id, body.range);
+	}
+	Insert(id, range);
+	body.range = range;
+	body.inGrid = true;
+}
+
+void SpatialHashGrid::Remove(int id)
+{
+	if (id >= (int)bodies.size() || !bodies[id].inGrid) {
+		return;
+	}
+	Erase(id, bodies[id].range);
+	bodies[id].inGrid = false;
+}
+
+void SpatialHashGrid::FindPairs(vector<pair<int, int>>& pairs) const
+{
+	pairs.clear();
+
+	for (const auto& entry : cells) {
+		const Cell& cell = entry.second;
+		const vector<int>& list = cell.bodies;
+
+		for (size_t i = 0; i < list.size(); i++) {
+			const Body& one = bodies[list[i]];
+
+			for (size_t j = i + 1; j < list.size(); j++) {
+				const Body& two = bodies[list[j]];
+
+				// Dos cuerpos pueden compartir varias celdas; el par solo se
+				// reporta en la primera celda de la interseccion de sus rangos
+				if (glm::max(one.range.min, two.range.min) != cell.coord) {
+					continue;
+				}
+
+				pairs.push_back(make_pair(min(list[i], list[j]), max(list[i], list[j])));
+			}
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "Bounds.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Broadphase de colisiones con una grilla uniforme dispersa (hash de celdas).
+// Cada cuerpo se registra en todas las celdas que toca su AABB; solo los
+// cuerpos que comparten celda se comparan. La grilla se actualiza de forma
+// incremental: un cuerpo que se mueve sin cambiar de rango de celdas no toca
+// la tabla. Los ids son indices pequennos elegidos por quien la usa.
+class SpatialHashGrid
+{
+public:
+
+	// 'cellSize' deberia rondar el tamanno tipico de los cuerpos
+	SpatialHashGrid(float cellSize);
+
+	// Inserta el cuerpo o actualiza su caja
+	void Update(int id, const AABB& box);
+	void Remove(int id);
+
+	// Pares candidatos (a < b) que comparten al menos una celda, cada uno una
+	// sola vez. Es la entrada de la narrowphase (overlapPairs)
+	void FindPairs(vector<pair<int, int>>& pairs) const;
+
+	inline size_t CellCount() const
+	{
+		return cells.size();
+	};
+
+private:
+
+	struct CellRange
+	{
+		glm::ivec3 min;
+		glm::ivec3 max;
+	};
+
+	struct Body
+	{
+		CellRange range;
+		bool inGrid = false;
+	};
+
+	struct Cell
+	{
+		glm::ivec3 coord;
+		vector<int> bodies;
+	};
+
+	CellRange RangeOf(const AABB& box) const;
+	void Insert(int id, const CellRange& range);
+	void Erase(int id, const CellRange& range);
+	static uint64_t Key(int x, int y, int z);
+
+	float inverseCellSize;
+	vector<Body> bodies;
+	unordered_map<uint64_t, Cell> cells;
+};
+
+#endif
@@ -0,0 +1,332 @@
+#include "CascadedShadows.h"
+
+#include "Log.h"
+
+#include <gtc/matrix_transform.hpp>
+#include <gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Unidad de textura del mapa; 0 a 4 son de materiales, alturas y luces
+const int shadowUnit = 5;
+
+// Cuanto se extiende cada cascada hacia el sol para atrapar a los objetos
+// que proyectan sombra desde fuera de su ventana
+const float shadowCasterReach = 100.0f;
+
+CascadedShadows::CascadedShadows(float nearPlane)
+	: nearPlane(nearPlane), lightDirection(0.0f), lightView(1.0f)
+{
+	for (int cascade = 0; cascade < shadowCascades; cascade++) {
+		cascades[cascade] = {};
+		staticDirty[cascade] = true;
+	}
+	SetLightDirection(glm::vec3(0.4f, 1.0f, 0.3f));
+
+	dynamicDrawn = 0;
+	staticRenders = 0;
+
+	// Los recursos de GL se crean en el primer Render, asi Fit y
+	// SelectCasters pueden usarse sin contexto
+	depthShader = NULL;
+	modelLocation = -1;
+	staticTexture = staticFramebuffer = 0;
+	shadowTexture = shadowFramebuffer = 0;
+}
+
+CascadedShadows::~CascadedShadows()
+{
+	if (depthShader) {
+		unsigned int textures[] = { staticTexture, shadowTexture };
+		unsigned int framebuffers[] = { staticFramebuffer, shadowFramebuffer };
+		glDeleteTextures(2, textures);
+		glDeleteFramebuffers(2, framebuffers);
+		delete depthShader;
+	}
+}
+
+void CascadedShadows::SetLightDirection(glm::vec3 direction)
+{
+	direction = glm::normalize(direction);
+	if (direction == lightDirection) {
+		return;
+	}
+	lightDirection = direction;
+
+	glm::vec3 up = fabsf(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	lightView = glm::lookAt(glm::vec3(0.0f), -direction, up);
+	for (int cascade = 0; cascade < shadowCascades; cascade++) {
+		staticDirty[cascade] = true;
+	}
+}
+
+void CascadedShadows::Fit(const glm::mat4& view, const glm::mat4& projection)
+{
+	glm::mat4 inverseView = glm::inverse(view);
+	glm::mat4 inverseLightView = glm::inverse(lightView);
+	glm::vec3 eye = glm::vec3(inverseView[3]);
+	glm::vec3 forward = -glm::normalize(glm::vec3(inverseView[2]));
+
+	// Una esquina de la rebanada a distancia d del ojo esta a d * sqrt(k2)
+	// del eje de la camara
+	float tanX = 1.0f / projection[0][0];
+	float tanY = 1.0f / projection[1][1];
+	float k2 = tanX * tanX + tanY * tanY;
+
+	float splitNear = nearPlane;
+	for (int index = 0; index < shadowCascades; index++) {
+		float fraction = (float)(index + 1) / shadowCascades;
+		float logarithmic = nearPlane * powf(shadowDistance / nearPlane, fraction);
+		float uniform = nearPlane + (shadowDistance - nearPlane) * fraction;
+		float splitFar = glm::mix(uniform, logarithmic, shadowSplitLambda);
+
+		// Esfera minima de la rebanada: centro sobre el eje, a igual distancia
+		// de las esquinas cercanas y de las lejanas. Se redondea hacia arriba
+		// para que el error de punto flotante no cambie su tamanno
+		float along = min(0.5f * (splitNear + splitFar) * (1.0f + k2), splitFar);
+		float nearSide = (along - splitNear) * (along - splitNear) + splitNear * splitNear * k2;
+		float farSide = (splitFar - along) * (splitFar - along) + splitFar * splitFar * k2;
+		float radius = ceilf(sqrtf(max(nearSide, farSide)) * 16.0f) / 16.0f;
+
+		// La ventana es un poco mayor que la esfera para que siga cubriendola
+		// con el centro llevado a la grilla. El paso de la grilla es un
+		// numero entero de texels
+		float halfExtent = radius / (1.0f - 1.5f / shadowSnapCells);
+		float step = 2.0f * halfExtent / shadowSnapCells;
+		glm::vec3 center = glm::vec3(lightView * glm::vec4(eye + forward * along, 1.0f));
+		glm::vec3 window = glm::round(center / step) * step;
+
+		ShadowCascade& cascade = cascades[index];
+		if (window != cascade.window || halfExtent != cascade.halfExtent) {
+			staticDirty[index] = true;
+		}
+		cascade.window = window;
+		cascade.center = glm::vec3(inverseLightView * glm::vec4(window, 1.0f));
+		cascade.halfExtent = halfExtent;
+		cascade.splitFar = splitFar;
+		cascade.view = lightView;
+		// En espacio de luz el sol mira hacia -z: el plano cercano se corre
+		// hacia el sol para incluir a los que proyectan sombra
+		cascade.projection = glm::ortho(window.x - halfExtent, window.x + halfExtent,
+			window.y - halfExtent, window.y + halfExtent,
+			-(window.z + halfExtent + shadowCasterReach), -(window.z - halfExtent));
+		cascade.casters = extractFrustum(cascade.projection * cascade.view);
+
+		splitNear = splitFar;
+	}
+}
+
+void CascadedShadows::SelectCasters(const vector<Geometry*>& objects, const FrameSnapshot& snapshot, float alpha,
+	JobSystem& jobs)
+{
+	int count = (int)min(objects.size(), snapshot.objects.size());
+
+	// Un objetivo destruido cambia el conjunto de estaticos
+	staticScratch.clear();
+	for (int i = 0; i < count; i++) {
+		if (objects[i]->isStatic && snapshot.objects[i].visible) {
+			staticScratch.push_back(i);
+		}
+	}
+	if (staticScratch != staticSet) {
+		staticSet.swap(staticScratch);
+		for (int cascade = 0; cascade < shadowCascades; cascade++) {
+			staticDirty[cascade] = true;
+		}
+	}
+
+	bool anyDirty = false;
+	for (int cascade = 0; cascade < shadowCascades; cascade++) {
+		anyDirty |= staticDirty[cascade];
+	}
+
+	models.resize(count);
+	masks.resize(count);
+
+	// Los estaticos solo se miran si hay que rehacer alguna capa
+	jobs.ParallelFor(count, 256, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			const ObjectState& state = snapshot.objects[i];
+			bool isStatic = objects[i]->isStatic;
+			masks[i] = 0;
+			if (!state.visible || (isStatic && !anyDirty)) {
+				continue;
+			}
+
+			glm::vec3 renderPosition = glm::mix(state.prevPosition, state.position, alpha);
+			glm::vec3 renderRotation = glm::mix(state.prevRotation, state.rotation, alpha);
+			models[i] = objects[i]->ModelMatrix(renderPosition, renderRotation);
+			AABB bounds = transformBounds(models[i], objects[i]->size);
+			for (int cascade = 0; cascade < shadowCascades; cascade++) {
+				if ((!isStatic || staticDirty[cascade]) && intersects(cascades[cascade].casters, bounds)) {
+					masks[i] |= 1 << cascade;
+				}
+			}
+		}
+	});
+
+	for (int cascade = 0; cascade < shadowCascades; cascade++) {
+		dynamicCasters[cascade].clear();
+		if (staticDirty[cascade]) {
+			staticCasters[cascade].clear();
+		}
+	}
+	for (int i = 0; i < count; i++) {
+		if (!masks[i]) {
+			continue;
+		}
+		DrawItem item = { objects[i], models[i], 0 };
+		for (int cascade = 0; cascade < shadowCascades; cascade++) {
+			if (masks[i] & (1 << cascade)) {
+				(objects[i]->isStatic ? staticCasters : dynamicCasters)[cascade].push_back(item);
+			}
+		}
+	}
+}
+
+void CascadedShadows::CreateTargets()
+{
+	depthShader = new Shader("src/Shaders/ShadowVertexShader.vs", "src/Shaders/ShadowFragmentShader.fs");
+	modelLocation = glGetUniformLocation(depthShader->ID, "model");
+
+	// Una capa por cascada. Fuera del mapa la profundidad es 1: sin sombra
+	float border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (unsigned int* texture : { &staticTexture, &shadowTexture }) {
+		glGenTextures(1, texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, *texture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, shadowMapSize, shadowMapSize, shadowCascades, 0,
+			GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	// El mapa final compara en el hardware; con filtro lineal cada lectura
+	// ya promedia 2x2 texels
+	glBindTexture(GL_TEXTURE_2D_ARRAY, shadowTexture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	// Framebuffers solo de profundidad; la capa se elige al dibujar
+	unsigned int* framebuffers[] = { &staticFramebuffer, &shadowFramebuffer };
+	unsigned int textures[] = { staticTexture, shadowTexture };
+	for (int i = 0; i < 2; i++) {
+		glGenFramebuffers(1, framebuffers[i]);
+		glBindFramebuffer(GL_FRAMEBUFFER, *framebuffers[i]);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textures[i], 0, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			LOG_ERROR("Shadow framebuffer is incomplete");
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	LOG_INFO("Shadows: {} cascades of {}x{} up to {} m", shadowCascades, shadowMapSize, shadowMapSize, shadowDistance);
+}
+
+void CascadedShadows::DrawCasters(const vector<DrawItem>& casters, const ShadowCascade& cascade)
+{
+	glUseProgram(depthShader->ID);
+	depthShader->setMat4("lightViewProjection", cascade.projection * cascade.view);
+
+	unsigned int mesh = 0;
+	for (const DrawItem& item : casters) {
+		if (item.object->VAO != mesh) {
+			item.object->BindMesh();
+			mesh = item.object->VAO;
+		}
+		glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(item.model));
+		item.object->DrawMesh();
+	}
+	glBindVertexArray(0);
+}
+
+void CascadedShadows::Render(Terrain& terrain)
+{
+	if (!depthShader) {
+		CreateTargets();
+	}
+
+	GLint viewport[4];
+	GLint framebuffer;
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+	glViewport(0, 0, shadowMapSize, shadowMapSize);
+
+	// Sesgo segun la pendiente contra el acne. Lo que queda mas cerca del
+	// sol que el plano cercano se aplasta sobre el en lugar de recortarse
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+	glEnable(GL_DEPTH_CLAMP);
+
+	dynamicDrawn = 0;
+	for (int index = 0; index < shadowCascades; index++) {
+		const ShadowCascade& cascade = cascades[index];
+
+		if (staticDirty[index]) {
+			glBindFramebuffer(GL_FRAMEBUFFER, staticFramebuffer);
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticTexture, 0, index);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			DrawCasters(staticCasters[index], cascade);
+			// El detalle del terreno se elige desde la ventana, no desde la
+			// camara, asi la capa no depende de cuando se rehizo
+			terrain.DrawDepth(cascade.view, cascade.projection, cascade.center, cascade.casters);
+			staticDirty[index] = false;
+			staticRenders++;
+		}
+
+		// Se parte de la capa estatica y se agregan los que se mueven
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, staticFramebuffer);
+		glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticTexture, 0, index);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadowFramebuffer);
+		glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowTexture, 0, index);
+		glBlitFramebuffer(0, 0, shadowMapSize, shadowMapSize, 0, 0, shadowMapSize, shadowMapSize,
+			GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, shadowFramebuffer);
+		DrawCasters(dynamicCasters[index], cascade);
+		dynamicDrawn += (int)dynamicCasters[index].size();
+	}
+
+	glDisable(GL_DEPTH_CLAMP);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void CascadedShadows::Apply(const Shader& shader) const
+{
+	// De [-1, 1] a [0, 1] para leer el mapa
+	const glm::mat4 bias = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+
+	glm::mat4 matrices[shadowCascades];
+	glm::vec4 splits(0.0f);
+	glm::vec4 normalOffsets(0.0f);
+	for (int index = 0; index < shadowCascades; index++) {
+		const ShadowCascade& cascade = cascades[index];
+		matrices[index] = bias * cascade.projection * cascade.view;
+		splits[index] = cascade.splitFar;
+		// El punto se corre texel y medio sobre su normal antes de leer
+		normalOffsets[index] = 1.5f * 2.0f * cascade.halfExtent / shadowMapSize;
+	}
+
+	glUseProgram(shader.ID);
+	shader.setInt("shadowMap", shadowUnit);
+	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "shadowMatrices"), shadowCascades, GL_FALSE,
+		glm::value_ptr(matrices[0]));
+	shader.setVec4("shadowSplits", splits);
+	shader.setVec4("shadowNormalOffsets", normalOffsets);
+	shader.setVec3("sunDirection", lightDirection);
+
+	glActiveTexture(GL_TEXTURE0 + shadowUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, shadowTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,119 @@
+#ifndef CASCADED_SHADOWS_H
+#define CASCADED_SHADOWS_H
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include "Shader.h"
+#include "Bounds.h"
+#include "Snapshot.h"
+#include "JobSystem.h"
+#include "Terrain.h"
+
+#include <vector>
+
+using namespace std;
+
+// Cascadas del sol, entre 2 y 4. Debe coincidir con FragmentShader.fs
+const int shadowCascades = 3;
+// Lado en texels de cada cascada; multiplo de shadowSnapCells
+const int shadowMapSize = 2048;
+// Distancia hasta donde llegan las sombras y reparto de las cascadas entre
+// rebanadas uniformes (0) y logaritmicas (1)
+const float shadowDistance = 150.0f;
+const float shadowSplitLambda = 0.8f;
+// Las ventanas de las cascadas se mueven de a 1/shadowSnapCells de su lado
+const int shadowSnapCells = 16;
+
+// Una cascada: proyeccion ortografica del sol sobre una esfera que envuelve
+// una rebanada del frustum de la camara
+struct ShadowCascade
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	Frustum casters;    // incluye lo que esta entre el sol y la ventana
+	glm::vec3 window;   // centro en espacio de luz, alineado a la grilla
+	glm::vec3 center;   // el mismo centro en mundo
+	float halfExtent;
+	float splitFar;     // profundidad de vista donde termina la cascada
+};
+
+// Sombras direccionales en cascadas. La esfera de cada cascada solo depende
+// de la proyeccion, asi que su tamanno no cambia al girar la camara, y su
+// centro se mueve de a saltos enteros de texels: los bordes no titilan.
+//
+// Los objetos estaticos (terreno, objetivos, escenario) se dibujan en una
+// capa de profundidad aparte que se rehace solo si cambia el sol, el
+// conjunto de estaticos o la ventana de esa cascada. Cada frame se copia la
+// capa estatica y encima se dibujan solo los objetos que se mueven.
+class CascadedShadows
+{
+public:
+
+	CascadedShadows(float nearPlane);
+	~CascadedShadows();
+
+	// Direccion hacia el sol
+	void SetLightDirection(glm::vec3 direction);
+
+	// Ajusta las cascadas a la camara. No usa GL
+	void Fit(const glm::mat4& view, const glm::mat4& projection);
+	// Separa los objetos visibles en estaticos y dinamicos y los reparte en
+	// las cascadas cuyo volumen tocan. No usa GL
+	void SelectCasters(const vector<Geometry*>& objects, const FrameSnapshot& snapshot, float alpha, JobSystem& jobs);
+	// Dibuja los mapas de sombra. Solo desde el hilo de GL; deja el
+	// framebuffer y el viewport como estaban
+	void Render(Terrain& terrain);
+	// Fija el mapa y las matrices en 'shader'
+	void Apply(const Shader& shader) const;
+
+	inline const ShadowCascade& Cascade(int cascade) const
+	{
+		return cascades[cascade];
+	};
+
+	// Objetos dinamicos dibujados en el ultimo Render, sumando cascadas
+	inline int DynamicCasters() const
+	{
+		return dynamicDrawn;
+	};
+
+	// Veces que se rehizo la capa estatica de alguna cascada
+	inline int StaticRenders() const
+	{
+		return staticRenders;
+	};
+
+private:
+
+	void CreateTargets();
+	void DrawCasters(const vector<DrawItem>& casters, const ShadowCascade& cascade);
+
+	float nearPlane;
+	glm::vec3 lightDirection;
+	glm::mat4 lightView;
+
+	ShadowCascade cascades[shadowCascades];
+	bool staticDirty[shadowCascades];
+	vector<DrawItem> staticCasters[shadowCascades];
+	vector<DrawItem> dynamicCasters[shadowCascades];
+
+	// Estaticos visibles en el ultimo SelectCasters; si cambian se rehacen
+	// todas las capas estaticas
+	vector<int> staticSet;
+	vector<int> staticScratch;
+
+	// Por objeto: matriz y bit de cada cascada que toca
+	vector<glm::mat4> models;
+	vector<unsigned char> masks;
+
+	int dynamicDrawn;
+	int staticRenders;
+
+	Shader* depthShader;
+	int modelLocation;
+	unsigned int staticTexture, staticFramebuffer;
+	unsigned int shadowTexture, shadowFramebuffer;
+};
+
+#endif
@@ -0,0 +1,307 @@
+#include "ClusteredLighting.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#define CLUSTER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLUSTER_SSE2
+#include <emmintrin.h>
+#endif
+
+// Unidades de textura de los buffers; la 0 y la 1 son de los materiales y
+// de las alturas del terreno
+const int clusterGridUnit = 2;
+const int clusterIndexUnit = 3;
+const int clusterLightUnit = 4;
+
+// Destellos de los efectos de la simulacion
+const Light muzzleFlashLight = { glm::vec3(0.0f), 8.0f, glm::vec3(5.0f, 3.4f, 1.6f), -1.0f, glm::vec3(0.0f) };
+const float muzzleFlashDuration = 0.12f;
+const Light explosionLight = { glm::vec3(0.0f), 18.0f, glm::vec3(9.0f, 4.5f, 1.5f), -1.0f, glm::vec3(0.0f) };
+const float explosionDuration = 0.6f;
+
+ClusteredLighting::ClusteredLighting(float nearPlane, float farPlane)
+	: nearPlane(nearPlane), farPlane(farPlane), froxelProjection(0.0f)
+{
+	slices.resize(clusterSlices);
+	binned.resize((size_t)clusterCount * maxLightsPerCluster);
+	binnedCount.resize(clusterCount);
+	grid.resize((size_t)clusterCount * 2);
+
+	// Los buffers de GL se crean en el primer Upload, asi Build puede
+	// medirse sin contexto
+	gridBuffer = gridTexture = 0;
+	indexBuffer = indexTexture = 0;
+	lightBuffer = lightTexture = 0;
+}
+
+ClusteredLighting::~ClusteredLighting()
+{
+	if (gridBuffer) {
+		unsigned int buffers[] = { gridBuffer, indexBuffer, lightBuffer };
+		unsigned int textures[] = { gridTexture, indexTexture, lightTexture };
+		glDeleteBuffers(3, buffers);
+		glDeleteTextures(3, textures);
+	}
+}
+
+void ClusteredLighting::AddLight(const Light& light)
+{
+	fixedLights.push_back(light);
+}
+
+void ClusteredLighting::Emit(const EffectEvent& effect)
+{
+	FadingLight fading;
+	if (effect.kind == EFFECT_MUZZLE_FLASH) {
+		fading.light = muzzleFlashLight;
+		fading.duration = muzzleFlashDuration;
+		// Un poco por delante de la boca del canon
+		fading.light.position = effect.position + effect.direction * 0.5f;
+	}
+	else {
+		fading.light = explosionLight;
+		fading.duration = explosionDuration;
+		fading.light.position = effect.position + effect.direction;
+	}
+	fading.color = fading.light.color;
+	fading.life = fading.duration;
+	fadingLights.push_back(fading);
+}
+
+void ClusteredLighting::Clear()
+{
+	fixedLights.clear();
+	fadingLights.clear();
+}
+
+void ClusteredLighting::Update(float deltaTime)
+{
+	for (size_t i = 0; i < fadingLights.size();) {
+		FadingLight& fading = fadingLights[i];
+		fading.life -= deltaTime;
+		if (fading.life <= 0.0f) {
+			fading = fadingLights.back();
+			fadingLights.pop_back();
+			continue;
+		}
+		float remaining = fading.life / fading.duration;
+		fading.light.color = fading.color * remaining * remaining;
+		i++;
+	}
+}
+
+void ClusteredLighting::BuildFroxels(const glm::mat4& projection)
+{
+	// En vista, un punto a distancia d de la camara con coordenada de
+	// pantalla ndc esta en x = ndc.x * d / P[0][0], y = ndc.y * d / P[1][1]
+	float scaleX = 1.0f / projection[0][0];
+	float scaleY = 1.0f / projection[1][1];
+
+	for (int slice = 0; slice < clusterSlices; slice++) {
+		SliceBounds& bounds = slices[slice];
+		bounds.nearDepth = nearPlane * powf(farPlane / nearPlane, (float)slice / clusterSlices);
+		bounds.farDepth = nearPlane * powf(farPlane / nearPlane, (float)(slice + 1) / clusterSlices);
+
+		for (int y = 0; y < clusterTilesY; y++) {
+			float ndcY0 = -1.0f + 2.0f * y / clusterTilesY;
+			float ndcY1 = -1.0f + 2.0f * (y + 1) / clusterTilesY;
+			for (int x = 0; x < clusterTilesX; x++) {
+				float ndcX0 = -1.0f + 2.0f * x / clusterTilesX;
+				float ndcX1 = -1.0f + 2.0f * (x + 1) / clusterTilesX;
+
+				// El froxel es un tronco de piramide; su caja toma los
+				// extremos en la cara cercana y en la lejana
+				int cluster = y * clusterTilesX + x;
+				float depths[2] = { bounds.nearDepth, bounds.farDepth };
+				bounds.minX[cluster] = bounds.minY[cluster] = INFINITY;
+				bounds.maxX[cluster] = bounds.maxY[cluster] = -INFINITY;
+				for (float depth : depths) {
+					bounds.minX[cluster] = min(bounds.minX[cluster], ndcX0 * depth * scaleX);
+					bounds.maxX[cluster] = max(bounds.maxX[cluster], ndcX1 * depth * scaleX);
+					bounds.minY[cluster] = min(bounds.minY[cluster], ndcY0 * depth * scaleY);
+					bounds.maxY[cluster] = max(bounds.maxY[cluster], ndcY1 * depth * scaleY);
+				}
+			}
+		}
+	}
+
+	froxelProjection = projection;
+}
+
+void ClusteredLighting::BinSlice(int slice)
+{
+	const SliceBounds& bounds = slices[slice];
+	int* counts = &binnedCount[(size_t)slice * clustersPerSlice];
+	unsigned short* lists = &binned[(size_t)slice * clustersPerSlice * maxLightsPerCluster];
+	fill(counts, counts + clustersPerSlice, 0);
+
+	auto add = [&](int cluster, int light) {
+		if (counts[cluster] < maxLightsPerCluster) {
+			lists[cluster * maxLightsPerCluster + counts[cluster]++] = (unsigned short)light;
+		}
+	};
+
+	for (int light = 0; light < (int)viewSpheres.size(); light++) {
+		glm::vec4 sphere = viewSpheres[light];
+		float depth = sphere.z, radius = sphere.w;
+		if (depth + radius < bounds.nearDepth || depth - radius > bounds.farDepth) {
+			continue;
+		}
+
+		// La distancia en profundidad es la misma para toda la rebanada; lo
+		// que queda del radio se reparte entre x e y
+		float dz = max(max(bounds.nearDepth - depth, depth - bounds.farDepth), 0.0f);
+		float budget = radius * radius - dz * dz;
+		int cluster = 0;
+
+#if defined(CLUSTER_AVX2)
+		__m256 cx = _mm256_set1_ps(sphere.x), cy = _mm256_set1_ps(sphere.y);
+		__m256 limit = _mm256_set1_ps(budget), zero = _mm256_setzero_ps();
+		for (; cluster + 8 <= clustersPerSlice; cluster += 8) {
+			__m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(&bounds.minX[cluster]), cx),
+				_mm256_sub_ps(cx, _mm256_loadu_ps(&bounds.maxX[cluster]))), zero);
+			__m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(&bounds.minY[cluster]), cy),
+				_mm256_sub_ps(cy, _mm256_loadu_ps(&bounds.maxY[cluster]))), zero);
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance, limit, _CMP_LE_OQ));
+			for (int lane = 0; mask; lane++, mask >>= 1) {
+				if (mask & 1) {
+					add(cluster + lane, light);
+				}
+			}
+		}
+#elif defined(CLUSTER_SSE2)
+		__m128 cx = _mm_set1_ps(sphere.x), cy = _mm_set1_ps(sphere.y);
+		__m128 limit = _mm_set1_ps(budget), zero = _mm_setzero_ps();
+		for (; cluster + 4 <= clustersPerSlice; cluster += 4) {
+			__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&bounds.minX[cluster]), cx),
+				_mm_sub_ps(cx, _mm_loadu_ps(&bounds.maxX[cluster]))), zero);
+			__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&bounds.minY[cluster]), cy),
+				_mm_sub_ps(cy, _mm_loadu_ps(&bounds.maxY[cluster]))), zero);
+			__m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+			int mask = _mm_movemask_ps(_mm_cmple_ps(distance, limit));
+			for (int lane = 0; mask; lane++, mask >>= 1) {
+				if (mask & 1) {
+					add(cluster + lane, light);
+				}
+			}
+		}
+#endif
+
+		// Resto que no completa un lote
+		for (; cluster < clustersPerSlice; cluster++) {
+			float dx = max(max(bounds.minX[cluster] - sphere.x, sphere.x - bounds.maxX[cluster]), 0.0f);
+			float dy = max(max(bounds.minY[cluster] - sphere.y, sphere.y - bounds.maxY[cluster]), 0.0f);
+			if (dx * dx + dy * dy <= budget) {
+				add(cluster, light);
+			}
+		}
+	}
+}
+
+void ClusteredLighting::Build(const glm::mat4& view, const glm::mat4& projection, JobSystem& jobs)
+{
+	if (projection != froxelProjection) {
+		BuildFroxels(projection);
+	}
+
+	lights = fixedLights;
+	for (const FadingLight& fading : fadingLights) {
+		lights.push_back(fading.light);
+	}
+	if ((int)lights.size() > maxLights) {
+		LOG_WARNING("ClusteredLighting: {} lights, only the first {} are used", lights.size(), maxLights);
+		lights.resize(maxLights);
+	}
+
+	// Esferas en vista con la profundidad positiva, como las rebanadas
+	viewSpheres.resize(lights.size());
+	for (size_t i = 0; i < lights.size(); i++) {
+		glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+		viewSpheres[i] = glm::vec4(center.x, center.y, -center.z, lights[i].radius);
+	}
+
+	jobs.ParallelFor(clusterSlices, 1, [&](int begin, int end) {
+		for (int slice = begin; slice < end; slice++) {
+			BinSlice(slice);
+		}
+	});
+
+	// Compactacion en el orden de los froxels
+	indices.clear();
+	for (int cluster = 0; cluster < clusterCount; cluster++) {
+		const unsigned short* list = &binned[(size_t)cluster * maxLightsPerCluster];
+		grid[cluster * 2] = (unsigned int)indices.size();
+		grid[cluster * 2 + 1] = (unsigned int)binnedCount[cluster];
+		indices.insert(indices.end(), list, list + binnedCount[cluster]);
+	}
+
+	lightData.resize(lights.size() * 3);
+	for (size_t i = 0; i < lights.size(); i++) {
+		const Light& light = lights[i];
+		lightData[i * 3] = glm::vec4(light.position, light.radius);
+		lightData[i * 3 + 1] = glm::vec4(light.color, light.spotCos);
+		lightData[i * 3 + 2] = glm::vec4(light.direction, 0.0f);
+	}
+}
+
+// Buffer y su vista como textura con el formato dado
+static void createTextureBuffer(unsigned int& buffer, unsigned int& texture, GLenum format)
+{
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+}
+
+void ClusteredLighting::Upload()
+{
+	if (!gridBuffer) {
+		createTextureBuffer(gridBuffer, gridTexture, GL_RG32UI);
+		createTextureBuffer(indexBuffer, indexTexture, GL_R16UI);
+		createTextureBuffer(lightBuffer, lightTexture, GL_RGBA32F);
+	}
+
+	// Se reserva de nuevo en cada frame para no esperar a que la GPU
+	// termine de leer el anterior. Nunca vacios: un buffer de tamanno cero
+	// no sirve de textura
+	glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, grid.size() * sizeof(unsigned int), grid.data(), GL_STREAM_DRAW);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, max<size_t>(indices.size(), 1) * sizeof(unsigned short), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, indices.size() * sizeof(unsigned short), indices.data());
+
+	glBindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, max<size_t>(lightData.size(), 1) * sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, lightData.size() * sizeof(glm::vec4), lightData.data());
+
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void ClusteredLighting::Apply(const Shader& shader, glm::vec2 viewport) const
+{
+	glUseProgram(shader.ID);
+	shader.setInt("clusterGrid", clusterGridUnit);
+	shader.setInt("clusterIndices", clusterIndexUnit);
+	shader.setInt("clusterLights", clusterLightUnit);
+	shader.setVec2("clusterViewport", viewport);
+	shader.setFloat("clusterNear", nearPlane);
+	shader.setFloat("clusterSliceScale", clusterSlices / logf(farPlane / nearPlane));
+
+	glActiveTexture(GL_TEXTURE0 + clusterGridUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+	glActiveTexture(GL_TEXTURE0 + clusterIndexUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glActiveTexture(GL_TEXTURE0 + clusterLightUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,125 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include "Shader.h"
+#include "Snapshot.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+using namespace std;
+
+// Grilla de froxels: tiles de pantalla por rebanadas de profundidad. Las
+// rebanadas crecen exponencialmente para que los froxels sean parecidos a
+// un cubo a cualquier distancia. Deben coincidir con FragmentShader.fs
+const int clusterTilesX = 16;
+const int clusterTilesY = 9;
+const int clusterSlices = 24;
+const int clustersPerSlice = clusterTilesX * clusterTilesY;
+const int clusterCount = clustersPerSlice * clusterSlices;
+
+// Luces como maximo por froxel y en total. El primero acota el costo de
+// cada fragmento aunque haya cientos de luces en pantalla
+const int maxLightsPerCluster = 32;
+const int maxLights = 1024;
+
+// Luz puntual o spot. Fuera de 'radius' no ilumina
+struct Light
+{
+	glm::vec3 position;
+	float radius;
+	glm::vec3 color;     // ya multiplicado por la intensidad
+	float spotCos;       // coseno del medio angulo del cono; -1 es puntual
+	glm::vec3 direction; // eje del cono, solo para spots
+};
+
+// Iluminacion forward por clusters. Cada frame se reparten las luces entre
+// los froxels en el CPU (una rebanada por trabajo, probando esfera contra
+// caja de a 4 u 8 froxels con SIMD) y se suben en texture buffers: la
+// grilla con (inicio, cantidad) por froxel, la lista compacta de indices y
+// los datos de las luces. El fragment shader solo recorre las luces de su
+// froxel.
+class ClusteredLighting
+{
+public:
+
+	ClusteredLighting(float nearPlane, float farPlane);
+	~ClusteredLighting();
+
+	// Luz que dura hasta Clear
+	void AddLight(const Light& light);
+	// Destello de un efecto de la simulacion; se apaga solo
+	void Emit(const EffectEvent& effect);
+	void Clear();
+
+	// Apaga las luces de efectos con el paso del tiempo
+	void Update(float deltaTime);
+
+	// Reparte las luces en los froxels de la camara. No usa GL
+	void Build(const glm::mat4& view, const glm::mat4& projection, JobSystem& jobs);
+	// Sube lo que armo Build. Solo desde el hilo de GL
+	void Upload();
+	// Fija los uniforms y las texturas en 'shader' para un viewport de
+	// 'viewport' pixeles
+	void Apply(const Shader& shader, glm::vec2 viewport) const;
+
+	inline int LightCount() const
+	{
+		return (int)lights.size();
+	};
+
+	// Indices en la lista compacta del ultimo Build
+	inline int IndexCount() const
+	{
+		return (int)indices.size();
+	};
+
+private:
+
+	// Luz de efecto: su color baja de 'color' a cero en 'duration' segundos
+	struct FadingLight
+	{
+		Light light;
+		glm::vec3 color;
+		float life;
+		float duration;
+	};
+
+	// Cajas en espacio de vista de los froxels de una rebanada, en SoA
+	struct SliceBounds
+	{
+		float minX[clustersPerSlice], minY[clustersPerSlice];
+		float maxX[clustersPerSlice], maxY[clustersPerSlice];
+		float nearDepth, farDepth; // distancias positivas a la camara
+	};
+
+	void BuildFroxels(const glm::mat4& projection);
+	void BinSlice(int slice);
+
+	float nearPlane;
+	float farPlane;
+	glm::mat4 froxelProjection;
+	vector<SliceBounds> slices;
+
+	vector<Light> fixedLights;
+	vector<FadingLight> fadingLights;
+	vector<Light> lights;         // las de este frame, en el orden de los indices
+	vector<glm::vec4> viewSpheres; // centro en vista y radio
+
+	// Listas de cada froxel con capacidad fija, llenadas en paralelo, y su
+	// version compacta para la GPU
+	vector<unsigned short> binned;
+	vector<int> binnedCount;
+	vector<unsigned int> grid;     // (inicio, cantidad) por froxel
+	vector<unsigned short> indices;
+	vector<glm::vec4> lightData;   // 3 texels por luz
+
+	unsigned int gridBuffer, gridTexture;
+	unsigned int indexBuffer, indexTexture;
+	unsigned int lightBuffer, lightTexture;
+};
+
+#endif
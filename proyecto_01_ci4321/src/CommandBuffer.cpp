@@ -0,0 +1,75 @@
+#include "CommandBuffer.h"
+
+#include <GL/glew.h>
+#include <gtc/type_ptr.hpp>
+
+void CommandBuffer::Clear()
+{
+	commands.clear();
+	matrices.clear();
+	programChanges = 0;
+	materialChanges = 0;
+	meshChanges = 0;
+	draws = 0;
+}
+
+void CommandBuffer::UseProgram(unsigned int program)
+{
+	RenderCommand command = { COMMAND_USE_PROGRAM, -1, program, NULL };
+	commands.push_back(command);
+	programChanges++;
+}
+
+void CommandBuffer::SetLayer(int location, int layer)
+{
+	RenderCommand command = { COMMAND_SET_LAYER, location, (unsigned int)layer, NULL };
+	commands.push_back(command);
+	materialChanges++;
+}
+
+void CommandBuffer::BindMesh(const Geometry* object)
+{
+	RenderCommand command = { COMMAND_BIND_MESH, -1, 0, object };
+	commands.push_back(command);
+	meshChanges++;
+}
+
+void CommandBuffer::Draw(const Geometry* object, int modelLocation, const glm::mat4& model)
+{
+	RenderCommand command = { COMMAND_DRAW, modelLocation, (unsigned int)matrices.size(), object };
+	commands.push_back(command);
+	matrices.push_back(model);
+	draws++;
+}
+
+void CommandBuffer::Callback(unsigned int index)
+{
+	RenderCommand command = { COMMAND_CALLBACK, -1, index, NULL };
+	commands.push_back(command);
+	draws++;
+}
+
+void CommandBuffer::Replay(const vector<function<void()>>& callbacks) const
+{
+	for (const RenderCommand& command : commands) {
+		switch (command.type)
+		{
+		case COMMAND_USE_PROGRAM:
+			glUseProgram(command.value);
+			break;
+		case COMMAND_SET_LAYER:
+			glUniform1i(command.location, (int)command.value);
+			break;
+		case COMMAND_BIND_MESH:
+			command.object->BindMesh();
+			break;
+		case COMMAND_DRAW:
+			glUniformMatrix4fv(command.location, 1, GL_FALSE, glm::value_ptr(matrices[command.value]));
+			command.object->DrawMesh();
+			break;
+		case COMMAND_CALLBACK:
+			callbacks[command.value]();
+			break;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include "Geometry.h"
+
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+enum CommandType
+{
+	COMMAND_USE_PROGRAM, // value: programa de GL
+	COMMAND_SET_LAYER,   // location, value: capa de materiales
+	COMMAND_BIND_MESH,   // object
+	COMMAND_DRAW,        // object, location del modelo, value: indice de la matriz
+	COMMAND_CALLBACK     // value: indice del dibujo especial
+};
+
+// Comando grabado; las matrices van aparte para que el comando sea chico
+struct RenderCommand
+{
+	CommandType type;
+	int location;
+	unsigned int value;
+	const Geometry* object;
+};
+
+// Lista de comandos de dibujo. Grabar no toca GL, asi que cada hilo del
+// JobSystem graba la suya; el hilo de GL las reproduce en orden con Replay.
+// Cada buffer cuenta los cambios de estado que graba.
+class CommandBuffer
+{
+public:
+
+	void Clear();
+
+	void UseProgram(unsigned int program);
+	void SetLayer(int location, int layer);
+	void BindMesh(const Geometry* object);
+	void Draw(const Geometry* object, int modelLocation, const glm::mat4& model);
+	void Callback(unsigned int index);
+
+	// Solo desde el hilo de GL. 'callbacks' son los dibujos especiales a
+	// los que apuntan los COMMAND_CALLBACK
+	void Replay(const vector<function<void()>>& callbacks) const;
+
+	inline size_t Size() const
+	{
+		return commands.size();
+	};
+
+	int programChanges = 0;
+	int materialChanges = 0;
+	int meshChanges = 0;
+	int draws = 0;
+
+private:
+
+	vector<RenderCommand> commands;
+	vector<glm::mat4> matrices;
+};
+
+#endif
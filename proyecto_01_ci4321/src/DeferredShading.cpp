@@ -0,0 +1,117 @@
+#include "DeferredShading.h"
+#include "Log.h"
+
+#include <gtc/type_ptr.hpp>
+
+#include <algorithm>
+
+// Unidades del G-buffer en el pase de luces; 0 a 5 son de materiales,
+// alturas, luces y sombras
+const int albedoUnit = 6;
+const int normalUnit = 7;
+const int depthUnit = 8;
+
+static unsigned int createTarget(int width, int height, GLenum internalFormat, GLenum format, GLenum type)
+{
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+	// Se lee con texelFetch, un texel por pixel
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	return texture;
+}
+
+DeferredShading::DeferredShading(int width, int height)
+	: width(width), height(height)
+{
+	albedoTexture = createTarget(width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+	normalTexture = createTarget(width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+	// Mismo formato que la profundidad de la escena, para poder copiarla
+	depthTexture = createTarget(width, height, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	GLenum attachments[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, attachments);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_ERROR("G-buffer is incomplete");
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Mismo triangulo de pantalla completa que el escalado de la escena
+	lightingShader = new Shader("src/Shaders/UpscaleVertexShader.vs", "src/Shaders/DeferredLighting.fs");
+	lightingShader->use();
+	lightingShader->setInt("gAlbedo", albedoUnit);
+	lightingShader->setInt("gNormal", normalUnit);
+	lightingShader->setInt("gDepth", depthUnit);
+	glGenVertexArrays(1, &vao);
+
+	sceneFramebuffer = 0;
+	viewport[0] = viewport[1] = 0;
+	viewport[2] = width;
+	viewport[3] = height;
+
+	LOG_INFO("Deferred shading: {}x{} G-buffer, 8 bytes per pixel plus depth", width, height);
+}
+
+DeferredShading::~DeferredShading()
+{
+	unsigned int textures[] = { albedoTexture, normalTexture, depthTexture };
+	glDeleteTextures(3, textures);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteVertexArrays(1, &vao);
+	delete lightingShader;
+}
+
+void DeferredShading::BeginGeometry()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &sceneFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	viewport[2] = min(viewport[2], width);
+	viewport[3] = min(viewport[3], height);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DeferredShading::Resolve(const glm::mat4& view, const glm::mat4& projection)
+{
+	int x0 = viewport[0], y0 = viewport[1];
+	int x1 = viewport[0] + viewport[2], y1 = viewport[1] + viewport[3];
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, sceneFramebuffer);
+	glBlitFramebuffer(x0, y0, x1, y1, x0, y0, x1, y1, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+
+	lightingShader->use();
+	lightingShader->setMat4("inverseProjection", glm::inverse(projection));
+	lightingShader->setMat4("inverseView", glm::inverse(view));
+
+	glActiveTexture(GL_TEXTURE0 + albedoUnit);
+	glBindTexture(GL_TEXTURE_2D, albedoTexture);
+	glActiveTexture(GL_TEXTURE0 + normalUnit);
+	glBindTexture(GL_TEXTURE_2D, normalTexture);
+	glActiveTexture(GL_TEXTURE0 + depthUnit);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+	// Cada pixel se escribe una vez; la profundidad ya quedo copiada
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,57 @@
+#ifndef DEFERRED_SHADING_H
+#define DEFERRED_SHADING_H
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include "Shader.h"
+
+using namespace std;
+
+// Camino diferido, alternativo al forward. Los objetos y el terreno se
+// dibujan con GBufferFragmentShader.fs en un G-buffer compacto:
+//   0: RGBA8 albedo y capa de material (MaterialLayer) en el alfa
+//   1: RGBA8 normal octaedrica con 12 bits por componente
+//   profundidad y stencil de 24:8, de donde se reconstruye la posicion
+// Despues un solo pase de pantalla completa ilumina cada pixel una vez con
+// las luces de su froxel (las mismas listas de ClusteredLighting), asi el
+// costo de las luces no crece con los objetos superpuestos.
+class DeferredShading
+{
+public:
+
+	// Tamanno maximo; se usa el rectangulo del viewport vigente
+	DeferredShading(int width, int height);
+	~DeferredShading();
+
+	// Vincula el G-buffer con el viewport actual y lo limpia
+	void BeginGeometry();
+	// Ilumina el G-buffer sobre el framebuffer que estaba vinculado en
+	// BeginGeometry y le copia la profundidad, para que el cielo y los
+	// efectos se prueben contra la escena
+	void Resolve(const glm::mat4& view, const glm::mat4& projection);
+
+	// Para ClusteredLighting::Apply y CascadedShadows::Apply
+	inline const Shader& GetLightingShader() const
+	{
+		return *lightingShader;
+	};
+
+private:
+
+	int width;
+	int height;
+	unsigned int framebuffer;
+	unsigned int albedoTexture;
+	unsigned int normalTexture;
+	unsigned int depthTexture;
+
+	Shader* lightingShader;
+	unsigned int vao;
+
+	// Destino de Resolve, guardado en BeginGeometry
+	int sceneFramebuffer;
+	int viewport[4];
+};
+
+#endif
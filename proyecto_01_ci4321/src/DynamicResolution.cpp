@@ -0,0 +1,215 @@
+#include "DynamicResolution.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+// Peso de cada medicion nueva en el promedio
+const double timeSmoothing = 0.2;
+// Al cambiar se apunta a esta fraccion del presupuesto, y mientras el
+// tiempo quede entre lowerBand y 1 del presupuesto la escala no se toca
+const double budgetHeadroom = 0.9;
+const double lowerBand = 0.75;
+// La escala se mueve de a pasos de 1/32; al subir, a lo sumo dos por vez
+const float scaleStep = 1.0f / 32.0f;
+const int maxStepsUp = 2;
+
+DynamicResolution::DynamicResolution(int width, int height, const ResolutionSettings& settings)
+	: width(width), height(height), settings(settings)
+{
+	this->settings.maxScale = glm::clamp(settings.maxScale, 0.1f, 1.0f);
+	this->settings.minScale = glm::clamp(settings.minScale, 0.1f, this->settings.maxScale);
+	this->settings.sharpness = glm::clamp(settings.sharpness, 0.0f, 1.0f);
+	if (settings.fixedScale > 0.0f) {
+		this->settings.fixedScale = glm::clamp(settings.fixedScale, 0.1f, 1.0f);
+		scale = this->settings.fixedScale;
+	}
+	else {
+		scale = this->settings.maxScale;
+	}
+	smoothedTime = 0.0;
+	cooldown = 0;
+
+	float largest = max(this->settings.maxScale, this->settings.fixedScale);
+	targetSize = glm::max(glm::ivec2(glm::ceil(glm::vec2(width, height) * largest)), glm::ivec2(1));
+
+	// Color con filtro lineal para escalar; la profundidad no se lee
+	glGenTextures(1, &colorTexture);
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, targetSize.x, targetSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, targetSize.x, targetSize.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_ERROR("Scene framebuffer is incomplete");
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	upscaleShader = new Shader("src/Shaders/UpscaleVertexShader.vs", "src/Shaders/UpscaleFragmentShader.fs");
+	upscaleShader->use();
+	upscaleShader->setInt("scene", 0);
+	glGenVertexArrays(1, &vao);
+
+	glGenQueries(resolutionQueries, queries);
+	queryHead = 0;
+	queryPending = 0;
+	measuring = false;
+
+	if (this->settings.fixedScale > 0.0f) {
+		LOG_INFO("Resolution: fixed scale {} of {}x{}", scale, width, height);
+	}
+	else {
+		LOG_INFO("Resolution: {} ms GPU budget, scale {} to {} of {}x{}", this->settings.gpuBudget,
+			this->settings.minScale, this->settings.maxScale, width, height);
+	}
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	glDeleteQueries(resolutionQueries, queries);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDeleteTextures(1, &colorTexture);
+	delete upscaleShader;
+}
+
+glm::ivec2 DynamicResolution::RenderSize() const
+{
+	glm::ivec2 size = glm::ivec2(glm::round(glm::vec2(width, height) * scale));
+	return glm::clamp(size, glm::ivec2(1), targetSize);
+}
+
+void DynamicResolution::Adjust(double gpuMilliseconds)
+{
+	// Mediciones de frames que empezaron antes del ultimo cambio
+	if (cooldown > 0) {
+		cooldown--;
+		return;
+	}
+	smoothedTime = smoothedTime > 0.0 ? glm::mix(smoothedTime, gpuMilliseconds, timeSmoothing) : gpuMilliseconds;
+
+	if (settings.fixedScale > 0.0f) {
+		return;
+	}
+	if (smoothedTime <= settings.gpuBudget && smoothedTime >= settings.gpuBudget * lowerBand) {
+		return;
+	}
+
+	// Pasado del presupuesto se baja de una vez; con margen se sube de a
+	// poco para no pasarse si la carga vuelve
+	float target = scale * (float)sqrt(settings.gpuBudget * budgetHeadroom / smoothedTime);
+	target = min(target, scale + maxStepsUp * scaleStep);
+	target = glm::clamp(roundf(target / scaleStep) * scaleStep, settings.minScale, settings.maxScale);
+	if (target == scale) {
+		return;
+	}
+
+	LOG_DEBUG("Resolution: {} ms GPU, scale {} -> {}", smoothedTime, scale, target);
+	// El promedio se corrige a la nueva cantidad de pixeles
+	smoothedTime *= (double)(target * target) / (double)(scale * scale);
+	scale = target;
+	cooldown = queryPending;
+}
+
+void DynamicResolution::ReadQueries()
+{
+	// Las consultas terminan en orden; se leen las mas viejas que ya esten
+	while (queryPending > 0) {
+		unsigned int query = queries[(queryHead - queryPending + resolutionQueries) % resolutionQueries];
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			break;
+		}
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		queryPending--;
+		Adjust((double)elapsed / 1.0e6);
+	}
+}
+
+void DynamicResolution::BeginScene()
+{
+	ReadQueries();
+
+	// Con todas las consultas en vuelo este frame no se mide
+	measuring = queryPending < resolutionQueries;
+	if (measuring) {
+		glBeginQuery(GL_TIME_ELAPSED, queries[queryHead]);
+	}
+
+	glm::ivec2 size = RenderSize();
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, size.x, size.y);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DynamicResolution::EndScene()
+{
+	glm::ivec2 size = RenderSize();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+
+	upscaleShader->use();
+	upscaleShader->setVec2("sceneScale", glm::vec2(size) / glm::vec2(targetSize));
+	upscaleShader->setFloat("sharpness", settings.sharpness);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+
+	// Cubre toda la ventana; no hace falta limpiarla
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+
+	if (measuring) {
+		glEndQuery(GL_TIME_ELAPSED);
+		queryHead = (queryHead + 1) % resolutionQueries;
+		queryPending++;
+		measuring = false;
+	}
+}
+
+ResolutionSettings parseResolution(int argc, char** argv)
+{
+	// Presupuesto con margen para el CPU dentro de un frame de 60 Hz
+	ResolutionSettings settings = { 14.0, 0.5f, 1.0f, 0.0f, 0.5f };
+
+	for (int i = 1; i + 1 < argc; i++) {
+		string option = argv[i];
+		string value = argv[i + 1];
+		if (option == "--gpu-budget") {
+			settings.gpuBudget = atof(value.c_str());
+		}
+		else if (option == "--min-scale") {
+			settings.minScale = (float)atof(value.c_str());
+		}
+		else if (option == "--max-scale") {
+			settings.maxScale = (float)atof(value.c_str());
+		}
+		else if (option == "--render-scale") {
+			settings.fixedScale = (float)atof(value.c_str());
+		}
+		else if (option == "--sharpness") {
+			settings.sharpness = (float)atof(value.c_str());
+		}
+	}
+	return settings;
+}
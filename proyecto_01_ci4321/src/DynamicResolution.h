@@ -0,0 +1,91 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include "Shader.h"
+
+using namespace std;
+
+// Consultas de tiempo en vuelo; el resultado de una se lee unos frames
+// despues, cuando la GPU ya termino, sin detener el hilo de GL
+const int resolutionQueries = 4;
+
+struct ResolutionSettings
+{
+	double gpuBudget;  // milisegundos de GPU por frame
+	float minScale;    // escala minima de cada eje
+	float maxScale;    // escala maxima, a lo sumo 1
+	float fixedScale;  // distinto de 0: escala fija, sin ajuste
+	float sharpness;   // 0 a 1, del filtro al escalar
+};
+
+// Resolucion dinamica. La escena se dibuja en un framebuffer propio, en un
+// rectangulo de escala * tamanno de la ventana, y al final se lleva a la
+// ventana con un filtro de nitidez adaptativo. El tiempo de GPU de cada
+// frame se mide con consultas GL_TIME_ELAPSED y la escala se ajusta para
+// que quede dentro del presupuesto: el costo crece con los pixeles, o sea
+// con el cuadrado de la escala.
+class DynamicResolution
+{
+public:
+
+	DynamicResolution(int width, int height, const ResolutionSettings& settings);
+	~DynamicResolution();
+
+	// Vincula el framebuffer de la escena con el viewport escalado, lo
+	// limpia y empieza a medir
+	void BeginScene();
+	// Lleva la escena a la ventana y termina la medicion
+	void EndScene();
+
+	// Ajusta la escala con un tiempo medido. No usa GL
+	void Adjust(double gpuMilliseconds);
+
+	// Pixeles del rectangulo de la escena en este frame
+	glm::ivec2 RenderSize() const;
+
+	inline float Scale() const
+	{
+		return scale;
+	};
+
+	// Tiempo de GPU suavizado, en milisegundos
+	inline double GpuTime() const
+	{
+		return smoothedTime;
+	};
+
+private:
+
+	void ReadQueries();
+
+	int width;
+	int height;
+	ResolutionSettings settings;
+	float scale;
+	double smoothedTime;
+	int cooldown; // resultados por descartar, medidos con la escala anterior
+
+	// Framebuffer del tamanno maximo; solo se usa la esquina inferior
+	// izquierda que corresponde a la escala
+	glm::ivec2 targetSize;
+	unsigned int framebuffer;
+	unsigned int colorTexture;
+	unsigned int depthBuffer;
+
+	Shader* upscaleShader;
+	unsigned int vao;
+
+	unsigned int queries[resolutionQueries];
+	int queryHead;    // proxima consulta a empezar
+	int queryPending; // consultas empezadas y sin leer
+	bool measuring;
+};
+
+// Lee --gpu-budget MS, --min-scale F, --max-scale F, --render-scale F y
+// --sharpness F de la linea de comandos
+ResolutionSettings parseResolution(int argc, char** argv);
+
+#endif
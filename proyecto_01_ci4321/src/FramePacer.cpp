@@ -0,0 +1,138 @@
+#include "FramePacer.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+using namespace std;
+
+// Margen inicial y limites del tramo que se hace girando, en segundos
+const double initialOvershoot = 0.002;
+const double minOvershoot = 0.0005;
+const double maxOvershoot = 0.004;
+// Peso de cada medicion nueva en el promedio del margen
+const double overshootSmoothing = 0.2;
+
+FramePacer::FramePacer(GLFWwindow* window, const FramePacingSettings& settings)
+{
+	this->window = window;
+	this->settings = settings;
+	nextFrame = glfwGetTime();
+	sleepOvershoot = initialOvershoot;
+	idle = false;
+
+#ifdef _WIN32
+	// Por defecto Windows duerme en pasos de ~15.6 ms
+	timeBeginPeriod(1);
+#endif
+
+	SetSwapMode(settings.swapMode);
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::SetSwapMode(SwapMode mode)
+{
+	// El swap adaptativo es un intervalo negativo, si el driver lo soporta
+	if (mode == SWAP_ADAPTIVE && !glfwExtensionSupported("WGL_EXT_swap_control_tear")
+		&& !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+		LOG_WARNING("FramePacer: adaptive vsync not supported, using vsync");
+		mode = SWAP_VSYNC;
+	}
+
+	settings.swapMode = mode;
+	glfwSwapInterval(mode == SWAP_IMMEDIATE ? 0 : (mode == SWAP_VSYNC ? 1 : -1));
+}
+
+bool FramePacer::BeginFrame()
+{
+	bool iconified = glfwGetWindowAttrib(window, GLFW_ICONIFIED);
+	bool focused = glfwGetWindowAttrib(window, GLFW_FOCUSED);
+	idle = iconified || !focused;
+
+	if (idle) {
+		// Cualquier evento (recuperar el foco, una tecla) corta la espera
+		double idlePeriod = 1.0 / max(1.0, settings.idleFps);
+		double now = glfwGetTime();
+		if (nextFrame > now) {
+			glfwWaitEventsTimeout(min(nextFrame - now, idlePeriod));
+		}
+		nextFrame = max(nextFrame, glfwGetTime()) + idlePeriod;
+		return !iconified;
+	}
+
+	if (settings.targetFps <= 0.0) {
+		nextFrame = glfwGetTime();
+		return true;
+	}
+
+	// Al salir del modo de espera la hora agendada puede quedar lejos
+	double period = 1.0 / settings.targetFps;
+	nextFrame = min(nextFrame, glfwGetTime() + period);
+	WaitUntil(nextFrame);
+
+	// Si el frame se atraso mas de un periodo no se intenta recuperar
+	double now = glfwGetTime();
+	nextFrame = now - nextFrame > period ? now + period : nextFrame + period;
+	return true;
+}
+
+void FramePacer::EndFrame()
+{
+	glfwSwapBuffers(window);
+	glfwPollEvents();
+}
+
+void FramePacer::WaitUntil(double deadline)
+{
+	double now = glfwGetTime();
+
+	// Se duerme hasta un margen antes de la hora, y el margen se ajusta con
+	// lo que el sistema se paso en las veces anteriores
+	double sleepTime = deadline - now - sleepOvershoot;
+	if (sleepTime > 0.0) {
+		this_thread::sleep_for(chrono::duration<double>(sleepTime));
+		double woke = glfwGetTime();
+		double overshoot = (woke - now) - sleepTime;
+		sleepOvershoot = clamp(sleepOvershoot * (1.0 - overshootSmoothing) + overshoot * overshootSmoothing,
+			minOvershoot, maxOvershoot);
+	}
+
+	while (glfwGetTime() < deadline) {
+		this_thread::yield();
+	}
+}
+
+FramePacingSettings parseFramePacing(int argc, char** argv)
+{
+	FramePacingSettings settings = { SWAP_VSYNC, 0.0, 10.0 };
+
+	for (int i = 1; i + 1 < argc; i++) {
+		string option = argv[i];
+		string value = argv[i + 1];
+		if (option == "--vsync") {
+			settings.swapMode = value == "off" ? SWAP_IMMEDIATE : (value == "adaptive" ? SWAP_ADAPTIVE : SWAP_VSYNC);
+		}
+		else if (option == "--fps") {
+			settings.targetFps = atof(value.c_str());
+		}
+		else if (option == "--idle-fps") {
+			settings.idleFps = atof(value.c_str());
+		}
+	}
+	return settings;
+}
@@ -0,0 +1,60 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <GLFW/glfw3.h>
+
+// Sincronizacion del swap con el refresco del monitor
+enum SwapMode
+{
+	SWAP_IMMEDIATE, // sin vsync
+	SWAP_VSYNC,
+	SWAP_ADAPTIVE   // vsync, pero si el frame llega tarde se presenta igual
+};
+
+struct FramePacingSettings
+{
+	SwapMode swapMode;
+	double targetFps; // 0: sin limite propio, manda el swap
+	double idleFps;   // con la ventana sin foco
+};
+
+// Ritmo del ciclo principal. BeginFrame espera hasta el inicio del proximo
+// frame (primero durmiendo y los ultimos instantes girando, para no
+// depender de la resolucion del temporizador del sistema) y EndFrame
+// presenta. Sin foco el ciclo baja a idleFps esperando eventos, y con la
+// ventana minimizada no se dibuja.
+class FramePacer
+{
+public:
+
+	FramePacer(GLFWwindow* window, const FramePacingSettings& settings);
+	~FramePacer();
+
+	void SetSwapMode(SwapMode mode);
+
+	// Devuelve false si este frame no debe dibujarse
+	bool BeginFrame();
+
+	// Intercambia buffers y procesa eventos
+	void EndFrame();
+
+	inline bool Idle() const
+	{
+		return idle;
+	};
+
+private:
+
+	void WaitUntil(double deadline);
+
+	GLFWwindow* window;
+	FramePacingSettings settings;
+	double nextFrame;
+	double sleepOvershoot; // cuanto de mas suele dormir el sistema
+	bool idle;
+};
+
+// Lee --vsync off|on|adaptive, --fps N y --idle-fps N de la linea de comandos
+FramePacingSettings parseFramePacing(int argc, char** argv);
+
+#endif
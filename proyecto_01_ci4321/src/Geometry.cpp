@@ -5,11 +5,38 @@
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
 
+glm::mat4 Geometry::ModelMatrix(glm::vec3 position, glm::vec3 rotation) const
+{
+    // Creacion de transformaciones. La rotacion se aplica alrededor del pivote
+    glm::mat4 model = glm::mat4(1.0f);
+
+    model = glm::translate(model, position);
+    model = glm::translate(model, pivot);
+
+    model = glm::rotate(model, rotation.x, glm::vec3(1.0, 0.0, 0.0));
+    model = glm::rotate(model, rotation.y, glm::vec3(0.0, 1.0, 0.0));
+    model = glm::rotate(model, rotation.z, glm::vec3(0.0, 0.0, 1.0));
+
+    model = glm::translate(model, -pivot);
+
+    return model;
+}
+
+void Geometry::Draw(const Shader& shader, float alpha)
+{
+    // Interpolacion entre el paso de simulacion anterior y el actual
+    glm::vec3 renderPosition = glm::mix(prevPosition, position, alpha);
+    glm::vec3 renderRotation = glm::mix(prevRotation, rotation, alpha);
+
+    DrawModel(shader, ModelMatrix(renderPosition, renderRotation), layer);
+}
+
 Sphere::Sphere(float radius, int sectorCount, int stackCount, bool full)
 {
     this->radius = radius;
     this->sectorCount = sectorCount;
     this->stackCount = stackCount;
+    this->setSize(glm::vec3(2 * radius, 2 * radius, 2 * radius));
 
     position = glm::vec3(0.0, 0.0, 0.0);
     rotation = glm::vec3(0.0, 0.0, 0.0);
@@ -116,28 +143,29 @@ Sphere::Sphere(float radius, int sectorCount, int stackCount, bool full)
     }
 }
 
-void Sphere::Draw(const Shader& shader)
+void Sphere::DrawModel(const Shader& shader, const glm::mat4& model, int layer)
 {
-    // Creacion de transformaciones
-    glm::mat4 model = glm::mat4(1.0f);
-    
-    model = glm::translate(model, position);
-
-    model = glm::rotate(model, rotation.x, glm::vec3(1.0, 0.0, 0.0));
-    model = glm::rotate(model, rotation.y, glm::vec3(0.0, 1.0, 0.0));
-    model = glm::rotate(model, rotation.z, glm::vec3(0.0, 0.0, 1.0));
-    
     // Recuperacion de las ubicaciones de los uniforms
     unsigned int modelLoc = glGetUniformLocation(shader.ID, "model");
-   
+    unsigned int layerLoc = glGetUniformLocation(shader.ID, "layer");
+
     // Pase de ubicaciones a los shaders
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform1i(layerLoc, layer);
 
+    BindMesh();
+    DrawMesh();
+}
+
+void Sphere::BindMesh() const
+{
     glBindVertexArray(VAO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+}
 
+void Sphere::DrawMesh() const
+{
     glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, (void*)0);
-
 }
 
 void Sphere::SetupGL()
@@ -159,10 +187,11 @@ void Sphere::SetupGL()
     glEnableVertexAttribArray(1);
     glEnableVertexAttribArray(2);
 
-    // Setear los atributos en el orden indicado (posicion, normales, coord Text) 
+    // Los datos van (posicion, normales, coord Text); las ubicaciones son
+    // las de VertexShader.vs: 0 posicion, 1 coord Text, 2 normales
     glVertexAttribPointer(0, 3, GL_FLOAT, false, 8 * sizeof(float), (void*)0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, false, 8 * sizeof(float), (void*)(sizeof(float) * 3));
-    glVertexAttribPointer(2, 2, GL_FLOAT, false, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+    glVertexAttribPointer(2, 3, GL_FLOAT, false, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+    glVertexAttribPointer(1, 2, GL_FLOAT, false, 8 * sizeof(float), (void*)(sizeof(float) * 6));
 
     // Unbind de los buffers para limpiar futuras figuras
     glBindVertexArray(0);
@@ -177,13 +206,13 @@ void Sphere::CleanGL()
     glDeleteBuffers(1, &IBO);
 }
 
-void Sphere::moveForward() {
-    glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.01f);
+void Sphere::moveForward(float distance) {
+    glm::vec3 translation = glm::vec3(0.0f, 0.0f, distance);
     position += translation;
 }
 
-void Sphere::moveBackwards() {
-    glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.01f);
+void Sphere::moveBackwards(float distance) {
+    glm::vec3 translation = glm::vec3(0.0f, 0.0f, distance);
     position -= translation;
 }
 
@@ -268,28 +297,29 @@ Cube::Cube(float width, float height, float depth)
 
 };
 
-void Cube::Draw(const Shader& shader)
+void Cube::DrawModel(const Shader& shader, const glm::mat4& model, int layer)
 {
-    // Creacion de transformaciones
-    glm::mat4 model = glm::mat4(1.0f); 
-   
-    model = glm::translate(model, position);
-
-    model = glm::rotate(model, rotation.x, glm::vec3(1.0, 0.0, 0.0));
-    model = glm::rotate(model, rotation.y, glm::vec3(0.0, 1.0, 0.0));
-    model = glm::rotate(model, rotation.z, glm::vec3(0.0, 0.0, 1.0));
-
     // Recuperacion de las ubicaciones de los uniforms
     unsigned int modelLoc = glGetUniformLocation(shader.ID, "model");
+    unsigned int layerLoc = glGetUniformLocation(shader.ID, "layer");
 
     // Pase de ubicaciones a los shaders
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform1i(layerLoc, layer);
 
+    BindMesh();
+    DrawMesh();
+}
+
+void Cube::BindMesh() const
+{
     glBindVertexArray(VAO);
+}
 
+void Cube::DrawMesh() const
+{
     // Dibujamos el cubo
     glDrawArrays(GL_TRIANGLES, 0, 36);
-
 }
 
 void Cube::SetupGL()
@@ -300,17 +330,35 @@ void Cube::SetupGL()
     // Iniciamos el proceso de binding/vinculacion
     glBindVertexArray(VAO);
 
+    // Se agrega la normal de cada cara; los vertices vienen de a 6 por cara,
+    // en el orden de 'attributes'
+    const glm::vec3 faceNormals[6] = {
+        glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+        glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)
+    };
+    std::vector<float> vertices;
+    for (int i = 0; i < 36; i++) {
+        vertices.insert(vertices.end(), attributes.begin() + i * 5, attributes.begin() + (i + 1) * 5);
+        glm::vec3 normal = faceNormals[i / 6];
+        vertices.insert(vertices.end(), { normal.x, normal.y, normal.z });
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, (unsigned int)attributes.size() * sizeof(float), attributes.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, (unsigned int)vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
     // Atributos de posicion
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
     // Atributos de coordenadas de texturas
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
+    // Atributos de normales
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
     // Unbind de los buffers para limpiar futuras figuras
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -322,23 +370,23 @@ void Cube::CleanGL()
     glDeleteBuffers(1, &VBO);
 }
 
-void Cube::moveForward() {
-    glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.01f);
+void Cube::moveForward(float distance) {
+    glm::vec3 translation = glm::vec3(0.0f, 0.0f, distance);
     position += translation;
 }
 
-void Cube::moveBackwards() {
-    glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.01f);
+void Cube::moveBackwards(float distance) {
+    glm::vec3 translation = glm::vec3(0.0f, 0.0f, distance);
     position -= translation;
 }
 
-void Cube::moveRight() {
-    glm::vec3 translation = glm::vec3(0.01f, 0.0f, 0.0f);
+void Cube::moveRight(float distance) {
+    glm::vec3 translation = glm::vec3(distance, 0.0f, 0.0f);
     position += translation;
 }
 
-void Cube::moveLeft() {
-    glm::vec3 translation = glm::vec3(0.01f, 0.0f, 0.0f);
+void Cube::moveLeft(float distance) {
+    glm::vec3 translation = glm::vec3(distance, 0.0f, 0.0f);
     position -= translation;
 }
 
@@ -515,10 +563,11 @@ void Cylinder::SetupGL() {
     glEnableVertexAttribArray(1);
     glEnableVertexAttribArray(2);
 
-    // Setear los atributos en el orden indicado (posicion, normales, coord Text) 
+    // Los datos van (posicion, normales, coord Text); las ubicaciones son
+    // las de VertexShader.vs: 0 posicion, 1 coord Text, 2 normales
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
 
     // Unbind de los buffers para limpiar futuras figuras
     glBindVertexArray(0);
@@ -533,55 +582,29 @@ void Cylinder::CleanGL()
     glDeleteBuffers(1, &IBO);
 }
 
-void Cylinder::Draw(const Shader& shader)
+void Cylinder::DrawModel(const Shader& shader, const glm::mat4& model, int layer)
 {
-    // Creacion de transformaciones
-    glm::mat4 model = glm::mat4(1.0f);
-
-    model = glm::translate(model, position);
-
-    model = glm::rotate(model, rotation.x, glm::vec3(1.0, 0.0, 0.0));
-    model = glm::rotate(model, rotation.y, glm::vec3(0.0, 1.0, 0.0));
-    model = glm::rotate(model, rotation.z, glm::vec3(0.0, 0.0, 1.0));
-
     // Recuperacion de las ubicaciones de los uniforms
     unsigned int modelLoc = glGetUniformLocation(shader.ID, "model");
+    unsigned int layerLoc = glGetUniformLocation(shader.ID, "layer");
 
     // Pase de ubicaciones a los shaders
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform1i(layerLoc, layer);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-
-    glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, (void*)0);
-
+    BindMesh();
+    DrawMesh();
 }
 
-void Cylinder::DrawCanon(const Shader& shader)
+void Cylinder::BindMesh() const
 {
-    // Creacion de transformaciones
-    glm::mat4 model = glm::mat4(1.0f);
-
-    model = glm::translate(model, position);
-    glm::vec3 pivot = glm::vec3(0.0f, 0.0f, -1.0f);
-    model = glm::translate(model, pivot);
-    model = glm::rotate(model, rotation.x, glm::vec3(1.0, 0.0, 0.0));
-    model = glm::rotate(model, rotation.y, glm::vec3(0.0, 1.0, 0.0));
-    model = glm::rotate(model, rotation.z, glm::vec3(0.0, 0.0, 1.0));
-    
-    model = glm::translate(model, -pivot);
-
-    // Recuperacion de las ubicaciones de los uniforms
-    unsigned int modelLoc = glGetUniformLocation(shader.ID, "model");
-
-    // Pase de ubicaciones a los shaders
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
     glBindVertexArray(VAO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+}
 
+void Cylinder::DrawMesh() const
+{
     glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, (void*)0);
-
 }
 
 void Cylinder::DrawProjectile(const Shader& shader,glm::vec3 canonPosition)
@@ -599,9 +622,11 @@ void Cylinder::DrawProjectile(const Shader& shader,glm::vec3 canonPosition)
 
     // Recuperacion de las ubicaciones de los uniforms
     unsigned int modelLoc = glGetUniformLocation(shader.ID, "model");
+    unsigned int layerLoc = glGetUniformLocation(shader.ID, "layer");
 
     // Pase de ubicaciones a los shaders
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform1i(layerLoc, layer);
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
@@ -611,12 +636,12 @@ void Cylinder::DrawProjectile(const Shader& shader,glm::vec3 canonPosition)
 
 }
 
-void Cylinder::moveForward() {
-    glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.01f);
+void Cylinder::moveForward(float distance) {
+    glm::vec3 translation = glm::vec3(0.0f, 0.0f, distance);
     position += translation;
 }
 
-void Cylinder::moveBackwards() {
-    glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.01f);
+void Cylinder::moveBackwards(float distance) {
+    glm::vec3 translation = glm::vec3(0.0f, 0.0f, distance);
     position -= translation;
 }
\ No newline at end of file
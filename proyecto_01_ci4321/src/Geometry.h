@@ -12,21 +12,47 @@ const double PI = numbers::pi;
 class Geometry
 {
 public:
-	unsigned int VBO, VAO;
+	unsigned int VBO = 0, VAO = 0;
 	std::vector<float> attributes;
 	glm::vec3 position;
 	glm::vec3 rotation;
-	glm::vec3 pivot;
+	glm::vec3 pivot = glm::vec3(0.0f); // centro de rotacion, relativo a position
 	glm::vec3 size; // width, height, depth
+	int layer = 0; // capa del arreglo de texturas de materiales
+	bool visible = true;
+	// No se mueve despues de crearse; su sombra se guarda en cache
+	bool isStatic = false;
+
+	// Estado del paso de simulacion anterior, para interpolar al dibujar
+	glm::vec3 prevPosition = glm::vec3(0.0f);
+	glm::vec3 prevRotation = glm::vec3(0.0f);
+
+	// Las partes de un tanque se liberan desde su tipo concreto; no libera GL
+	virtual ~Geometry() = default;
 
 	virtual void SetupGL() = 0;
 	virtual void CleanGL() = 0;
-	virtual void Draw(const Shader& shader) = 0;
-
+	// Emite el dibujo con una matriz de modelo ya calculada. Solo toca GL, no
+	// lee el estado de simulacion, asi que el hilo de render puede llamarla
+	// con transformaciones sacadas de un FrameSnapshot
+	virtual void DrawModel(const Shader& shader, const glm::mat4& model, int layer) = 0;
+	// Vincula la malla; varios DrawMesh seguidos la reutilizan sin volver
+	// a vincularla (lo aprovecha RenderQueue)
+	virtual void BindMesh() const = 0;
+	// Emite el dibujo de la malla ya vinculada, con los uniforms que haya
+	virtual void DrawMesh() const = 0;
+
+	// alpha: fraccion del paso de simulacion transcurrida (0 = anterior, 1 = actual)
+	void Draw(const Shader& shader, float alpha = 1.0f);
+
+	// translate(position) * rotaciones alrededor del pivote
+	glm::mat4 ModelMatrix(glm::vec3 position, glm::vec3 rotation) const;
+
+	// SetPosition/SetRotation colocan el objeto sin interpolar desde donde estaba
 	inline void SetPosition(glm::vec3 newPos) 
 	{
 		position = newPos;
-
+		prevPosition = newPos;
 	};
 
 	inline glm::vec3 getPosition()
@@ -37,7 +63,14 @@ public:
 	inline void SetRotation(glm::vec3 newRot)
 	{
 		rotation = newRot;
+		prevRotation = newRot;
+	};
 
+	// Se llama al inicio de cada paso de simulacion
+	inline void SaveState()
+	{
+		prevPosition = position;
+		prevRotation = rotation;
 	};
 
 	inline void setPivot(glm::vec3 newPivot) 
@@ -53,6 +86,11 @@ public:
 		return size;
 	}
 
+	inline void SetLayer(int newLayer)
+	{
+		layer = newLayer;
+	};
+
 };
 
 class Sphere : public Geometry
@@ -69,9 +107,11 @@ public:
 
 	void SetupGL() override;
 	void CleanGL() override;
-	void Draw(const Shader& shader) override;
-	void moveForward();
-	void moveBackwards();
+	void DrawModel(const Shader& shader, const glm::mat4& model, int layer) override;
+	void BindMesh() const override;
+	void DrawMesh() const override;
+	void moveForward(float distance);
+	void moveBackwards(float distance);
 };
 
 class Cube : public Geometry
@@ -86,11 +126,13 @@ public:
 
 	void SetupGL() override;
 	void CleanGL() override;
-	void Draw(const Shader& shader) override;
-	void moveForward();
-	void moveBackwards();
-	void moveRight();
-	void moveLeft();
+	void DrawModel(const Shader& shader, const glm::mat4& model, int layer) override;
+	void BindMesh() const override;
+	void DrawMesh() const override;
+	void moveForward(float distance);
+	void moveBackwards(float distance);
+	void moveRight(float distance);
+	void moveLeft(float distance);
 };
 
 class Cylinder : public Geometry
@@ -110,11 +152,12 @@ public:
 
 	void SetupGL() override;
 	void CleanGL() override;
-	void Draw(const Shader& shader) override;
-	void DrawCanon(const Shader& shader);
+	void DrawModel(const Shader& shader, const glm::mat4& model, int layer) override;
+	void BindMesh() const override;
+	void DrawMesh() const override;
 	void DrawProjectile(const Shader& shader, glm::vec3 canonPosition);
-	void moveForward();
-	void moveBackwards();
+	void moveForward(float distance);
+	void moveBackwards(float distance);
 };
 
 
@@ -0,0 +1,129 @@
+#include "Heightmap.h"
+#include "stb_image/stb_image.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Zona plana alrededor del origen: hasta flatRadius no hay relieve y llega
+// completo en hillRadius
+const float flatRadius = 48.0f;
+const float hillRadius = 160.0f;
+
+// Longitud de onda de la primera octava, en unidades del mundo
+const float noiseWavelength = 256.0f;
+const int noiseOctaves = 6;
+
+static float lattice(int x, int z, unsigned int seed)
+{
+	uint32_t hash = (uint32_t)x * 0x8DA6B343u ^ (uint32_t)z * 0xD8163841u ^ seed * 0xCB1AB31Fu;
+	hash ^= hash >> 13;
+	hash *= 0x5BD1E995u;
+	hash ^= hash >> 15;
+	return (hash & 0xFFFFFF) / (float)0xFFFFFF;
+}
+
+static float valueNoise(float x, float z, unsigned int seed)
+{
+	int x0 = (int)floorf(x), z0 = (int)floorf(z);
+	float tx = x - x0, tz = z - z0;
+	tx = tx * tx * (3.0f - 2.0f * tx);
+	tz = tz * tz * (3.0f - 2.0f * tz);
+
+	float top = glm::mix(lattice(x0, z0, seed), lattice(x0 + 1, z0, seed), tx);
+	float bottom = glm::mix(lattice(x0, z0 + 1, seed), lattice(x0 + 1, z0 + 1, seed), tx);
+	return glm::mix(top, bottom, tz);
+}
+
+void Heightmap::Generate(int size, float cellSize, float baseHeight, float amplitude, unsigned int seed)
+{
+	this->size = size;
+	this->cellSize = cellSize;
+	heights.resize((size_t)size * size);
+
+	glm::vec2 origin = Origin();
+	for (int z = 0; z < size; z++) {
+		for (int x = 0; x < size; x++) {
+			glm::vec2 world = origin + glm::vec2(x, z) * cellSize;
+
+			float value = 0.0f, weight = 0.5f, total = 0.0f;
+			glm::vec2 point = world / noiseWavelength;
+			for (int octave = 0; octave < noiseOctaves; octave++) {
+				value += valueNoise(point.x, point.y, seed + octave) * weight;
+				total += weight;
+				weight *= 0.5f;
+				point *= 2.0f;
+			}
+
+			float mask = glm::smoothstep(flatRadius, hillRadius, glm::length(world));
+			heights[(size_t)z * size + x] = baseHeight + amplitude * (value / total) * mask;
+		}
+	}
+}
+
+bool Heightmap::Load(const string& path, int size, float cellSize, float baseHeight, float amplitude)
+{
+	int width, height, channels;
+	unsigned short* data = stbi_load_16(path.c_str(), &width, &height, &channels, 1);
+	if (!data) {
+		LOG_WARNING("Heightmap: could not load {}", path);
+		return false;
+	}
+
+	this->size = size;
+	this->cellSize = cellSize;
+	heights.resize((size_t)size * size);
+
+	// Reescalado bilineal de la imagen a la grilla pedida
+	for (int z = 0; z < size; z++) {
+		float v = (float)z / (size - 1) * (height - 1);
+		int v0 = min((int)v, height - 1), v1 = min(v0 + 1, height - 1);
+		float tv = v - v0;
+		for (int x = 0; x < size; x++) {
+			float u = (float)x / (size - 1) * (width - 1);
+			int u0 = min((int)u, width - 1), u1 = min(u0 + 1, width - 1);
+			float tu = u - u0;
+
+			float top = glm::mix((float)data[(size_t)v0 * width + u0], (float)data[(size_t)v0 * width + u1], tu);
+			float bottom = glm::mix((float)data[(size_t)v1 * width + u0], (float)data[(size_t)v1 * width + u1], tu);
+			heights[(size_t)z * size + x] = baseHeight + amplitude * glm::mix(top, bottom, tv) / 65535.0f;
+		}
+	}
+
+	stbi_image_free(data);
+	return true;
+}
+
+float Heightmap::Height(float x, float z) const
+{
+	if (size == 0) {
+		return 0.0f;
+	}
+
+	glm::vec2 grid = (glm::vec2(x, z) - Origin()) / cellSize;
+	grid = glm::clamp(grid, glm::vec2(0.0f), glm::vec2((float)(size - 1)));
+
+	int x0 = min((int)grid.x, size - 2);
+	int z0 = min((int)grid.y, size - 2);
+	float tx = grid.x - x0, tz = grid.y - z0;
+
+	const float* row = &heights[(size_t)z0 * size + x0];
+	float top = row[0] + (row[1] - row[0]) * tx;
+	float bottom = row[size] + (row[size + 1] - row[size]) * tx;
+	return top + (bottom - top) * tz;
+}
+
+glm::vec2 Heightmap::Range(int x0, int z0, int x1, int z1) const
+{
+	glm::vec2 range(heights[(size_t)z0 * size + x0]);
+	for (int z = z0; z <= z1; z++) {
+		for (int x = x0; x <= x1; x++) {
+			float value = heights[(size_t)z * size + x];
+			range.x = min(range.x, value);
+			range.y = max(range.y, value);
+		}
+	}
+	return range;
+}
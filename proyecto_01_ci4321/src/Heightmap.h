@@ -0,0 +1,73 @@
+#ifndef HEIGHTMAP_H
+#define HEIGHTMAP_H
+
+#include <glm.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Alturas en una grilla regular de size x size muestras, centrada en el
+// origen del mundo en xz, separadas 'cellSize' unidades. No usa GL: la
+// simulacion la consulta para apoyar los tanques en el suelo y Terrain la
+// sube como textura para el vertex shader.
+class Heightmap
+{
+public:
+
+	// Terreno procedural (ruido de valor fractal) de size x size muestras.
+	// Cerca del origen queda plano a 'baseHeight', para la escena inicial
+	void Generate(int size, float cellSize, float baseHeight, float amplitude, unsigned int seed);
+
+	// Imagen en escala de grises (8 o 16 bits), reescalada a size x size.
+	// El negro queda a 'baseHeight' y el blanco a baseHeight + amplitude
+	bool Load(const string& path, int size, float cellSize, float baseHeight, float amplitude);
+
+	// Altura en (x, z) con interpolacion bilineal; fuera del mapa se usa el
+	// borde. Es O(1): dos lecturas de fila y una mezcla
+	float Height(float x, float z) const;
+
+	// Altura minima y maxima en el rectangulo de muestras [x0, x1] x [z0, z1]
+	glm::vec2 Range(int x0, int z0, int x1, int z1) const;
+
+	inline int Size() const
+	{
+		return size;
+	};
+
+	inline float CellSize() const
+	{
+		return cellSize;
+	};
+
+	// Lado del mapa en unidades del mundo
+	inline float Extent() const
+	{
+		return (size - 1) * cellSize;
+	};
+
+	// Esquina (x, z) minima del mapa
+	inline glm::vec2 Origin() const
+	{
+		return glm::vec2(-Extent() * 0.5f);
+	};
+
+	inline const float* Data() const
+	{
+		return heights.data();
+	};
+
+	inline float Sample(int x, int z) const
+	{
+		return heights[(size_t)z * size + x];
+	};
+
+private:
+
+	int size = 0;
+	float cellSize = 1.0f;
+	vector<float> heights;
+};
+
+#endif
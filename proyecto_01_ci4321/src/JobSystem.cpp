@@ -0,0 +1,219 @@
+#include "JobSystem.h"
+
+// Potencia de dos, al menos la capacidad de una cola
+const int jobPoolSize = 8192;
+
+// Indice del hilo actual dentro del sistema, -1 si no pertenece a ninguno
+static thread_local int threadIndex = -1;
+static thread_local const JobSystem* threadSystem = NULL;
+
+bool JobSystem::WorkStealingQueue::Push(Job* job)
+{
+	long long b = bottom.load(memory_order_relaxed);
+	long long t = top.load(memory_order_acquire);
+	if (b - t >= capacity) {
+		return false;
+	}
+
+	buffer[b & (capacity - 1)].store(job, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	bottom.store(b + 1, memory_order_relaxed);
+	return true;
+}
+
+JobSystem::Job* JobSystem::WorkStealingQueue::Pop()
+{
+	long long b = bottom.load(memory_order_relaxed) - 1;
+	bottom.store(b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long long t = top.load(memory_order_relaxed);
+
+	if (t > b) {
+		// Cola vacia
+		bottom.store(b + 1, memory_order_relaxed);
+		return NULL;
+	}
+
+	Job* job = buffer[b & (capacity - 1)].load(memory_order_relaxed);
+	if (t == b) {
+		// Ultimo elemento: se compite con los ladrones por el
+		if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+			job = NULL;
+		}
+		bottom.store(b + 1, memory_order_relaxed);
+	}
+	return job;
+}
+
+JobSystem::Job* JobSystem::WorkStealingQueue::Steal()
+{
+	long long t = top.load(memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long long b = bottom.load(memory_order_acquire);
+
+	if (t >= b) {
+		return NULL;
+	}
+
+	Job* job = buffer[t & (capacity - 1)].load(memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+		return NULL;
+	}
+	return job;
+}
+
+JobSystem::JobSystem(int workerCount)
+{
+	for (int i = 0; i <= workerCount; i++) {
+		threads.push_back(make_unique<ThreadData>());
+		threads[i]->pool = vector<Job>(jobPoolSize);
+	}
+
+	threadIndex = 0;
+	threadSystem = this;
+
+	for (int i = 1; i <= workerCount; i++) {
+		workers.push_back(thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		lock_guard<mutex> guard(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (thread& worker : workers) {
+		worker.join();
+	}
+
+	if (threadSystem == this) {
+		threadIndex = -1;
+		threadSystem = NULL;
+	}
+}
+
+int JobSystem::CurrentThread() const
+{
+	return threadSystem == this ? threadIndex : -1;
+}
+
+void JobSystem::Run(function<void()> task, JobCounter& counter)
+{
+	int index = CurrentThread();
+	counter.pending.fetch_add(1, memory_order_relaxed);
+
+	// Desde un hilo ajeno al sistema, sin trabajo libre o con la cola llena,
+	// se ejecuta en linea
+	Job* job = NULL;
+	if (index >= 0) {
+		ThreadData& data = *threads[index];
+		Job* next = &data.pool[data.nextJob & (data.pool.size() - 1)];
+		if (!next->busy.load(memory_order_acquire)) {
+			job = next;
+			data.nextJob++;
+		}
+	}
+	if (!job) {
+		task();
+		counter.pending.fetch_sub(1, memory_order_release);
+		return;
+	}
+
+	ThreadData& data = *threads[index];
+	job->task = move(task);
+	job->counter = &counter;
+	job->busy.store(true, memory_order_relaxed);
+
+	if (!data.queue.Push(job)) {
+		Execute(job);
+		return;
+	}
+
+	queuedJobs.fetch_add(1, memory_order_seq_cst);
+	if (sleeping.load(memory_order_seq_cst) > 0) {
+		lock_guard<mutex> guard(sleepMutex);
+		wake.notify_one();
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	int index = CurrentThread();
+
+	while (counter.pending.load(memory_order_acquire) > 0) {
+		Job* job = index >= 0 ? FindJob(index) : NULL;
+		if (job) {
+			Execute(job);
+		}
+		else {
+			this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(int count, int batchSize, const function<void(int, int)>& body)
+{
+	if (count <= 0) {
+		return;
+	}
+
+	// Unos cuantos lotes por hilo para que el robo reparta la carga
+	int batches = (int)threads.size() * 4;
+	int size = max(batchSize, (count + batches - 1) / batches);
+
+	JobCounter counter;
+	for (int begin = 0; begin < count; begin += size) {
+		int end = min(count, begin + size);
+		Run([&body, begin, end] { body(begin, end); }, counter);
+	}
+	Wait(counter);
+}
+
+JobSystem::Job* JobSystem::FindJob(int index)
+{
+	Job* job = threads[index]->queue.Pop();
+
+	// Sin trabajo propio se roba de los demas, empezando por el siguiente
+	int count = (int)threads.size();
+	for (int i = 1; !job && i < count; i++) {
+		job = threads[(index + i) % count]->queue.Steal();
+	}
+
+	if (job) {
+		queuedJobs.fetch_sub(1, memory_order_relaxed);
+	}
+	return job;
+}
+
+void JobSystem::Execute(Job* job)
+{
+	JobCounter* counter = job->counter;
+	job->task();
+	// Se libera antes de avisar, con el contador ya copiado: en cuanto
+	// esta libre el duenno puede reutilizarlo
+	job->busy.store(false, memory_order_release);
+	counter->pending.fetch_sub(1, memory_order_release);
+}
+
+void JobSystem::WorkerLoop(int index)
+{
+	threadIndex = index;
+	threadSystem = this;
+
+	while (!stopping) {
+		Job* job = FindJob(index);
+		if (job) {
+			Execute(job);
+			continue;
+		}
+
+		// Sin trabajo en ninguna cola se duerme hasta que se encole algo
+		unique_lock<mutex> guard(sleepMutex);
+		sleeping.fetch_add(1, memory_order_seq_cst);
+		wake.wait(guard, [this] { return stopping || queuedJobs.load(memory_order_seq_cst) > 0; });
+		sleeping.fetch_sub(1, memory_order_relaxed);
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Cuenta los trabajos pendientes de un grupo. Wait() sobre el contador es la
+// forma de expresar dependencias: la etapa siguiente se lanza al volver
+struct JobCounter
+{
+	atomic<int> pending{ 0 };
+};
+
+// Planificador de trabajos con robo de tareas. Cada hilo tiene una cola
+// Chase-Lev: el duenno apila y desapila por abajo sin locks y los demas roban
+// por arriba cuando se quedan sin trabajo. El hilo que crea el sistema es el
+// hilo 0 y ejecuta trabajos mientras espera; solo ese hilo y los trabajadores
+// pueden lanzar trabajos.
+class JobSystem
+{
+public:
+
+	// 'workerCount' hilos ademas del que crea el sistema (puede ser 0)
+	JobSystem(int workerCount);
+	~JobSystem();
+
+	void Run(function<void()> task, JobCounter& counter);
+
+	// Ejecuta trabajos pendientes hasta que el contador llegue a cero
+	void Wait(JobCounter& counter);
+
+	// Parte [0, count) en lotes de al menos 'batchSize' elementos, llama a
+	// body(begin, end) en paralelo y espera a que terminen todos
+	void ParallelFor(int count, int batchSize, const function<void(int, int)>& body);
+
+	inline int ThreadCount() const
+	{
+		return (int)threads.size();
+	};
+
+private:
+
+	struct Job
+	{
+		function<void()> task;
+		JobCounter* counter;
+		// Encolado o en ejecucion; el duenno no lo reutiliza hasta que termine
+		atomic<bool> busy{ false };
+	};
+
+	// Cola de Chase-Lev de capacidad fija (Le, Pop, Cohen y Nardelli 2013)
+	class WorkStealingQueue
+	{
+	public:
+		bool Push(Job* job);
+		Job* Pop();
+		Job* Steal();
+
+	private:
+		static const int capacity = 4096;
+		atomic<long long> top{ 0 };
+		atomic<long long> bottom{ 0 };
+		atomic<Job*> buffer[capacity] = {};
+	};
+
+	struct ThreadData
+	{
+		WorkStealingQueue queue;
+		// Los trabajos se toman en anillo. Un trabajo robado puede seguir
+		// ejecutandose cuando el anillo da la vuelta: si el siguiente esta
+		// ocupado, la tarea nueva se ejecuta en linea
+		vector<Job> pool;
+		unsigned int nextJob = 0;
+	};
+
+	void WorkerLoop(int index);
+	Job* FindJob(int index);
+	void Execute(Job* job);
+	int CurrentThread() const;
+
+	vector<unique_ptr<ThreadData>> threads;
+	vector<thread> workers;
+
+	atomic<int> queuedJobs{ 0 };
+	atomic<int> sleeping{ 0 };
+	atomic<bool> stopping{ false };
+	mutex sleepMutex;
+	condition_variable wake;
+};
+
+#endif
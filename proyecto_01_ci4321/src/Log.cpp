@@ -0,0 +1,283 @@
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Registros por hilo; potencia de dos
+const unsigned int logRingSize = 512;
+
+// Cada cuanto revisa los anillos el hilo de fondo
+const chrono::milliseconds logPollInterval(5);
+
+static const char* levelNames[] = { "TRACE", "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+// Un productor (el hilo duenno) y un consumidor (el hilo de fondo)
+struct LogRing
+{
+	LogRecord records[logRingSize];
+	atomic<unsigned int> head = 0; // lo escribe el productor
+	atomic<unsigned int> tail = 0; // lo escribe el consumidor
+	atomic<unsigned int> dropped = 0;
+	// El hilo duenno termino; se quita despues de escribir lo que quede
+	atomic<bool> retired = false;
+};
+
+class Logger
+{
+public:
+
+	Logger()
+	{
+		start = chrono::steady_clock::now();
+		passesStarted = 0;
+		passesDone = 0;
+		running = true;
+		worker = thread(&Logger::ThreadLoop, this);
+	}
+
+	// Al salir del programa se escribe lo pendiente
+	~Logger()
+	{
+		running = false;
+		worker.join();
+		Drain();
+	}
+
+	LogRing* Register()
+	{
+		lock_guard<mutex> guard(ringsMutex);
+		rings.push_back(make_unique<LogRing>());
+		return rings.back().get();
+	}
+
+	long long Now() const
+	{
+		return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+	}
+
+	// Espera a que termine una pasada del hilo de fondo que haya empezado
+	// despues de llamar: esa pasada ya vio todo lo publicado hasta ahora. No
+	// guarda punteros a los anillos, que pueden quitarse mientras espera
+	void Flush()
+	{
+		unsigned long long target = passesStarted.load(memory_order_acquire) + 1;
+
+		unique_lock<mutex> guard(flushMutex);
+		flushed.wait(guard, [&] {
+			return passesDone >= target || !running;
+		});
+	}
+
+private:
+
+	void ThreadLoop()
+	{
+		while (running) {
+			if (!Drain()) {
+				this_thread::sleep_for(logPollInterval);
+			}
+		}
+	}
+
+	// Junta los registros de todos los anillos, los ordena por hora y los
+	// escribe de una vez. Devuelve true si habia algo
+	bool Drain()
+	{
+		batch.clear();
+		unsigned long long pass;
+		{
+			lock_guard<mutex> guard(ringsMutex);
+			pass = passesStarted.fetch_add(1, memory_order_acq_rel) + 1;
+			for (unique_ptr<LogRing>& ring : rings) {
+				// Se lee antes que head: si el hilo ya termino, todo lo que
+				// publico se junta en esta pasada
+				bool retired = ring->retired.load(memory_order_acquire);
+				unsigned int tail = ring->tail.load(memory_order_relaxed);
+				unsigned int head = ring->head.load(memory_order_acquire);
+				for (; tail != head; tail++) {
+					batch.push_back(ring->records[tail & (logRingSize - 1)]);
+				}
+				ring->tail.store(tail, memory_order_release);
+
+				unsigned int dropped = ring->dropped.exchange(0, memory_order_relaxed);
+				if (dropped > 0) {
+					LogRecord notice = {};
+					notice.time = Now();
+					notice.format = "log ring full, {} records dropped";
+					notice.level = LOG_LEVEL_WARNING;
+					logPack(notice, dropped);
+					batch.push_back(notice);
+				}
+				if (retired) {
+					ring.reset();
+				}
+			}
+			rings.erase(remove(rings.begin(), rings.end(), nullptr), rings.end());
+		}
+		size_t count = batch.size();
+
+		if (count > 0) {
+			stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) { return a.time < b.time; });
+
+			output.clear();
+			for (const LogRecord& record : batch) {
+				Format(record, output);
+			}
+			cout << output << flush;
+		}
+
+		{
+			// Bajo el lock, si no un Flush podria perderse la notificacion
+			lock_guard<mutex> guard(flushMutex);
+			passesDone = pass;
+		}
+		flushed.notify_all();
+		return count > 0;
+	}
+
+	void Format(const LogRecord& record, string& out)
+	{
+		char prefix[48];
+		snprintf(prefix, sizeof(prefix), "[%10.4f] %s ", record.time / 1e9, levelNames[min((int)record.level, 4)]);
+		out += prefix;
+
+		int argument = 0;
+		for (const char* c = record.format; *c; c++) {
+			if (c[0] == '{' && c[1] == '}' && argument < record.argumentCount) {
+				FormatArgument(record, argument++, out);
+				c++;
+			}
+			else {
+				out += *c;
+			}
+		}
+		out += '\n';
+	}
+
+	void FormatArgument(const LogRecord& record, int index, string& out)
+	{
+		char buffer[32];
+		switch (record.types[index])
+		{
+		case LOG_ARGUMENT_INTEGER:
+			snprintf(buffer, sizeof(buffer), "%lld", record.values[index].integer);
+			out += buffer;
+			break;
+		case LOG_ARGUMENT_UNSIGNED:
+			snprintf(buffer, sizeof(buffer), "%llu", record.values[index].unsignedInteger);
+			out += buffer;
+			break;
+		case LOG_ARGUMENT_REAL:
+			snprintf(buffer, sizeof(buffer), "%g", record.values[index].real);
+			out += buffer;
+			break;
+		case LOG_ARGUMENT_BOOL:
+			out += record.values[index].integer ? "true" : "false";
+			break;
+		case LOG_ARGUMENT_TEXT:
+			out += record.text + record.values[index].textOffset;
+			break;
+		}
+	}
+
+	chrono::steady_clock::time_point start;
+	atomic<bool> running;
+	thread worker;
+
+	mutex ringsMutex;
+	vector<unique_ptr<LogRing>> rings;
+
+	// Pasadas de Drain empezadas y terminadas, para Flush
+	atomic<unsigned long long> passesStarted;
+	mutex flushMutex;
+	unsigned long long passesDone;
+	condition_variable flushed;
+
+	vector<LogRecord> batch;
+	string output;
+};
+
+static Logger& logger()
+{
+	static Logger instance;
+	return instance;
+}
+
+// El anillo se registra la primera vez que el hilo escribe; es la unica
+// vez que se toma un lock desde el hilo que registra. Cuando el hilo
+// termina se marca, y el hilo de fondo lo quita tras escribir lo pendiente
+struct ThreadRing
+{
+	LogRing* ring = NULL;
+
+	~ThreadRing()
+	{
+		if (ring) {
+			ring->retired.store(true, memory_order_release);
+			ring = NULL;
+		}
+	}
+};
+
+static thread_local ThreadRing threadRing;
+
+LogRecord* logAcquire()
+{
+	Logger& log = logger();
+	if (!threadRing.ring) {
+		threadRing.ring = log.Register();
+	}
+	LogRing* ring = threadRing.ring;
+
+	unsigned int head = ring->head.load(memory_order_relaxed);
+	if (head - ring->tail.load(memory_order_acquire) >= logRingSize) {
+		ring->dropped.fetch_add(1, memory_order_relaxed);
+		return NULL;
+	}
+
+	LogRecord* record = &ring->records[head & (logRingSize - 1)];
+	record->time = log.Now();
+	return record;
+}
+
+void logPublish()
+{
+	LogRing* ring = threadRing.ring;
+	ring->head.store(ring->head.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+void logPack(LogRecord& record, const char* value)
+{
+	if (record.argumentCount >= logMaxArguments) {
+		return;
+	}
+
+	// Se trunca para que entre en el espacio que queda, con su terminador
+	size_t space = logTextSize - record.textUsed;
+	size_t length = value ? strlen(value) : 0;
+	if (space == 0) {
+		return;
+	}
+	length = min(length, space - 1);
+
+	record.types[record.argumentCount] = LOG_ARGUMENT_TEXT;
+	record.values[record.argumentCount++].textOffset = record.textUsed;
+	if (length > 0) {
+		memcpy(record.text + record.textUsed, value, length);
+	}
+	record.text[record.textUsed + length] = '\0';
+	record.textUsed += (unsigned short)(length + 1);
+}
+
+void flushLog()
+{
+	logger().Flush();
+}
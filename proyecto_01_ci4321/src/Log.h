@@ -0,0 +1,159 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <string>
+
+using namespace std;
+
+// Registro asincrono. Cada hilo escribe registros binarios (formato, hora y
+// argumentos sin formatear) en su propio anillo sin locks ni esperas; un
+// hilo de fondo los junta, les da formato y los escribe en la consola. Si
+// el anillo de un hilo se llena el registro se descarta y se cuenta: el
+// hilo que registra nunca se bloquea.
+//
+// Los niveles por debajo de LOG_MIN_LEVEL desaparecen en compilacion, sin
+// evaluar siquiera los argumentos.
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_ERROR 4
+
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// Los argumentos se reemplazan en orden en cada "{}" del formato, que debe
+// ser un literal (solo se guarda el puntero)
+#if LOG_MIN_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) logWrite(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logWrite(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) logWrite(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) logWrite(LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logWrite(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+const int logMaxArguments = 6;
+const int logTextSize = 96;
+
+enum LogArgumentType
+{
+	LOG_ARGUMENT_INTEGER,
+	LOG_ARGUMENT_UNSIGNED,
+	LOG_ARGUMENT_REAL,
+	LOG_ARGUMENT_BOOL,
+	LOG_ARGUMENT_TEXT // desplazamiento dentro de LogRecord::text
+};
+
+// Registro de tamanno fijo. Los textos se copian (truncados) al final para
+// que el registro no apunte a memoria del hilo que lo escribio
+struct LogRecord
+{
+	long long time; // nanosegundos desde el arranque del registro
+	const char* format;
+	unsigned char level;
+	unsigned char argumentCount;
+	unsigned char types[logMaxArguments];
+	unsigned short textUsed;
+	union
+	{
+		long long integer;
+		unsigned long long unsignedInteger;
+		double real;
+		unsigned short textOffset;
+	} values[logMaxArguments];
+	char text[logTextSize];
+};
+
+// Anillo del hilo actual: devuelve NULL si esta lleno
+LogRecord* logAcquire();
+void logPublish();
+
+// Bloquea hasta que el hilo de fondo escriba todo lo publicado hasta ahora
+void flushLog();
+
+inline void logPack(LogRecord& record, long long value)
+{
+	if (record.argumentCount < logMaxArguments) {
+		record.types[record.argumentCount] = LOG_ARGUMENT_INTEGER;
+		record.values[record.argumentCount++].integer = value;
+	}
+}
+
+inline void logPack(LogRecord& record, unsigned long long value)
+{
+	if (record.argumentCount < logMaxArguments) {
+		record.types[record.argumentCount] = LOG_ARGUMENT_UNSIGNED;
+		record.values[record.argumentCount++].unsignedInteger = value;
+	}
+}
+
+inline void logPack(LogRecord& record, int value) { logPack(record, (long long)value); }
+inline void logPack(LogRecord& record, long value) { logPack(record, (long long)value); }
+inline void logPack(LogRecord& record, unsigned int value) { logPack(record, (unsigned long long)value); }
+inline void logPack(LogRecord& record, unsigned long value) { logPack(record, (unsigned long long)value); }
+
+inline void logPack(LogRecord& record, double value)
+{
+	if (record.argumentCount < logMaxArguments) {
+		record.types[record.argumentCount] = LOG_ARGUMENT_REAL;
+		record.values[record.argumentCount++].real = value;
+	}
+}
+
+inline void logPack(LogRecord& record, float value) { logPack(record, (double)value); }
+
+inline void logPack(LogRecord& record, bool value)
+{
+	if (record.argumentCount < logMaxArguments) {
+		record.types[record.argumentCount] = LOG_ARGUMENT_BOOL;
+		record.values[record.argumentCount++].integer = value;
+	}
+}
+
+void logPack(LogRecord& record, const char* value);
+inline void logPack(LogRecord& record, const string& value) { logPack(record, value.c_str()); }
+
+template <typename... Args>
+void logWrite(int level, const char* format, const Args&... args)
+{
+	LogRecord* record = logAcquire();
+	if (!record) {
+		return;
+	}
+	record->format = format;
+	record->level = (unsigned char)level;
+	record->argumentCount = 0;
+	record->textUsed = 0;
+	(logPack(*record, args), ...);
+	logPublish();
+}
+
+#endif
@@ -0,0 +1,196 @@
+#include "Mipmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIPMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+// Resolucion de la tabla de vuelta a sRGB; 12 bits bastan para que el
+// redondeo a 8 bits no pierda precision en los tonos oscuros
+const int linearSteps = 4096;
+
+struct GammaTables
+{
+	float toLinear[256];
+	unsigned char toSrgb[linearSteps];
+
+	GammaTables()
+	{
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			toLinear[i] = std::min(1.0f, c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f));
+		}
+		for (int i = 0; i < linearSteps; i++) {
+			float l = i / (float)(linearSteps - 1);
+			float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+			toSrgb[i] = (unsigned char)std::min(255.0f, c * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const GammaTables& gammaTables()
+{
+	static const GammaTables tables;
+	return tables;
+}
+
+int mipLevelCount(int width, int height)
+{
+	int levels = 1;
+	int size = std::max(width, height);
+	while (size > 1) {
+		size /= 2;
+		levels++;
+	}
+	return levels;
+}
+
+size_t mipLevelOffset(int width, int height, int level)
+{
+	size_t offset = 0;
+	for (int i = 0; i < level; i++) {
+		offset += (size_t)width * height * 4;
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	return offset;
+}
+
+size_t mipChainSize(int width, int height, int levels)
+{
+	return mipLevelOffset(width, height, levels);
+}
+
+// Pasa una fila sRGB a lineal en float, un texel RGBA por grupo de 4. Las
+// tablas no se pueden leer en paralelo con SSE2, asi que esto es escalar;
+// cada texel se decodifica una sola vez
+static void decodeRow(const unsigned char* src, int w, float* out, const GammaTables& t)
+{
+	for (int i = 0; i < w * 4; i += 4) {
+		out[i + 0] = t.toLinear[src[i + 0]];
+		out[i + 1] = t.toLinear[src[i + 1]];
+		out[i + 2] = t.toLinear[src[i + 2]];
+		out[i + 3] = src[i + 3] / 255.0f;
+	}
+}
+
+// Vuelve una fila lineal a RGBA8 sRGB
+static void encodeRow(const float* src, int w, unsigned char* out, const GammaTables& t)
+{
+	for (int x = 0; x < w; x++) {
+		int idx[4];
+#ifdef MIPMAP_SSE2
+		__m128 scaled = _mm_mul_ps(_mm_loadu_ps(src + x * 4),
+			_mm_setr_ps(linearSteps - 1.0f, linearSteps - 1.0f, linearSteps - 1.0f, 255.0f));
+		_mm_storeu_si128((__m128i*)idx, _mm_cvttps_epi32(_mm_add_ps(scaled, _mm_set1_ps(0.5f))));
+#else
+		for (int c = 0; c < 4; c++) {
+			float scale = c < 3 ? linearSteps - 1.0f : 255.0f;
+			idx[c] = (int)(src[x * 4 + c] * scale + 0.5f);
+		}
+#endif
+		out[x * 4 + 0] = t.toSrgb[idx[0]];
+		out[x * 4 + 1] = t.toSrgb[idx[1]];
+		out[x * 4 + 2] = t.toSrgb[idx[2]];
+		out[x * 4 + 3] = (unsigned char)idx[3];
+	}
+}
+
+// Una fila del nivel siguiente a partir de 'rowCount' filas lineales (1 a
+// 3) de ancho w. El box es de 2x2; en dimensiones impares el ultimo texel
+// de cada eje cubre tambien la fila/columna sobrante (box de 3), asi el
+// borde no se pierde, y en dimension 1 el texel se repite. Cada texel RGBA
+// es un registro; los dos caminos suman en el mismo orden (primero cada
+// columna, despues las columnas) y dan el mismo resultado
+static void filterRow(const float* const rows[3], int rowCount, int w, float* out)
+{
+	int dw = std::max(1, w / 2);
+
+	for (int x = 0; x < dw; x++) {
+		int first = std::min(2 * x, w - 1) * 4;
+		int columns = w == 1 ? 1 : (x == dw - 1 && w % 2 == 1 ? 3 : 2);
+		float scale = 1.0f / (float)(columns * rowCount);
+#ifdef MIPMAP_SSE2
+		if (columns == 2 && rowCount == 2) {
+			// El caso comun, sin lazos
+			__m128 left = _mm_add_ps(_mm_loadu_ps(rows[0] + first), _mm_loadu_ps(rows[1] + first));
+			__m128 right = _mm_add_ps(_mm_loadu_ps(rows[0] + first + 4), _mm_loadu_ps(rows[1] + first + 4));
+			_mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_add_ps(left, right), _mm_set1_ps(0.25f)));
+			continue;
+		}
+		__m128 v = _mm_setzero_ps();
+		for (int c = 0; c < columns; c++) {
+			__m128 column = _mm_loadu_ps(rows[0] + first + c * 4);
+			for (int r = 1; r < rowCount; r++) {
+				column = _mm_add_ps(column, _mm_loadu_ps(rows[r] + first + c * 4));
+			}
+			v = c == 0 ? column : _mm_add_ps(v, column);
+		}
+		_mm_storeu_ps(out + x * 4, _mm_mul_ps(v, _mm_set1_ps(scale)));
+#else
+		for (int k = 0; k < 4; k++) {
+			float v = 0.0f;
+			for (int c = 0; c < columns; c++) {
+				float column = rows[0][first + c * 4 + k];
+				for (int r = 1; r < rowCount; r++) {
+					column += rows[r][first + c * 4 + k];
+				}
+				v = c == 0 ? column : v + column;
+			}
+			out[x * 4 + k] = v * scale;
+		}
+#endif
+	}
+}
+
+// Filas de origen de la fila y del nivel siguiente, segun filterRow
+static int sourceRows(int y, int h, int rows[3])
+{
+	int dh = std::max(1, h / 2);
+	rows[0] = std::min(2 * y, h - 1);
+	if (h == 1) {
+		return 1;
+	}
+	rows[1] = 2 * y + 1;
+	rows[2] = 2 * y + 2;
+	return y == dh - 1 && h % 2 == 1 ? 3 : 2;
+}
+
+void buildMipChain(unsigned char* chain, int width, int height, int levels)
+{
+	const GammaTables& t = gammaTables();
+
+	// Cada nivel sale del anterior ya en 8 bits, como con glGenerateMipmap;
+	// solo hacen falta las filas de origen decodificadas y la fila de salida
+	std::vector<float> decoded((size_t)width * 4 * 3);
+	std::vector<float> filtered((size_t)std::max(1, width / 2) * 4);
+
+	unsigned char* src = chain;
+	for (int level = 1; level < levels; level++) {
+		unsigned char* dst = src + (size_t)width * height * 4;
+		int dw = std::max(1, width / 2);
+		int dh = std::max(1, height / 2);
+
+		for (int y = 0; y < dh; y++) {
+			int index[3];
+			int rowCount = sourceRows(y, height, index);
+			const float* rows[3];
+			for (int r = 0; r < rowCount; r++) {
+				float* row = decoded.data() + (size_t)r * width * 4;
+				decodeRow(src + (size_t)index[r] * width * 4, width, row, t);
+				rows[r] = row;
+			}
+
+			filterRow(rows, rowCount, width, filtered.data());
+			encodeRow(filtered.data(), dw, dst + (size_t)y * dw * 4, t);
+		}
+
+		src = dst;
+		width = dw;
+		height = dh;
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <cstddef>
+
+// Cadena de mipmaps RGBA8 construida en CPU. Sustituye a glGenerateMipmap,
+// cuyo filtro depende del driver: aqui los niveles se promedian con un box
+// 2x2 en espacio lineal (color sRGB decodificado, alfa sin gamma), por lo que
+// el resultado es el mismo en cualquier maquina.
+
+// Numero de niveles hasta llegar a 1x1
+int mipLevelCount(int width, int height);
+
+// Bytes que ocupan los niveles [0, levels) uno detras de otro
+size_t mipChainSize(int width, int height, int levels);
+
+// Bytes hasta el inicio del nivel 'level' dentro de la cadena
+size_t mipLevelOffset(int width, int height, int level);
+
+// Genera los niveles 1..levels-1 a continuacion del nivel 0, que ya debe
+// estar en 'chain'. Es seguro llamarla desde cualquier hilo.
+void buildMipChain(unsigned char* chain, int width, int height, int levels);
+
+#endif
@@ -0,0 +1,325 @@
+#include "Narrowphase.h"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#define NARROWPHASE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NARROWPHASE_SSE2
+#include <emmintrin.h>
+#endif
+
+void BoxSoA::Resize(size_t count)
+{
+	centerX.resize(count);
+	centerY.resize(count);
+	centerZ.resize(count);
+	extentX.resize(count);
+	extentY.resize(count);
+	extentZ.resize(count);
+}
+
+void BoxSoA::Set(int index, const AABB& box)
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = extent.x;
+	extentY[index] = extent.y;
+	extentZ[index] = extent.z;
+}
+
+// Dos cajas se solapan si en cada eje la distancia entre centros no supera
+// la suma de las semiextensiones
+static inline bool overlapScalar(const BoxSoA& boxes, int a, int b)
+{
+	return fabsf(boxes.centerX[a] - boxes.centerX[b]) <= boxes.extentX[a] + boxes.extentX[b]
+		&& fabsf(boxes.centerY[a] - boxes.centerY[b]) <= boxes.extentY[a] + boxes.extentY[b]
+		&& fabsf(boxes.centerZ[a] - boxes.centerZ[b]) <= boxes.extentZ[a] + boxes.extentZ[b];
+}
+
+#if defined(NARROWPHASE_AVX2)
+
+const int laneCount = 8;
+
+static inline __m256 axisOverlap(__m256 centerA, __m256 extentA, __m256 centerB, __m256 extentB)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	__m256 distance = _mm256_andnot_ps(signMask, _mm256_sub_ps(centerA, centerB));
+	return _mm256_cmp_ps(distance, _mm256_add_ps(extentA, extentB), _CMP_LE_OQ);
+}
+
+#elif defined(NARROWPHASE_SSE2)
+
+const int laneCount = 4;
+
+static inline __m128 axisOverlap(__m128 centerA, __m128 extentA, __m128 centerB, __m128 extentB)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 distance = _mm_andnot_ps(signMask, _mm_sub_ps(centerA, centerB));
+	return _mm_cmple_ps(distance, _mm_add_ps(extentA, extentB));
+}
+
+#endif
+
+void overlapOneToMany(const AABB& box, const BoxSoA& boxes, int begin, int end, vector<int>& hits)
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+	int i = begin;
+
+#if defined(NARROWPHASE_AVX2)
+	__m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+	__m256 ex = _mm256_set1_ps(extent.x), ey = _mm256_set1_ps(extent.y), ez = _mm256_set1_ps(extent.z);
+
+	for (; i + laneCount <= end; i += laneCount) {
+		__m256 inside = axisOverlap(cx, ex, _mm256_loadu_ps(&boxes.centerX[i]), _mm256_loadu_ps(&boxes.extentX[i]));
+		inside = _mm256_and_ps(inside, axisOverlap(cy, ey, _mm256_loadu_ps(&boxes.centerY[i]), _mm256_loadu_ps(&boxes.extentY[i])));
+		inside = _mm256_and_ps(inside, axisOverlap(cz, ez, _mm256_loadu_ps(&boxes.centerZ[i]), _mm256_loadu_ps(&boxes.extentZ[i])));
+
+		int mask = _mm256_movemask_ps(inside);
+		for (int lane = 0; mask; lane++, mask >>= 1) {
+			if (mask & 1) {
+				hits.push_back(i + lane);
+			}
+		}
+	}
+#elif defined(NARROWPHASE_SSE2)
+	__m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+	__m128 ex = _mm_set1_ps(extent.x), ey = _mm_set1_ps(extent.y), ez = _mm_set1_ps(extent.z);
+
+	for (; i + laneCount <= end; i += laneCount) {
+		__m128 inside = axisOverlap(cx, ex, _mm_loadu_ps(&boxes.centerX[i]), _mm_loadu_ps(&boxes.extentX[i]));
+		inside = _mm_and_ps(inside, axisOverlap(cy, ey, _mm_loadu_ps(&boxes.centerY[i]), _mm_loadu_ps(&boxes.extentY[i])));
+		inside = _mm_and_ps(inside, axisOverlap(cz, ez, _mm_loadu_ps(&boxes.centerZ[i]), _mm_loadu_ps(&boxes.extentZ[i])));
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane = 0; mask; lane++, mask >>= 1) {
+			if (mask & 1) {
+				hits.push_back(i + lane);
+			}
+		}
+	}
+#endif
+
+	// Resto que no completa un lote
+	for (; i < end; i++) {
+		if (fabsf(center.x - boxes.centerX[i]) <= extent.x + boxes.extentX[i]
+			&& fabsf(center.y - boxes.centerY[i]) <= extent.y + boxes.extentY[i]
+			&& fabsf(center.z - boxes.centerZ[i]) <= extent.z + boxes.extentZ[i]) {
+			hits.push_back(i);
+		}
+	}
+}
+
+void overlapPairs(const BoxSoA& boxes, const vector<pair<int, int>>& candidates, vector<pair<int, int>>& hits)
+{
+	hits.clear();
+	int count = (int)candidates.size();
+	int i = 0;
+
+#if defined(NARROWPHASE_AVX2)
+	const float* cx = boxes.centerX.data();
+	const float* cy = boxes.centerY.data();
+	const float* cz = boxes.centerZ.data();
+	const float* ex = boxes.extentX.data();
+	const float* ey = boxes.extentY.data();
+	const float* ez = boxes.extentZ.data();
+
+	for (; i + laneCount <= count; i += laneCount) {
+		// Los pares vienen intercalados (a0 b0 a1 b1 ...); se separan en dos
+		// vectores de indices para recoger cada componente con gather
+		__m256i low = _mm256_loadu_si256((const __m256i*)&candidates[i]);
+		__m256i high = _mm256_loadu_si256((const __m256i*)&candidates[i + 4]);
+		__m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+		low = _mm256_permutevar8x32_epi32(low, order);
+		high = _mm256_permutevar8x32_epi32(high, order);
+		__m256i first = _mm256_permute2x128_si256(low, high, 0x20);
+		__m256i second = _mm256_permute2x128_si256(low, high, 0x31);
+
+		__m256 inside = axisOverlap(_mm256_i32gather_ps(cx, first, 4), _mm256_i32gather_ps(ex, first, 4),
+			_mm256_i32gather_ps(cx, second, 4), _mm256_i32gather_ps(ex, second, 4));
+		inside = _mm256_and_ps(inside, axisOverlap(_mm256_i32gather_ps(cy, first, 4), _mm256_i32gather_ps(ey, first, 4),
+			_mm256_i32gather_ps(cy, second, 4), _mm256_i32gather_ps(ey, second, 4)));
+		inside = _mm256_and_ps(inside, axisOverlap(_mm256_i32gather_ps(cz, first, 4), _mm256_i32gather_ps(ez, first, 4),
+			_mm256_i32gather_ps(cz, second, 4), _mm256_i32gather_ps(ez, second, 4)));
+
+		int mask = _mm256_movemask_ps(inside);
+		for (int lane = 0; mask; lane++, mask >>= 1) {
+			if (mask & 1) {
+				hits.push_back(candidates[i + lane]);
+			}
+		}
+	}
+#elif defined(NARROWPHASE_SSE2)
+	for (; i + laneCount <= count; i += laneCount) {
+		// Sin gather: se cargan los componentes de los 4 pares uno a uno
+		const pair<int, int>* batch = &candidates[i];
+		int a0 = batch[0].first, a1 = batch[1].first, a2 = batch[2].first, a3 = batch[3].first;
+		int b0 = batch[0].second, b1 = batch[1].second, b2 = batch[2].second, b3 = batch[3].second;
+
+		__m128 inside = axisOverlap(
+			_mm_setr_ps(boxes.centerX[a0], boxes.centerX[a1], boxes.centerX[a2], boxes.centerX[a3]),
+			_mm_setr_ps(boxes.extentX[a0], boxes.extentX[a1], boxes.extentX[a2], boxes.extentX[a3]),
+			_mm_setr_ps(boxes.centerX[b0], boxes.centerX[b1], boxes.centerX[b2], boxes.centerX[b3]),
+			_mm_setr_ps(boxes.extentX[b0], boxes.extentX[b1], boxes.extentX[b2], boxes.extentX[b3]));
+		inside = _mm_and_ps(inside, axisOverlap(
+			_mm_setr_ps(boxes.centerY[a0], boxes.centerY[a1], boxes.centerY[a2], boxes.centerY[a3]),
+			_mm_setr_ps(boxes.extentY[a0], boxes.extentY[a1], boxes.extentY[a2], boxes.extentY[a3]),
+			_mm_setr_ps(boxes.centerY[b0], boxes.centerY[b1], boxes.centerY[b2], boxes.centerY[b3]),
+			_mm_setr_ps(boxes.extentY[b0], boxes.extentY[b1], boxes.extentY[b2], boxes.extentY[b3])));
+		inside = _mm_and_ps(inside, axisOverlap(
+			_mm_setr_ps(boxes.centerZ[a0], boxes.centerZ[a1], boxes.centerZ[a2], boxes.centerZ[a3]),
+			_mm_setr_ps(boxes.extentZ[a0], boxes.extentZ[a1], boxes.extentZ[a2], boxes.extentZ[a3]),
+			_mm_setr_ps(boxes.centerZ[b0], boxes.centerZ[b1], boxes.centerZ[b2], boxes.centerZ[b3]),
+			_mm_setr_ps(boxes.extentZ[b0], boxes.extentZ[b1], boxes.extentZ[b2], boxes.extentZ[b3])));
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane = 0; mask; lane++, mask >>= 1) {
+			if (mask & 1) {
+				hits.push_back(batch[lane]);
+			}
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		if (overlapScalar(boxes, candidates[i].first, candidates[i].second)) {
+			hits.push_back(candidates[i]);
+		}
+	}
+}
+
+// Pequenno margen para que ejes casi paralelos (producto cruz casi nulo) no
+// den separaciones falsas por redondeo
+const float satEpsilon = 1e-6f;
+
+// rotation[i][j] = eje i de 'one' . eje j de 'two', en la base de 'one';
+// offset es el centro de 'two' relativo al de 'one' en esa misma base
+static bool separatingAxisTest(const glm::vec3 rotation[3], glm::vec3 offset, glm::vec3 halfOne, glm::vec3 halfTwo)
+{
+#if defined(NARROWPHASE_AVX2) || defined(NARROWPHASE_SSE2)
+	// Cada registro guarda una fila de la matriz (componente j en el carril
+	// j, el cuarto carril en cero), asi cada comparacion cubre tres ejes
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 row[3], absRow[3];
+	for (int i = 0; i < 3; i++) {
+		row[i] = _mm_setr_ps(rotation[i].x, rotation[i].y, rotation[i].z, 0.0f);
+		absRow[i] = _mm_add_ps(_mm_andnot_ps(signMask, row[i]), _mm_setr_ps(satEpsilon, satEpsilon, satEpsilon, 0.0f));
+	}
+
+	__m128 t0 = _mm_set1_ps(offset.x), t1 = _mm_set1_ps(offset.y), t2 = _mm_set1_ps(offset.z);
+	__m128 a0 = _mm_set1_ps(halfOne.x), a1 = _mm_set1_ps(halfOne.y), a2 = _mm_set1_ps(halfOne.z);
+	__m128 b = _mm_setr_ps(halfTwo.x, halfTwo.y, halfTwo.z, 0.0f);
+	__m128 separated;
+
+	// Ejes de 'one': |t_i| > a_i + sum_j b_j |R_ij|. Se arma por columnas
+	// transponiendo las filas absolutas
+	{
+		__m128 c0 = absRow[0], c1 = absRow[1], c2 = absRow[2], c3 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		__m128 reach = _mm_setr_ps(halfOne.x, halfOne.y, halfOne.z, 0.0f);
+		reach = _mm_add_ps(reach, _mm_mul_ps(c0, _mm_set1_ps(halfTwo.x)));
+		reach = _mm_add_ps(reach, _mm_mul_ps(c1, _mm_set1_ps(halfTwo.y)));
+		reach = _mm_add_ps(reach, _mm_mul_ps(c2, _mm_set1_ps(halfTwo.z)));
+		__m128 distance = _mm_andnot_ps(signMask, _mm_setr_ps(offset.x, offset.y, offset.z, 0.0f));
+		separated = _mm_cmpgt_ps(distance, reach);
+	}
+
+	// Ejes de 'two': |sum_i t_i R_ij| > sum_i a_i |R_ij| + b_j
+	{
+		__m128 projected = _mm_add_ps(_mm_add_ps(_mm_mul_ps(t0, row[0]), _mm_mul_ps(t1, row[1])), _mm_mul_ps(t2, row[2]));
+		__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, absRow[0]), _mm_mul_ps(a1, absRow[1])), _mm_mul_ps(a2, absRow[2]));
+		reach = _mm_add_ps(reach, b);
+		separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_andnot_ps(signMask, projected), reach));
+	}
+
+	// Productos cruz A_i x B_j: para cada i, los tres j en paralelo.
+	// Los carriles rotados dan R_i,(j+1) y R_i,(j+2) y lo mismo para b
+	__m128 b1 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 b2 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+	__m128 t[3] = { t0, t1, t2 };
+	__m128 a[3] = { a0, a1, a2 };
+	for (int i = 0; i < 3; i++) {
+		int i1 = (i + 1) % 3;
+		int i2 = (i + 2) % 3;
+
+		__m128 distance = _mm_sub_ps(_mm_mul_ps(t[i2], row[i1]), _mm_mul_ps(t[i1], row[i2]));
+		__m128 reach = _mm_add_ps(_mm_mul_ps(a[i1], absRow[i2]), _mm_mul_ps(a[i2], absRow[i1]));
+
+		__m128 rowNext = _mm_shuffle_ps(absRow[i], absRow[i], _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 rowLast = _mm_shuffle_ps(absRow[i], absRow[i], _MM_SHUFFLE(3, 1, 0, 2));
+		reach = _mm_add_ps(reach, _mm_add_ps(_mm_mul_ps(b1, rowLast), _mm_mul_ps(b2, rowNext)));
+
+		separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_andnot_ps(signMask, distance), reach));
+	}
+
+	return (_mm_movemask_ps(separated) & 7) == 0;
+#else
+	glm::vec3 absRotation[3];
+	for (int i = 0; i < 3; i++) {
+		absRotation[i] = glm::abs(rotation[i]) + satEpsilon;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		float reach = halfOne[i] + glm::dot(halfTwo, absRotation[i]);
+		if (fabsf(offset[i]) > reach) {
+			return false;
+		}
+	}
+
+	for (int j = 0; j < 3; j++) {
+		float projected = offset.x * rotation[0][j] + offset.y * rotation[1][j] + offset.z * rotation[2][j];
+		float reach = halfOne.x * absRotation[0][j] + halfOne.y * absRotation[1][j] + halfOne.z * absRotation[2][j] + halfTwo[j];
+		if (fabsf(projected) > reach) {
+			return false;
+		}
+	}
+
+	for (int i = 0; i < 3; i++) {
+		int i1 = (i + 1) % 3;
+		int i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; j++) {
+			int j1 = (j + 1) % 3;
+			int j2 = (j + 2) % 3;
+			float distance = offset[i2] * rotation[i1][j] - offset[i1] * rotation[i2][j];
+			float reach = halfOne[i1] * absRotation[i2][j] + halfOne[i2] * absRotation[i1][j]
+				+ halfTwo[j1] * absRotation[i][j2] + halfTwo[j2] * absRotation[i][j1];
+			if (fabsf(distance) > reach) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+#endif
+}
+
+bool overlapOBB(const OBB& one, const OBB& two)
+{
+	glm::vec3 rotation[3];
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			rotation[i][j] = glm::dot(one.axes[i], two.axes[j]);
+		}
+	}
+
+	glm::vec3 delta = two.center - one.center;
+	glm::vec3 offset = glm::vec3(glm::dot(delta, one.axes[0]), glm::dot(delta, one.axes[1]), glm::dot(delta, one.axes[2]));
+
+	return separatingAxisTest(rotation, offset, one.halfSize, two.halfSize);
+}
+
+bool overlapOBB(const OBB& one, const AABB& two)
+{
+	// Con los ejes de 'two' iguales a los del mundo, R_ij es la componente j
+	// del eje i de 'one'
+	glm::vec3 delta = (two.min + two.max) * 0.5f - one.center;
+	glm::vec3 offset = glm::vec3(glm::dot(delta, one.axes[0]), glm::dot(delta, one.axes[1]), glm::dot(delta, one.axes[2]));
+
+	return separatingAxisTest(one.axes, offset, one.halfSize, (two.max - two.min) * 0.5f);
+}
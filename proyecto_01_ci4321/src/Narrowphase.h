@@ -0,0 +1,43 @@
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H
+
+#include "Bounds.h"
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Cajas en estructura de arreglos, como centro y semiextension, para probar
+// varias a la vez con SIMD (8 por instruccion con AVX2, 4 con SSE2)
+struct BoxSoA
+{
+	vector<float> centerX, centerY, centerZ;
+	vector<float> extentX, extentY, extentZ;
+
+	void Resize(size_t count);
+	void Set(int index, const AABB& box);
+
+	inline size_t Size() const
+	{
+		return centerX.size();
+	};
+};
+
+// Agrega a 'hits' los indices de boxes[begin, end) que se solapan con 'box'
+void overlapOneToMany(const AABB& box, const BoxSoA& boxes, int begin, int end, vector<int>& hits);
+
+// Prueba los pares candidatos de la broadphase por lotes y deja en 'hits'
+// solo los que se solapan, en el mismo orden
+void overlapPairs(const BoxSoA& boxes, const vector<pair<int, int>>& candidates, vector<pair<int, int>>& hits);
+
+// Teorema del eje separador entre cajas orientadas (15 ejes). Con SSE2 se
+// evaluan 3 ejes por instruccion. Conviene llamarlas solo para pares cuyas
+// AABB ya se solapan
+bool overlapOBB(const OBB& one, const OBB& two);
+
+// Igual que overlapOBB con 'two' alineada a los ejes: la matriz de rotacion
+// relativa son directamente los ejes de 'one'
+bool overlapOBB(const OBB& one, const AABB& two);
+
+#endif
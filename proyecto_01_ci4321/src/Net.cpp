@@ -0,0 +1,271 @@
+#include "Net.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+const intptr_t invalidSocket = -1;
+const float pi = 3.14159265358979f;
+
+#ifdef _WIN32
+// Winsock se inicia una vez por proceso, con el primer socket
+static bool startNetworking()
+{
+	static bool started = false;
+	if (!started) {
+		WSADATA data;
+		started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}
+	return started;
+}
+#endif
+
+bool parseAddress(const string& host, uint16_t port, NetAddress& address)
+{
+	in_addr parsed;
+	const char* text = host == "localhost" ? "127.0.0.1" : host.c_str();
+	if (inet_pton(AF_INET, text, &parsed) != 1) {
+		return false;
+	}
+	address.ip = ntohl(parsed.s_addr);
+	address.port = port;
+	return true;
+}
+
+UdpSocket::UdpSocket()
+{
+	handle = invalidSocket;
+}
+
+UdpSocket::~UdpSocket()
+{
+	Close();
+}
+
+bool UdpSocket::Open(uint16_t port)
+{
+#ifdef _WIN32
+	if (!startNetworking()) {
+		return false;
+	}
+#endif
+
+	Close();
+	handle = (intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (handle == invalidSocket) {
+		return false;
+	}
+
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+	if (bind(handle, (const sockaddr*)&local, sizeof(local)) != 0) {
+		Close();
+		return false;
+	}
+
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ioctlsocket(handle, FIONBIO, &nonBlocking);
+#else
+	fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+	return true;
+}
+
+void UdpSocket::Close()
+{
+	if (handle == invalidSocket) {
+		return;
+	}
+#ifdef _WIN32
+	closesocket(handle);
+#else
+	close(handle);
+#endif
+	handle = invalidSocket;
+}
+
+bool UdpSocket::Send(const NetAddress& to, const uint8_t* data, size_t size)
+{
+	sockaddr_in remote = {};
+	remote.sin_family = AF_INET;
+	remote.sin_addr.s_addr = htonl(to.ip);
+	remote.sin_port = htons(to.port);
+	return sendto(handle, (const char*)data, (int)size, 0, (const sockaddr*)&remote, sizeof(remote)) == (int)size;
+}
+
+int UdpSocket::Receive(NetAddress& from, uint8_t* data, size_t capacity)
+{
+	sockaddr_in remote = {};
+	socklen_t length = sizeof(remote);
+	int received = (int)recvfrom(handle, (char*)data, (int)capacity, 0, (sockaddr*)&remote, &length);
+	if (received <= 0) {
+		return 0;
+	}
+	from.ip = ntohl(remote.sin_addr.s_addr);
+	from.port = ntohs(remote.sin_port);
+	return received;
+}
+
+uint16_t UdpSocket::LocalPort() const
+{
+	sockaddr_in local = {};
+	socklen_t length = sizeof(local);
+	if (getsockname(handle, (sockaddr*)&local, &length) != 0) {
+		return 0;
+	}
+	return ntohs(local.sin_port);
+}
+
+NetLink::NetLink(UdpSocket& socket, const LinkConditions& conditions, unsigned int seed)
+	: socket(socket), conditions(conditions), random(seed)
+{
+	bytesSent = 0;
+}
+
+void NetLink::Send(const NetAddress& to, const vector<uint8_t>& data, double now)
+{
+	uniform_real_distribution<double> unit(0.0, 1.0);
+	if (conditions.loss > 0.0 && unit(random) < conditions.loss) {
+		return;
+	}
+
+	double delay = conditions.latency + conditions.jitter * unit(random);
+	if (delay <= 0.0 && pending.empty()) {
+		socket.Send(to, data.data(), data.size());
+		bytesSent += data.size();
+		return;
+	}
+
+	// Orden por hora de salida: con jitter los datagramas pueden llegar
+	// desordenados, como en una red real
+	Pending packet = { now + delay, to, data };
+	auto position = upper_bound(pending.begin(), pending.end(), packet.sendTime,
+		[](double time, const Pending& other) { return time < other.sendTime; });
+	pending.insert(position, packet);
+}
+
+void NetLink::Pump(double now)
+{
+	while (!pending.empty() && pending.front().sendTime <= now) {
+		Pending& packet = pending.front();
+		socket.Send(packet.to, packet.data.data(), packet.data.size());
+		bytesSent += packet.data.size();
+		pending.pop_front();
+	}
+}
+
+void BitWriter::Write(uint32_t value, int bits)
+{
+	if (bits < 32) {
+		value &= (1u << bits) - 1;
+	}
+	scratch |= (uint64_t)value << scratchBits;
+	scratchBits += bits;
+	while (scratchBits >= 8) {
+		bytes.push_back((uint8_t)scratch);
+		scratch >>= 8;
+		scratchBits -= 8;
+	}
+}
+
+void BitWriter::WriteFloat(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	Write(bits, 32);
+}
+
+const vector<uint8_t>& BitWriter::Finish()
+{
+	if (scratchBits > 0) {
+		bytes.push_back((uint8_t)scratch);
+		scratch = 0;
+		scratchBits = 0;
+	}
+	return bytes;
+}
+
+void BitWriter::Clear()
+{
+	bytes.clear();
+	scratch = 0;
+	scratchBits = 0;
+}
+
+BitReader::BitReader(const uint8_t* data, size_t size)
+{
+	this->data = data;
+	this->size = size;
+	position = 0;
+	valid = true;
+}
+
+uint32_t BitReader::Read(int bits)
+{
+	if (position + bits > size * 8) {
+		valid = false;
+		return 0;
+	}
+
+	uint32_t value = 0;
+	for (int i = 0; i < bits; ) {
+		size_t byte = (position + i) / 8;
+		int offset = (int)((position + i) % 8);
+		int take = min(8 - offset, bits - i);
+		uint32_t chunk = (data[byte] >> offset) & ((1u << take) - 1);
+		value |= chunk << i;
+		i += take;
+	}
+	position += bits;
+	return value;
+}
+
+float BitReader::ReadFloat()
+{
+	uint32_t bits = Read(32);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+uint32_t quantize(float value, float minimum, float maximum, int bits)
+{
+	uint32_t steps = (1u << bits) - 1;
+	float normalized = std::clamp((value - minimum) / (maximum - minimum), 0.0f, 1.0f);
+	return (uint32_t)lroundf(normalized * steps);
+}
+
+float dequantize(uint32_t value, float minimum, float maximum, int bits)
+{
+	uint32_t steps = (1u << bits) - 1;
+	return minimum + (maximum - minimum) * ((float)value / steps);
+}
+
+uint32_t quantizeAngle(float angle, int bits)
+{
+	float wrapped = angle - 2.0f * pi * floorf((angle + pi) / (2.0f * pi));
+	uint32_t steps = 1u << bits;
+	return (uint32_t)lroundf((wrapped + pi) / (2.0f * pi) * steps) & (steps - 1);
+}
+
+float dequantizeAngle(uint32_t value, int bits)
+{
+	return (float)value / (1u << bits) * 2.0f * pi - pi;
+}
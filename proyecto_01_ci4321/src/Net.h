@@ -0,0 +1,141 @@
+#ifndef NET_H
+#define NET_H
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Direccion IPv4 y puerto, en orden de host
+struct NetAddress
+{
+	uint32_t ip;
+	uint16_t port;
+
+	bool operator==(const NetAddress& other) const
+	{
+		return ip == other.ip && port == other.port;
+	}
+};
+
+// "a.b.c.d" o "localhost"
+bool parseAddress(const string& host, uint16_t port, NetAddress& address);
+
+// Socket UDP no bloqueante (Winsock o BSD)
+class UdpSocket
+{
+public:
+
+	UdpSocket();
+	~UdpSocket();
+
+	// Puerto 0: el sistema elige uno libre (ver LocalPort)
+	bool Open(uint16_t port);
+	void Close();
+	bool Send(const NetAddress& to, const uint8_t* data, size_t size);
+	// Devuelve el tamanno del datagrama, 0 si no habia ninguno
+	int Receive(NetAddress& from, uint8_t* data, size_t capacity);
+	uint16_t LocalPort() const;
+
+private:
+
+	intptr_t handle;
+};
+
+// Condiciones de red simuladas para pruebas por loopback
+struct LinkConditions
+{
+	double latency;  // segundos, en un sentido
+	double jitter;   // segundos, variacion maxima sobre latency
+	double loss;     // probabilidad de perder un datagrama
+};
+
+// Envio a traves de un socket con latencia y perdida simuladas. Los
+// datagramas se retienen hasta su hora de salida; Pump los envia. Con
+// condiciones en cero se envian en el acto. La hora la pasa quien llama,
+// asi las pruebas pueden usar un reloj virtual.
+class NetLink
+{
+public:
+
+	NetLink(UdpSocket& socket, const LinkConditions& conditions, unsigned int seed);
+
+	void Send(const NetAddress& to, const vector<uint8_t>& data, double now);
+	void Pump(double now);
+
+	// Bytes entregados al socket, para medir ancho de banda
+	inline unsigned long long BytesSent() const
+	{
+		return bytesSent;
+	};
+
+private:
+
+	struct Pending
+	{
+		double sendTime;
+		NetAddress to;
+		vector<uint8_t> data;
+	};
+
+	UdpSocket& socket;
+	LinkConditions conditions;
+	mt19937 random;
+	deque<Pending> pending;
+	unsigned long long bytesSent;
+};
+
+// Escritura y lectura de campos de pocos bits, en orden little-endian
+class BitWriter
+{
+public:
+
+	void Write(uint32_t value, int bits);
+	void WriteFloat(float value);
+
+	// Deja el buffer listo para enviar y lo devuelve
+	const vector<uint8_t>& Finish();
+	void Clear();
+
+private:
+
+	vector<uint8_t> bytes;
+	uint64_t scratch = 0;
+	int scratchBits = 0;
+};
+
+class BitReader
+{
+public:
+
+	BitReader(const uint8_t* data, size_t size);
+
+	// Leer mas alla del final devuelve ceros y marca el lector como invalido
+	uint32_t Read(int bits);
+	float ReadFloat();
+
+	inline bool Valid() const
+	{
+		return valid;
+	};
+
+private:
+
+	const uint8_t* data;
+	size_t size;
+	size_t position; // en bits
+	bool valid;
+};
+
+// Cuantizacion uniforme de [minimum, maximum] en 'bits' bits
+uint32_t quantize(float value, float minimum, float maximum, int bits);
+float dequantize(uint32_t value, float minimum, float maximum, int bits);
+
+// Angulos: se envuelven a [-pi, pi) antes de cuantizar
+uint32_t quantizeAngle(float angle, int bits);
+float dequantizeAngle(uint32_t value, int bits);
+
+#endif
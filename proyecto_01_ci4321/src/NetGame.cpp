@@ -0,0 +1,1085 @@
+#include "NetGame.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+const uint32_t protocolId = 0x7A4B;
+
+enum PacketType
+{
+	PACKET_CONNECT = 1,
+	PACKET_ACCEPT,
+	PACKET_INPUT,
+	PACKET_SNAPSHOT,
+	PACKET_DISCONNECT
+};
+
+const size_t maxPacketSize = 1200;
+
+// Fotos a 20 Hz con la simulacion a 60 pasos por segundo
+const int snapshotInterval = 3;
+const int snapshotHistory = 32;
+
+// Interes: solo los tanques cercanos, y como mucho esta cantidad
+const float interestRadius = 40.0f;
+const int maxEntitiesPerSnapshot = 16;
+
+// Cada paquete de input repite los ultimos inputs por si se pierden
+const int inputRedundancy = 8;
+const size_t maxPendingInputs = 128;
+const size_t maxQueuedInputs = 32;
+
+// Los tanques ajenos se dibujan 100 ms por detras de la ultima foto
+const int interpolationDelay = 6;
+
+const double clientTimeout = 5.0;
+const double connectRetry = 0.25;
+const double maxLag = 0.25;
+
+// Cuantizacion de los tanques ajenos
+const int slotBits = 8;
+const int maxPlayersBits = 9;
+const float worldExtent = 512.0f;
+const int positionBits = 16;
+const float heightExtent = 8.0f;
+const int heightBits = 10;
+const float projectileHeightExtent = 64.0f;
+const int projectileHeightBits = 12;
+const int yawBits = 10;
+const float pitchMin = -0.7f;
+const float pitchMax = 0.0f;
+const int pitchBits = 7;
+const float canonYawLimit = 0.9f;
+const int canonYawBits = 8;
+// El proyectil apunta hacia donde va: sube y luego cae
+const float projectilePitchLimit = 1.5708f;
+const int projectilePitchBits = 8;
+const int inputBits = 9;
+const int entityCountBits = 5;
+
+// Grupos de campos que se envian solo si cambiaron respecto de la base
+enum EntityField
+{
+	FIELD_POSITION = 1,
+	FIELD_YAW = 2,
+	FIELD_CANON = 4,
+	FIELD_PROJECTILE = 8,
+	FIELD_ALL = 15
+};
+const int fieldBits = 4;
+
+static void writeHeader(BitWriter& writer, PacketType type)
+{
+	writer.Clear();
+	writer.Write(protocolId, 16);
+	writer.Write(type, 8);
+}
+
+// Devuelve el tipo de paquete, o -1 si no es de este protocolo
+static int readHeader(BitReader& reader)
+{
+	if (reader.Read(16) != protocolId) {
+		return -1;
+	}
+	int type = (int)reader.Read(8);
+	return reader.Valid() ? type : -1;
+}
+
+static uint32_t packInput(const TankInput& input)
+{
+	return input.canonUp | input.canonDown << 1 | input.canonRight << 2 | input.canonLeft << 3
+		| input.forward << 4 | input.backwards << 5 | input.bodyLeft << 6 | input.bodyRight << 7 | input.fire << 8;
+}
+
+static TankInput unpackInput(uint32_t bits)
+{
+	TankInput input;
+	input.canonUp = bits & 1;
+	input.canonDown = (bits >> 1) & 1;
+	input.canonRight = (bits >> 2) & 1;
+	input.canonLeft = (bits >> 3) & 1;
+	input.forward = (bits >> 4) & 1;
+	input.backwards = (bits >> 5) & 1;
+	input.bodyLeft = (bits >> 6) & 1;
+	input.bodyRight = (bits >> 7) & 1;
+	input.fire = (bits >> 8) & 1;
+	return input;
+}
+
+// El estado propio viaja sin cuantizar: el cliente reconcilia contra el
+// mismo valor que tiene el servidor y la prediccion no acumula error
+static void writeTankState(BitWriter& writer, const TankState& state)
+{
+	writer.WriteFloat(state.position.x);
+	writer.WriteFloat(state.position.y);
+	writer.WriteFloat(state.position.z);
+	writer.WriteFloat(state.bodyYaw);
+	writer.WriteFloat(state.canonPitch);
+	writer.WriteFloat(state.canonYaw);
+	writer.Write(state.projectileFlying, 1);
+	if (state.projectileFlying) {
+		for (int i = 0; i < 3; i++) {
+			writer.WriteFloat(state.projectilePosition[i]);
+		}
+		for (int i = 0; i < 3; i++) {
+			writer.WriteFloat(state.projectileRotation[i]);
+		}
+		for (int i = 0; i < 3; i++) {
+			writer.WriteFloat(state.projectileVelocity[i]);
+		}
+		writer.WriteFloat(state.projectileLife);
+	}
+}
+
+static TankState readTankState(BitReader& reader)
+{
+	TankState state = {};
+	state.position.x = reader.ReadFloat();
+	state.position.y = reader.ReadFloat();
+	state.position.z = reader.ReadFloat();
+	state.bodyYaw = reader.ReadFloat();
+	state.canonPitch = reader.ReadFloat();
+	state.canonYaw = reader.ReadFloat();
+	state.projectileFlying = reader.Read(1);
+	if (state.projectileFlying) {
+		for (int i = 0; i < 3; i++) {
+			state.projectilePosition[i] = reader.ReadFloat();
+		}
+		for (int i = 0; i < 3; i++) {
+			state.projectileRotation[i] = reader.ReadFloat();
+		}
+		for (int i = 0; i < 3; i++) {
+			state.projectileVelocity[i] = reader.ReadFloat();
+		}
+		state.projectileLife = reader.ReadFloat();
+	}
+	return state;
+}
+
+static NetEntity encodeEntity(int slot, const TankState& state)
+{
+	NetEntity entity = {};
+	entity.slot = slot;
+	entity.x = quantize(state.position.x, -worldExtent, worldExtent, positionBits);
+	entity.y = quantize(state.position.y, -heightExtent, heightExtent, heightBits);
+	entity.z = quantize(state.position.z, -worldExtent, worldExtent, positionBits);
+	entity.yaw = quantizeAngle(state.bodyYaw, yawBits);
+	entity.canonPitch = quantize(state.canonPitch, pitchMin, pitchMax, pitchBits);
+	entity.canonYaw = quantize(state.canonYaw, -canonYawLimit, canonYawLimit, canonYawBits);
+	entity.flying = state.projectileFlying;
+	if (state.projectileFlying) {
+		entity.projectileX = quantize(state.projectilePosition.x, -worldExtent, worldExtent, positionBits);
+		entity.projectileY = quantize(state.projectilePosition.y, -projectileHeightExtent, projectileHeightExtent, projectileHeightBits);
+		entity.projectileZ = quantize(state.projectilePosition.z, -worldExtent, worldExtent, positionBits);
+		entity.projectilePitch = quantize(state.projectileRotation.x, -projectilePitchLimit, projectilePitchLimit, projectilePitchBits);
+		entity.projectileYaw = quantize(state.projectileRotation.y, -canonYawLimit, canonYawLimit, canonYawBits);
+	}
+	return entity;
+}
+
+static TankState decodeEntity(const NetEntity& entity)
+{
+	TankState state = {};
+	state.position.x = dequantize(entity.x, -worldExtent, worldExtent, positionBits);
+	state.position.y = dequantize(entity.y, -heightExtent, heightExtent, heightBits);
+	state.position.z = dequantize(entity.z, -worldExtent, worldExtent, positionBits);
+	state.bodyYaw = dequantizeAngle(entity.yaw, yawBits);
+	state.canonPitch = dequantize(entity.canonPitch, pitchMin, pitchMax, pitchBits);
+	state.canonYaw = dequantize(entity.canonYaw, -canonYawLimit, canonYawLimit, canonYawBits);
+	state.projectileFlying = entity.flying;
+	if (entity.flying) {
+		state.projectilePosition.x = dequantize(entity.projectileX, -worldExtent, worldExtent, positionBits);
+		state.projectilePosition.y = dequantize(entity.projectileY, -projectileHeightExtent, projectileHeightExtent, projectileHeightBits);
+		state.projectilePosition.z = dequantize(entity.projectileZ, -worldExtent, worldExtent, positionBits);
+		state.projectileRotation.x = dequantize(entity.projectilePitch, -projectilePitchLimit, projectilePitchLimit, projectilePitchBits);
+		state.projectileRotation.y = dequantize(entity.projectileYaw, -canonYawLimit, canonYawLimit, canonYawBits);
+	}
+	return state;
+}
+
+static int changedFields(const NetEntity& entity, const NetEntity& base)
+{
+	int fields = 0;
+	if (entity.x != base.x || entity.y != base.y || entity.z != base.z) {
+		fields |= FIELD_POSITION;
+	}
+	if (entity.yaw != base.yaw) {
+		fields |= FIELD_YAW;
+	}
+	if (entity.canonPitch != base.canonPitch || entity.canonYaw != base.canonYaw) {
+		fields |= FIELD_CANON;
+	}
+	if (entity.flying != base.flying || (entity.flying && (entity.projectileX != base.projectileX
+		|| entity.projectileY != base.projectileY || entity.projectileZ != base.projectileZ
+		|| entity.projectilePitch != base.projectilePitch || entity.projectileYaw != base.projectileYaw))) {
+		fields |= FIELD_PROJECTILE;
+	}
+	return fields;
+}
+
+static void writeEntityFields(BitWriter& writer, const NetEntity& entity, int fields)
+{
+	if (fields & FIELD_POSITION) {
+		writer.Write(entity.x, positionBits);
+		writer.Write(entity.y, heightBits);
+		writer.Write(entity.z, positionBits);
+	}
+	if (fields & FIELD_YAW) {
+		writer.Write(entity.yaw, yawBits);
+	}
+	if (fields & FIELD_CANON) {
+		writer.Write(entity.canonPitch, pitchBits);
+		writer.Write(entity.canonYaw, canonYawBits);
+	}
+	if (fields & FIELD_PROJECTILE) {
+		writer.Write(entity.flying, 1);
+		if (entity.flying) {
+			writer.Write(entity.projectileX, positionBits);
+			writer.Write(entity.projectileY, projectileHeightBits);
+			writer.Write(entity.projectileZ, positionBits);
+			writer.Write(entity.projectilePitch, projectilePitchBits);
+			writer.Write(entity.projectileYaw, canonYawBits);
+		}
+	}
+}
+
+// Los campos que no vienen quedan como en 'entity', que arranca como copia
+// de la base
+static void readEntityFields(BitReader& reader, NetEntity& entity, int fields)
+{
+	if (fields & FIELD_POSITION) {
+		entity.x = reader.Read(positionBits);
+		entity.y = reader.Read(heightBits);
+		entity.z = reader.Read(positionBits);
+	}
+	if (fields & FIELD_YAW) {
+		entity.yaw = reader.Read(yawBits);
+	}
+	if (fields & FIELD_CANON) {
+		entity.canonPitch = reader.Read(pitchBits);
+		entity.canonYaw = reader.Read(canonYawBits);
+	}
+	if (fields & FIELD_PROJECTILE) {
+		entity.flying = reader.Read(1);
+		if (entity.flying) {
+			entity.projectileX = reader.Read(positionBits);
+			entity.projectileY = reader.Read(projectileHeightBits);
+			entity.projectileZ = reader.Read(positionBits);
+			entity.projectilePitch = reader.Read(projectilePitchBits);
+			entity.projectileYaw = reader.Read(canonYawBits);
+		}
+	}
+}
+
+// Las entidades de cada foto van ordenadas por slot
+static const NetEntity* findEntity(const vector<NetEntity>& entities, int slot)
+{
+	auto found = lower_bound(entities.begin(), entities.end(), slot,
+		[](const NetEntity& entity, int value) { return entity.slot < value; });
+	return found != entities.end() && found->slot == slot ? &*found : NULL;
+}
+
+static glm::vec3 spawnPosition(int slot)
+{
+	return glm::vec3((slot % 16) * 10.0f - 75.0f, 0.0f, (slot / 16) * 12.0f - 30.0f);
+}
+
+GameServer::GameServer(int maxPlayers, float step)
+	: step(step), simulation(step)
+{
+	started = false;
+	nextStep = 0.0;
+	tick = 0;
+	link = NULL;
+	snapshotsSent = 0;
+	entitiesSent = 0;
+
+	// Un tanque por lugar, oculto hasta que alguien lo ocupe. El vector no
+	// se redimensiona mas: la simulacion guarda punteros a sus elementos
+	maxPlayers = std::clamp(maxPlayers, 1, 1 << slotBits);
+	tanks.resize(maxPlayers);
+	clients.resize(maxPlayers);
+	stepInputs.resize(maxPlayers);
+	for (int i = 0; i < maxPlayers; i++) {
+		tanks[i].Translate(spawnPosition(i));
+		tanks[i].SetVisible(false);
+		simulation.AddTank(tanks[i]);
+		clients[i].connected = false;
+	}
+}
+
+GameServer::~GameServer()
+{
+	delete link;
+}
+
+bool GameServer::Open(uint16_t port, const LinkConditions& conditions, unsigned int seed)
+{
+	if (!socket.Open(port)) {
+		LOG_ERROR("GameServer: could not open UDP port {}", port);
+		return false;
+	}
+	delete link;
+	link = new NetLink(socket, conditions, seed);
+	return true;
+}
+
+uint16_t GameServer::Port() const
+{
+	return socket.LocalPort();
+}
+
+void GameServer::Update(double now)
+{
+	if (!link) {
+		return;
+	}
+	if (!started) {
+		started = true;
+		nextStep = now;
+	}
+
+	link->Pump(now);
+	Receive(now);
+
+	for (unsigned int i = 0; i < clients.size(); i++) {
+		if (clients[i].connected && now - clients[i].lastHeard > clientTimeout) {
+			LOG_INFO("GameServer: player {} timed out", i);
+			clients[i].connected = false;
+			tanks[i].SetVisible(false);
+		}
+	}
+
+	if (now - nextStep > maxLag) {
+		nextStep = now;
+	}
+
+	while (now >= nextStep) {
+		// Un input por jugador y paso. Si no llego ninguno el tanque queda
+		// quieto y el cliente lo corrige al reconciliar
+		for (unsigned int i = 0; i < clients.size(); i++) {
+			Client& client = clients[i];
+			stepInputs[i] = TankInput();
+			if (!client.connected) {
+				continue;
+			}
+			while (!client.inputs.empty() && client.inputs.front().first <= client.lastProcessed) {
+				client.inputs.pop_front();
+			}
+			if (!client.inputs.empty()) {
+				stepInputs[i] = client.inputs.front().second;
+				client.lastProcessed = client.inputs.front().first;
+				client.inputs.pop_front();
+			}
+		}
+
+		simulation.Step(stepInputs);
+		tick++;
+		nextStep += step;
+
+		if (tick % snapshotInterval == 0) {
+			for (unsigned int i = 0; i < clients.size(); i++) {
+				if (clients[i].connected) {
+					SendSnapshot(i, now);
+				}
+			}
+		}
+	}
+
+	link->Pump(now);
+}
+
+int GameServer::PlayerCount() const
+{
+	int count = 0;
+	for (const Client& client : clients) {
+		count += client.connected;
+	}
+	return count;
+}
+
+TankState GameServer::PlayerState(int slot)
+{
+	return simulation.GetTankState(slot);
+}
+
+unsigned long long GameServer::BytesSentTo(int slot) const
+{
+	return clients[slot].bytesSent;
+}
+
+double GameServer::EntitiesPerSnapshot() const
+{
+	return snapshotsSent ? (double)entitiesSent / snapshotsSent : 0.0;
+}
+
+int GameServer::FindClient(const NetAddress& address) const
+{
+	for (unsigned int i = 0; i < clients.size(); i++) {
+		if (clients[i].connected && clients[i].address == address) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void GameServer::Receive(double now)
+{
+	uint8_t buffer[maxPacketSize];
+	NetAddress from;
+	int size;
+	while ((size = socket.Receive(from, buffer, sizeof(buffer))) > 0) {
+		BitReader reader(buffer, size);
+		int type = readHeader(reader);
+		if (type == PACKET_CONNECT) {
+			HandleConnect(from, now);
+			continue;
+		}
+
+		int slot = FindClient(from);
+		if (slot < 0) {
+			continue;
+		}
+		clients[slot].lastHeard = now;
+
+		if (type == PACKET_INPUT) {
+			HandleInput(slot, reader);
+		}
+		else if (type == PACKET_DISCONNECT) {
+			LOG_INFO("GameServer: player {} left", slot);
+			clients[slot].connected = false;
+			tanks[slot].SetVisible(false);
+		}
+	}
+}
+
+void GameServer::HandleConnect(const NetAddress& from, double now)
+{
+	// Un CONNECT repetido (se perdio el ACCEPT) recibe el mismo lugar
+	int slot = FindClient(from);
+	if (slot < 0) {
+		for (unsigned int i = 0; i < clients.size(); i++) {
+			if (!clients[i].connected) {
+				slot = i;
+				break;
+			}
+		}
+		if (slot < 0) {
+			return;
+		}
+
+		Client& client = clients[slot];
+		client.connected = true;
+		client.address = from;
+		client.lastProcessed = 0;
+		client.inputs.clear();
+		client.ackedSnapshot = 0;
+		client.snapshotSequence = 0;
+		client.history.assign(snapshotHistory, SentSnapshot{ 0, {} });
+		client.bytesSent = 0;
+		tanks[slot].SetVisible(true);
+		LOG_INFO("GameServer: player {} joined", slot);
+	}
+	clients[slot].lastHeard = now;
+
+	writeHeader(writer, PACKET_ACCEPT);
+	writer.Write(slot, slotBits);
+	writer.Write((uint32_t)clients.size(), maxPlayersBits);
+	link->Send(from, writer.Finish(), now);
+}
+
+void GameServer::HandleInput(int slot, BitReader& reader)
+{
+	Client& client = clients[slot];
+
+	uint32_t newest = reader.Read(32);
+	int count = (int)reader.Read(4);
+	uint32_t ack = reader.Read(32);
+	uint32_t bits[inputRedundancy];
+	count = min(count, inputRedundancy);
+	for (int i = 0; i < count; i++) {
+		bits[i] = reader.Read(inputBits);
+	}
+	if (!reader.Valid()) {
+		return;
+	}
+
+	if (ack <= client.snapshotSequence && ack > client.ackedSnapshot) {
+		client.ackedSnapshot = ack;
+	}
+
+	// Vienen del mas nuevo al mas viejo; la cola queda ordenada y sin
+	// repetidos
+	for (int i = count - 1; i >= 0; i--) {
+		uint32_t sequence = newest - i;
+		if (sequence <= client.lastProcessed) {
+			continue;
+		}
+		auto position = lower_bound(client.inputs.begin(), client.inputs.end(), sequence,
+			[](const pair<uint32_t, TankInput>& queued, uint32_t value) { return queued.first < value; });
+		if (position == client.inputs.end() || position->first != sequence) {
+			client.inputs.insert(position, make_pair(sequence, unpackInput(bits[i])));
+		}
+	}
+
+	// Un cliente adelantado no puede acumular latencia sin limite
+	while (client.inputs.size() > maxQueuedInputs) {
+		client.lastProcessed = client.inputs.front().first;
+		client.inputs.pop_front();
+	}
+}
+
+void GameServer::SendSnapshot(int slot, double now)
+{
+	Client& client = clients[slot];
+
+	// Interes: los tanques mas cercanos dentro del radio
+	glm::vec3 center = tanks[slot].getPosition();
+	nearby.clear();
+	for (unsigned int i = 0; i < clients.size(); i++) {
+		if ((int)i == slot || !clients[i].connected) {
+			continue;
+		}
+		glm::vec3 offset = tanks[i].getPosition() - center;
+		float distance = sqrtf(offset.x * offset.x + offset.z * offset.z);
+		if (distance <= interestRadius) {
+			nearby.push_back(make_pair(distance, (int)i));
+		}
+	}
+	if ((int)nearby.size() > maxEntitiesPerSnapshot) {
+		nth_element(nearby.begin(), nearby.begin() + maxEntitiesPerSnapshot, nearby.end());
+		nearby.resize(maxEntitiesPerSnapshot);
+	}
+	sort(nearby.begin(), nearby.end(), [](const pair<float, int>& a, const pair<float, int>& b) { return a.second < b.second; });
+
+	uint32_t sequence = ++client.snapshotSequence;
+	SentSnapshot& sent = client.history[sequence % snapshotHistory];
+	sent.sequence = sequence;
+	sent.entities.clear();
+	for (const pair<float, int>& other : nearby) {
+		sent.entities.push_back(encodeEntity(other.second, tanks[other.second].GetState()));
+	}
+
+	// Base: la ultima foto que el cliente confirmo, si sigue en el historial
+	const SentSnapshot* base = NULL;
+	const SentSnapshot& acked = client.history[client.ackedSnapshot % snapshotHistory];
+	if (client.ackedSnapshot != 0 && acked.sequence == client.ackedSnapshot && acked.sequence != sequence) {
+		base = &acked;
+	}
+
+	writeHeader(writer, PACKET_SNAPSHOT);
+	writer.Write(sequence, 32);
+	writer.Write(base ? base->sequence : 0, 32);
+	writer.Write(tick, 32);
+	writer.Write(client.lastProcessed, 32);
+	writeTankState(writer, simulation.GetTankState(slot));
+
+	writer.Write((uint32_t)sent.entities.size(), entityCountBits);
+	for (const NetEntity& entity : sent.entities) {
+		writer.Write(entity.slot, slotBits);
+		const NetEntity* previous = base ? findEntity(base->entities, entity.slot) : NULL;
+		writer.Write(previous != NULL, 1);
+		if (previous) {
+			int fields = changedFields(entity, *previous);
+			writer.Write(fields, fieldBits);
+			writeEntityFields(writer, entity, fields);
+		}
+		else {
+			writeEntityFields(writer, entity, FIELD_ALL);
+		}
+	}
+
+	const vector<uint8_t>& packet = writer.Finish();
+	link->Send(client.address, packet, now);
+	client.bytesSent += packet.size();
+	snapshotsSent++;
+	entitiesSent += sent.entities.size();
+}
+
+GameClient::GameClient(float step, bool setupGL)
+	: ballistics(defaultBallistics())
+{
+	this->step = step;
+	this->setupGL = setupGL;
+	started = false;
+	nextStep = 0.0;
+	lastStep = 0.0;
+	lastConnect = -connectRetry;
+	slot = -1;
+	link = NULL;
+	inputSequence = 0;
+	latestSnapshot = 0;
+	latestTick = 0;
+	stepsSinceSnapshot = 0;
+	hasOwnState = false;
+	maxCorrection = 0.0f;
+	history.assign(snapshotHistory, ReceivedSnapshot{ 0, 0, {} });
+}
+
+GameClient::~GameClient()
+{
+	if (link && slot >= 0) {
+		writeHeader(writer, PACKET_DISCONNECT);
+		socket.Send(server, writer.Finish().data(), writer.Finish().size());
+	}
+	delete link;
+
+	for (Tank* tank : tanks) {
+		if (setupGL) {
+			tank->Clear();
+		}
+		delete tank;
+	}
+}
+
+bool GameClient::Connect(const NetAddress& server, const LinkConditions& conditions, unsigned int seed)
+{
+	if (!socket.Open(0)) {
+		LOG_ERROR("GameClient: could not open a UDP socket");
+		return false;
+	}
+	this->server = server;
+	delete link;
+	link = new NetLink(socket, conditions, seed);
+	return true;
+}
+
+Tank* GameClient::LocalTank()
+{
+	return slot >= 0 ? tanks[slot] : NULL;
+}
+
+void GameClient::Update(const TankInput& input, double now)
+{
+	if (!link) {
+		return;
+	}
+
+	link->Pump(now);
+
+	if (slot < 0) {
+		if (now - lastConnect >= connectRetry) {
+			writeHeader(writer, PACKET_CONNECT);
+			link->Send(server, writer.Finish(), now);
+			lastConnect = now;
+		}
+		Receive();
+		return;
+	}
+
+	Receive();
+
+	if (!started) {
+		started = true;
+		nextStep = now;
+	}
+	if (now - nextStep > maxLag) {
+		nextStep = now;
+	}
+
+	while (now >= nextStep) {
+		for (Tank* tank : tanks) {
+			tank->SaveState();
+		}
+
+		// El input se aplica en el acto y se guarda para reaplicarlo
+		pendingInputs.push_back(make_pair(++inputSequence, input));
+		if (pendingInputs.size() > maxPendingInputs) {
+			pendingInputs.pop_front();
+		}
+		Predict(*tanks[slot], input);
+
+		stepsSinceSnapshot++;
+		InterpolateRemotes();
+		SendInputs(now);
+
+		lastStep = nextStep;
+		nextStep += step;
+	}
+
+	link->Pump(now);
+}
+
+void GameClient::Capture(FrameSnapshot& snapshot) const
+{
+	captureSnapshot(objects, snapshot);
+	snapshot.effects.clear();
+	snapshot.time = lastStep;
+	snapshot.step = inputSequence;
+}
+
+float GameClient::Interpolation(double now) const
+{
+	float alpha = (float)((now - lastStep) / step);
+	return std::clamp(alpha, 0.0f, 1.0f);
+}
+
+void GameClient::Receive()
+{
+	uint8_t buffer[maxPacketSize];
+	NetAddress from;
+	int size;
+	while ((size = socket.Receive(from, buffer, sizeof(buffer))) > 0) {
+		if (!(from == server)) {
+			continue;
+		}
+		BitReader reader(buffer, size);
+		int type = readHeader(reader);
+		if (type == PACKET_ACCEPT) {
+			HandleAccept(reader);
+		}
+		else if (type == PACKET_SNAPSHOT && slot >= 0) {
+			HandleSnapshot(reader);
+		}
+	}
+}
+
+void GameClient::HandleAccept(BitReader& reader)
+{
+	int accepted = (int)reader.Read(slotBits);
+	int maxPlayers = (int)reader.Read(maxPlayersBits);
+	if (!reader.Valid() || slot >= 0 || accepted >= maxPlayers) {
+		return;
+	}
+	slot = accepted;
+
+	// Todos los lugares se crean de entrada para que la lista de objetos
+	// no cambie; el propio se muestra con la primera foto
+	for (int i = 0; i < maxPlayers; i++) {
+		Tank* tank = new Tank();
+		if (setupGL) {
+			tank->SetupGL();
+		}
+		tank->SetVisible(false);
+		tank->GetParts(objects);
+		tanks.push_back(tank);
+	}
+	present.assign(maxPlayers, false);
+	LOG_INFO("GameClient: joined as player {}", slot);
+}
+
+void GameClient::HandleSnapshot(BitReader& reader)
+{
+	uint32_t sequence = reader.Read(32);
+	uint32_t baseSequence = reader.Read(32);
+	uint32_t serverTick = reader.Read(32);
+	uint32_t lastProcessed = reader.Read(32);
+	TankState own = readTankState(reader);
+
+	// Las fotos viejas o fuera de orden no aportan nada
+	if (!reader.Valid() || sequence <= latestSnapshot) {
+		return;
+	}
+
+	// Sin la base no se puede decodificar; la proxima vendra contra otra
+	const ReceivedSnapshot* base = NULL;
+	if (baseSequence != 0) {
+		const ReceivedSnapshot& candidate = history[baseSequence % snapshotHistory];
+		if (candidate.sequence != baseSequence) {
+			return;
+		}
+		base = &candidate;
+	}
+
+	ReceivedSnapshot received;
+	received.sequence = sequence;
+	received.serverTick = serverTick;
+	int count = (int)reader.Read(entityCountBits);
+	for (int i = 0; i < count; i++) {
+		NetEntity entity = {};
+		entity.slot = (int)reader.Read(slotBits);
+		bool delta = reader.Read(1);
+		if (delta) {
+			const NetEntity* previous = base ? findEntity(base->entities, entity.slot) : NULL;
+			if (!previous) {
+				return;
+			}
+			entity = *previous;
+			readEntityFields(reader, entity, reader.Read(fieldBits));
+		}
+		else {
+			readEntityFields(reader, entity, FIELD_ALL);
+		}
+		if (entity.slot >= (int)tanks.size()) {
+			return;
+		}
+		received.entities.push_back(entity);
+	}
+	if (!reader.Valid()) {
+		return;
+	}
+
+	history[sequence % snapshotHistory] = received;
+	latestSnapshot = sequence;
+	latestTick = serverTick;
+	stepsSinceSnapshot = 0;
+
+	Reconcile(own, lastProcessed);
+}
+
+void GameClient::Reconcile(const TankState& state, uint32_t lastProcessed)
+{
+	Tank* local = tanks[slot];
+	glm::vec3 predicted = local->getPosition();
+
+	// Estado del servidor y encima los inputs que todavia no proceso
+	local->SetState(state);
+	ballistics.Clear();
+	if (state.projectileFlying) {
+		ballistics.Spawn(state.projectilePosition, state.projectileVelocity, state.projectileLife, slot);
+	}
+	while (!pendingInputs.empty() && pendingInputs.front().first <= lastProcessed) {
+		pendingInputs.pop_front();
+	}
+	for (const pair<uint32_t, TankInput>& pending : pendingInputs) {
+		Predict(*local, pending.second);
+	}
+
+	if (!hasOwnState) {
+		// Primera foto: aparece directamente donde esta
+		hasOwnState = true;
+		local->SetVisible(true);
+		local->SaveState();
+		present[slot] = true;
+	}
+	else {
+		maxCorrection = max(maxCorrection, glm::length(predicted - local->getPosition()));
+	}
+}
+
+void GameClient::Predict(Tank& tank, const TankInput& input)
+{
+	// Lo mismo que hace Simulation::Step con cada tanque, salvo las
+	// colisiones: los impactos los decide el servidor
+	bool loaded = !tank.hasBeenShotF();
+	tank.Update(input, step);
+	if (loaded && tank.hasBeenShotF()) {
+		ballistics.Spawn(tank.getProjectile()->position, tank.getMuzzleDirection() * muzzleSpeed, projectileLifetime, slot);
+	}
+
+	expiredProjectiles.clear();
+	ballistics.Update(step, expiredProjectiles);
+	if (ballistics.Count() > 0) {
+		tank.getProjectile()->position = ballistics.Position(0);
+		tank.getProjectile()->rotation = orientationAlong(ballistics.Velocity(0));
+	}
+	if (!expiredProjectiles.empty()) {
+		tank.setHasBeenShot();
+	}
+}
+
+static float lerpAngle(float from, float to, float t)
+{
+	return from + remainderf(to - from, 2.0f * numbers::pi_v<float>) * t;
+}
+
+void GameClient::InterpolateRemotes()
+{
+	if (latestSnapshot == 0) {
+		return;
+	}
+
+	// Las dos fotos que rodean el instante a dibujar
+	double renderTick = (double)latestTick + stepsSinceSnapshot - interpolationDelay;
+	const ReceivedSnapshot* older = NULL;
+	const ReceivedSnapshot* newer = NULL;
+	const ReceivedSnapshot* oldest = NULL;
+	for (const ReceivedSnapshot& snapshot : history) {
+		if (snapshot.sequence == 0 || snapshot.sequence + snapshotHistory <= latestSnapshot) {
+			continue;
+		}
+		if (!oldest || snapshot.serverTick < oldest->serverTick) {
+			oldest = &snapshot;
+		}
+		if (snapshot.serverTick <= renderTick && (!older || snapshot.serverTick > older->serverTick)) {
+			older = &snapshot;
+		}
+		if (snapshot.serverTick > renderTick && (!newer || snapshot.serverTick < newer->serverTick)) {
+			newer = &snapshot;
+		}
+	}
+	if (!older) {
+		older = oldest;
+	}
+	if (!newer) {
+		newer = older;
+	}
+
+	float t = 0.0f;
+	if (newer->serverTick > older->serverTick) {
+		t = std::clamp((float)((renderTick - older->serverTick) / (newer->serverTick - older->serverTick)), 0.0f, 1.0f);
+	}
+
+	vector<bool> seen(tanks.size(), false);
+	for (const NetEntity& entity : newer->entities) {
+		if (entity.slot == slot) {
+			continue;
+		}
+		const NetEntity* from = findEntity(older->entities, entity.slot);
+		TankState target = decodeEntity(entity);
+		TankState state = target;
+		if (from) {
+			TankState start = decodeEntity(*from);
+			state.position = glm::mix(start.position, target.position, t);
+			state.bodyYaw = lerpAngle(start.bodyYaw, target.bodyYaw, t);
+			state.canonPitch = glm::mix(start.canonPitch, target.canonPitch, t);
+			state.canonYaw = glm::mix(start.canonYaw, target.canonYaw, t);
+			if (start.projectileFlying && target.projectileFlying) {
+				state.projectilePosition = glm::mix(start.projectilePosition, target.projectilePosition, t);
+			}
+		}
+
+		Tank* tank = tanks[entity.slot];
+		bool appearing = !present[entity.slot];
+		if (appearing) {
+			tank->SetVisible(true);
+		}
+		tank->SetState(state);
+		if (appearing) {
+			tank->SaveState();
+		}
+		present[entity.slot] = true;
+		seen[entity.slot] = true;
+	}
+
+	for (unsigned int i = 0; i < tanks.size(); i++) {
+		if ((int)i != slot && present[i] && !seen[i]) {
+			tanks[i]->SetVisible(false);
+			present[i] = false;
+		}
+	}
+}
+
+void GameClient::SendInputs(double now)
+{
+	int count = (int)min(pendingInputs.size(), (size_t)inputRedundancy);
+
+	writeHeader(writer, PACKET_INPUT);
+	writer.Write(inputSequence, 32);
+	writer.Write(count, 4);
+	writer.Write(latestSnapshot, 32);
+	for (int i = 0; i < count; i++) {
+		writer.Write(packInput(pendingInputs[pendingInputs.size() - 1 - i].second), inputBits);
+	}
+	link->Send(server, writer.Finish(), now);
+}
+
+int runLoopbackMatch(int clientCount, double seconds, double latency, double loss)
+{
+	const float step = 1.0f / 60.0f;
+	const double tickLength = 1.0 / 240.0;
+	const double settleTime = 1.5;
+
+	LinkConditions conditions = { latency, latency * 0.25, loss };
+
+	GameServer server(clientCount, step);
+	if (!server.Open(0, conditions, 1)) {
+		return 1;
+	}
+	NetAddress address;
+	parseAddress("127.0.0.1", server.Port(), address);
+
+	vector<GameClient*> clients;
+	for (int i = 0; i < clientCount; i++) {
+		clients.push_back(new GameClient(step, false));
+		clients[i]->Connect(address, conditions, 100 + i);
+	}
+
+	// Bots con input aleatorio que se mantiene un rato; al final sueltan
+	// todo para que se pueda comparar el estado en reposo
+	mt19937 random(7);
+	uniform_int_distribution<int> coin(0, 3);
+	uniform_int_distribution<int> hold(20, 120);
+	vector<TankInput> inputs(clientCount);
+	vector<int> holdTicks(clientCount, 0);
+
+	double end = seconds + settleTime;
+	double measureStart = 1.0;
+	for (double now = 0.0; now < end; now += tickLength) {
+		if (now >= measureStart && now - tickLength < measureStart) {
+			for (GameClient* client : clients) {
+				client->ResetMaxCorrection();
+			}
+		}
+
+		server.Update(now);
+		for (int i = 0; i < clientCount; i++) {
+			if (--holdTicks[i] <= 0) {
+				TankInput input = {};
+				int motion = coin(random);
+				input.forward = motion <= 1;
+				input.backwards = motion == 2;
+				int turn = coin(random);
+				input.bodyLeft = turn == 0;
+				input.bodyRight = turn == 1;
+				input.canonLeft = coin(random) == 0;
+				input.canonUp = coin(random) == 0;
+				input.fire = coin(random) == 0;
+				inputs[i] = input;
+				holdTicks[i] = hold(random);
+			}
+			clients[i]->Update(now < seconds ? inputs[i] : TankInput(), now);
+		}
+	}
+
+	int connected = 0, converged = 0;
+	double downTotal = 0.0, downMax = 0.0, upTotal = 0.0;
+	float worstCorrection = 0.0f;
+	for (GameClient* client : clients) {
+		if (!client->Connected()) {
+			continue;
+		}
+		connected++;
+
+		TankState expected = server.PlayerState(client->Slot());
+		TankState predicted = client->LocalTank()->GetState();
+		float error = glm::length(expected.position - predicted.position) + fabsf(expected.bodyYaw - predicted.bodyYaw)
+			+ fabsf(expected.canonPitch - predicted.canonPitch) + fabsf(expected.canonYaw - predicted.canonYaw);
+		converged += error < 1e-3f;
+
+		double down = server.BytesSentTo(client->Slot()) / end;
+		downTotal += down;
+		downMax = max(downMax, down);
+		upTotal += client->BytesSent() / end;
+		worstCorrection = max(worstCorrection, client->MaxCorrection());
+	}
+
+	cout << fixed << setprecision(1)
+		<< "Loopback match: " << clientCount << " clients, " << seconds << " s, latency " << latency * 1000.0
+		<< " ms, loss " << loss * 100.0 << "%" << endl
+		<< "  connected " << connected << "/" << clientCount << ", converged " << converged << "/" << clientCount << endl
+		<< "  down per client " << (connected ? downTotal / connected : 0.0) << " B/s (max " << downMax << "), up "
+		<< (connected ? upTotal / connected : 0.0) << " B/s" << endl
+		<< setprecision(3)
+		<< "  entities per snapshot " << server.EntitiesPerSnapshot() << ", worst prediction correction " << worstCorrection << endl;
+
+	for (GameClient* client : clients) {
+		delete client;
+	}
+	return connected == clientCount && converged == clientCount ? 0 : 1;
+}
+
+int runDedicatedServer(uint16_t port, int maxPlayers)
+{
+	GameServer server(maxPlayers, 1.0f / 60.0f);
+	LinkConditions conditions = { 0.0, 0.0, 0.0 };
+	if (!server.Open(port, conditions, 1)) {
+		flushLog();
+		return 1;
+	}
+	LOG_INFO("GameServer: listening on UDP port {} for {} players", server.Port(), maxPlayers);
+
+	auto start = chrono::steady_clock::now();
+	while (true) {
+		double now = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		server.Update(now);
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	return 0;
+}
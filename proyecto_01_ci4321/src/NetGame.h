@@ -0,0 +1,210 @@
+#ifndef NET_GAME_H
+#define NET_GAME_H
+
+#include "Net.h"
+#include "Tank.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+// Estado de un tanque ajeno tal como viaja en las fotos: cuantizado, para
+// comparar campo a campo contra la foto base
+struct NetEntity
+{
+	int slot;
+	uint32_t x, y, z;
+	uint32_t yaw;
+	uint32_t canonPitch, canonYaw;
+	uint32_t flying;
+	uint32_t projectileX, projectileY, projectileZ;
+	uint32_t projectilePitch, projectileYaw;
+};
+
+// Servidor autoritativo: simula todos los tanques a paso fijo con la
+// Simulation de siempre, consume los inputs numerados de cada cliente y le
+// manda fotos cuantizadas y comprimidas contra la ultima que el cliente
+// confirmo. Cada cliente solo recibe los tanques mas cercanos al suyo, asi
+// su ancho de banda no crece con la cantidad de jugadores.
+class GameServer
+{
+public:
+
+	GameServer(int maxPlayers, float step);
+	~GameServer();
+
+	bool Open(uint16_t port, const LinkConditions& conditions, unsigned int seed);
+	uint16_t Port() const;
+
+	// Recibe, avanza los pasos que correspondan a 'now' y envia fotos
+	void Update(double now);
+
+	int PlayerCount() const;
+	TankState PlayerState(int slot);
+
+	// Bytes de fotos enviados a un jugador desde que se conecto
+	unsigned long long BytesSentTo(int slot) const;
+	double EntitiesPerSnapshot() const;
+
+private:
+
+	struct SentSnapshot
+	{
+		uint32_t sequence;
+		vector<NetEntity> entities;
+	};
+
+	struct Client
+	{
+		bool connected;
+		NetAddress address;
+		double lastHeard;
+		uint32_t lastProcessed;  // ultimo input aplicado
+		deque<pair<uint32_t, TankInput>> inputs;
+		uint32_t ackedSnapshot;
+		uint32_t snapshotSequence;
+		vector<SentSnapshot> history;
+		unsigned long long bytesSent;
+	};
+
+	void Receive(double now);
+	void HandleConnect(const NetAddress& from, double now);
+	void HandleInput(int slot, BitReader& reader);
+	void SendSnapshot(int slot, double now);
+	int FindClient(const NetAddress& address) const;
+
+	float step;
+	bool started;
+	double nextStep;
+	uint32_t tick;
+	UdpSocket socket;
+	NetLink* link;
+
+	Simulation simulation;
+	vector<Tank> tanks;
+	vector<Client> clients;
+	vector<TankInput> stepInputs;
+
+	BitWriter writer;
+	vector<pair<float, int>> nearby;
+	unsigned long long snapshotsSent;
+	unsigned long long entitiesSent;
+};
+
+// Cliente: predice su propio tanque aplicando el input en el acto, y al
+// llegar cada foto vuelve al estado del servidor y reaplica los inputs que
+// el servidor todavia no proceso. Los tanques ajenos se dibujan
+// interpolando entre fotos, un poco por detras del servidor.
+class GameClient
+{
+public:
+
+	// Con 'setupGL' los tanques crean sus recursos de GL para dibujarse
+	GameClient(float step, bool setupGL);
+	~GameClient();
+
+	bool Connect(const NetAddress& server, const LinkConditions& conditions, unsigned int seed);
+
+	// Recibe, avanza los pasos que correspondan a 'now' con 'input' y
+	// envia los inputs
+	void Update(const TankInput& input, double now);
+
+	inline bool Connected() const
+	{
+		return slot >= 0;
+	};
+
+	inline int Slot() const
+	{
+		return slot;
+	};
+
+	Tank* LocalTank();
+
+	// Para dibujar igual que la simulacion local
+	inline const vector<Geometry*>& Objects() const
+	{
+		return objects;
+	};
+	void Capture(FrameSnapshot& snapshot) const;
+	float Interpolation(double now) const;
+
+	inline unsigned long long BytesSent() const
+	{
+		return link ? link->BytesSent() : 0;
+	};
+
+	// Mayor correccion de posicion aplicada al reconciliar
+	inline float MaxCorrection() const
+	{
+		return maxCorrection;
+	};
+
+	inline void ResetMaxCorrection()
+	{
+		maxCorrection = 0.0f;
+	};
+
+private:
+
+	struct ReceivedSnapshot
+	{
+		uint32_t sequence;
+		uint32_t serverTick;
+		vector<NetEntity> entities;
+	};
+
+	void Receive();
+	void HandleAccept(BitReader& reader);
+	void HandleSnapshot(BitReader& reader);
+	void Reconcile(const TankState& state, uint32_t lastProcessed);
+	void Predict(Tank& tank, const TankInput& input);
+	void InterpolateRemotes();
+	void SendInputs(double now);
+
+	float step;
+	bool setupGL;
+	bool started;
+	double nextStep;
+	double lastStep;
+	double lastConnect;
+	int slot;
+	NetAddress server;
+	UdpSocket socket;
+	NetLink* link;
+
+	vector<Tank*> tanks;
+	vector<Geometry*> objects;
+	vector<bool> present;
+
+	// Solo el proyectil propio se predice; los ajenos se interpolan
+	ProjectileSystem ballistics;
+	vector<int> expiredProjectiles;
+
+	uint32_t inputSequence;
+	deque<pair<uint32_t, TankInput>> pendingInputs;
+
+	vector<ReceivedSnapshot> history;
+	uint32_t latestSnapshot;
+	uint32_t latestTick;
+	int stepsSinceSnapshot;
+	bool hasOwnState;
+	float maxCorrection;
+
+	BitWriter writer;
+};
+
+// Partida completa por loopback, con un reloj virtual: un servidor y
+// 'clientCount' clientes con input aleatorio, latencia y perdida simuladas
+// en ambos sentidos. Al final verifica que la prediccion de cada cliente
+// coincida con el servidor y muestra el ancho de banda por cliente.
+// Devuelve 0 si todo cliente se conecto y convergio
+int runLoopbackMatch(int clientCount, double seconds, double latency, double loss);
+
+// Servidor dedicado en tiempo real, hasta que se cierre el proceso
+int runDedicatedServer(uint16_t port, int maxPlayers);
+
+#endif
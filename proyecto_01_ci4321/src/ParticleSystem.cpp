@@ -0,0 +1,249 @@
+#include "ParticleSystem.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+// Debe coincidir con maxBursts y local_size_x de ParticleUpdate.comp
+const int maxBursts = 16;
+const int particleGroupSize = 256;
+
+// Particle en el SSBO (std430): posicion y edad, velocidad y vida
+const size_t particleBytes = 8 * sizeof(float);
+
+static EmitterSettings defaultSettings(EmitterType type)
+{
+	EmitterSettings settings;
+	switch (type)
+	{
+	case EMITTER_MUZZLE_FLASH:
+		settings = { 64, glm::vec2(0.05f, 0.12f), glm::vec2(2.0f, 6.0f), 0.3f, glm::vec3(0.0f), 8.0f,
+			0.35f, 0.05f, glm::vec4(1.0f, 0.9f, 0.5f, 1.0f), glm::vec4(1.0f, 0.3f, 0.0f, 0.0f), true };
+		break;
+	case EMITTER_SMOKE:
+		settings = { 96, glm::vec2(1.5f, 3.0f), glm::vec2(0.3f, 1.2f), 0.8f, glm::vec3(0.0f, 0.6f, 0.0f), 1.5f,
+			0.3f, 1.5f, glm::vec4(0.35f, 0.35f, 0.35f, 0.6f), glm::vec4(0.2f, 0.2f, 0.2f, 0.0f), false };
+		break;
+	default:
+		settings = { 512, glm::vec2(0.4f, 1.0f), glm::vec2(3.0f, 9.0f), 1.0f, glm::vec3(0.0f, -4.0f, 0.0f), 2.0f,
+			0.3f, 0.1f, glm::vec4(1.0f, 0.8f, 0.3f, 1.0f), glm::vec4(0.8f, 0.1f, 0.0f, 0.0f), true };
+		break;
+	}
+	return settings;
+}
+
+ParticleSystem::ParticleSystem(int capacity)
+{
+	this->capacity = capacity;
+	frame = 0;
+	vao = 0;
+	updateShader = NULL;
+	renderShader = NULL;
+
+	// Compute shaders, SSBOs y dibujo indirecto son de GL 4.3
+	supported = GLEW_VERSION_4_3;
+	if (!supported) {
+		LOG_WARNING("ParticleSystem: GL 4.3 not available, particles disabled");
+		return;
+	}
+
+	updateShader = new Shader("src/Shaders/ParticleUpdate.comp");
+	renderShader = new Shader("src/Shaders/ParticleVertexShader.vs", "src/Shaders/ParticleFragmentShader.fs");
+
+	// Los quads salen de gl_VertexID, pero el perfil core exige un VAO
+	glGenVertexArrays(1, &vao);
+
+	for (int i = 0; i < EMITTER_COUNT; i++) {
+		Emitter& emitter = emitters[i];
+		emitter.settings = defaultSettings((EmitterType)i);
+		emitter.head = 0;
+		emitter.idleTime = 0.0f;
+		emitter.active = false;
+		emitter.bursts.reserve(maxBursts);
+
+		// Vida cero: todas las particulas arrancan muertas
+		glGenBuffers(1, &emitter.particles);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, emitter.particles);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * particleBytes, NULL, GL_DYNAMIC_COPY);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, NULL);
+
+		glGenBuffers(1, &emitter.visible);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, emitter.visible);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+
+		// 4 vertices por quad; las instancias las cuenta el compute shader
+		GLuint command[4] = { 4, 0, 0, 0 };
+		glGenBuffers(1, &emitter.command);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, emitter.command);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(command), command, GL_DYNAMIC_DRAW);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	if (!supported) {
+		return;
+	}
+
+	for (Emitter& emitter : emitters) {
+		glDeleteBuffers(1, &emitter.particles);
+		glDeleteBuffers(1, &emitter.visible);
+		glDeleteBuffers(1, &emitter.command);
+	}
+	glDeleteVertexArrays(1, &vao);
+	glDeleteProgram(updateShader->ID);
+	glDeleteProgram(renderShader->ID);
+	delete updateShader;
+	delete renderShader;
+}
+
+void ParticleSystem::Emit(EmitterType type, glm::vec3 position, glm::vec3 direction)
+{
+	Emitter& emitter = emitters[type];
+	if (!supported || (int)emitter.bursts.size() >= maxBursts) {
+		return;
+	}
+
+	// Cada rafaga reinicia un tramo contiguo del anillo; si el pool se
+	// llena se pisan las particulas mas viejas
+	int count = std::min(emitter.settings.particlesPerBurst, capacity);
+	emitter.bursts.push_back({ emitter.head, count, position, direction });
+	emitter.head = (emitter.head + count) % capacity;
+}
+
+void ParticleSystem::Emit(const EffectEvent& effect)
+{
+	switch (effect.kind)
+	{
+	case EFFECT_MUZZLE_FLASH:
+		Emit(EMITTER_MUZZLE_FLASH, effect.position, effect.direction);
+		Emit(EMITTER_SMOKE, effect.position, effect.direction);
+		break;
+	case EFFECT_EXPLOSION:
+		Emit(EMITTER_EXPLOSION, effect.position, effect.direction);
+		Emit(EMITTER_SMOKE, effect.position, glm::vec3(0.0f, 1.0f, 0.0f));
+		break;
+	}
+}
+
+void ParticleSystem::Update(float deltaTime, const Frustum& frustum)
+{
+	if (!supported) {
+		return;
+	}
+
+	frame++;
+
+	// Planos normalizados para probar esferas por distancia
+	glm::vec4 planes[6];
+	for (int i = 0; i < 6; i++) {
+		planes[i] = frustum.planes[i] / glm::length(glm::vec3(frustum.planes[i]));
+	}
+
+	updateShader->use();
+	GLuint program = updateShader->ID;
+	glUniform4fv(glGetUniformLocation(program, "frustumPlanes"), 6, &planes[0][0]);
+	updateShader->setInt("capacity", capacity);
+	updateShader->setFloat("deltaTime", deltaTime);
+
+	bool dispatched = false;
+	for (int i = 0; i < EMITTER_COUNT; i++) {
+		Emitter& emitter = emitters[i];
+		const EmitterSettings& settings = emitter.settings;
+
+		// Sin rafagas durante mas de una vida maxima ya no queda ninguna
+		// particula viva: ni se simula ni se dibuja
+		emitter.idleTime = emitter.bursts.empty() ? emitter.idleTime + deltaTime : 0.0f;
+		emitter.active = emitter.idleTime <= settings.life.y;
+		if (!emitter.active) {
+			continue;
+		}
+
+		GLint ranges[maxBursts * 2];
+		glm::vec3 positions[maxBursts];
+		glm::vec3 directions[maxBursts];
+		int burstCount = (int)emitter.bursts.size();
+		for (int b = 0; b < burstCount; b++) {
+			ranges[b * 2] = emitter.bursts[b].first;
+			ranges[b * 2 + 1] = emitter.bursts[b].count;
+			positions[b] = emitter.bursts[b].position;
+			directions[b] = emitter.bursts[b].direction;
+		}
+		emitter.bursts.clear();
+
+		updateShader->setInt("burstCount", burstCount);
+		if (burstCount > 0) {
+			glUniform2iv(glGetUniformLocation(program, "burstRange"), burstCount, ranges);
+			glUniform3fv(glGetUniformLocation(program, "burstPosition"), burstCount, &positions[0][0]);
+			glUniform3fv(glGetUniformLocation(program, "burstDirection"), burstCount, &directions[0][0]);
+		}
+		updateShader->setInt("seed", (int)(frame * EMITTER_COUNT + i));
+		glUniform2fv(glGetUniformLocation(program, "lifeRange"), 1, &settings.life[0]);
+		glUniform2fv(glGetUniformLocation(program, "speedRange"), 1, &settings.speed[0]);
+		updateShader->setFloat("spread", settings.spread);
+		updateShader->setVec3("gravity", settings.gravity);
+		updateShader->setFloat("drag", settings.drag);
+		updateShader->setFloat("radius", std::max(settings.startSize, settings.endSize) * 0.5f);
+
+		// Se reinicia el contador de instancias del comando indirecto
+		GLuint zero = 0;
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, emitter.command);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, sizeof(GLuint), sizeof(GLuint), &zero);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, emitter.particles);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, emitter.visible);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, emitter.command);
+		glDispatchCompute((capacity + particleGroupSize - 1) / particleGroupSize, 1, 1);
+		dispatched = true;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	// El dibujo lee las listas como SSBO y el comando como buffer indirecto
+	if (dispatched) {
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+	}
+}
+
+void ParticleSystem::Draw(const glm::mat4& view, const glm::mat4& projection)
+{
+	if (!supported) {
+		return;
+	}
+
+	renderShader->use();
+	renderShader->setMat4("view", view);
+	renderShader->setMat4("projection", projection);
+
+	// Las particulas se ocultan detras de los objetos pero no se tapan entre si
+	glEnable(GL_BLEND);
+	glDepthMask(GL_FALSE);
+	glBindVertexArray(vao);
+
+	for (Emitter& emitter : emitters) {
+		if (!emitter.active) {
+			continue;
+		}
+		const EmitterSettings& settings = emitter.settings;
+
+		glBlendFunc(GL_SRC_ALPHA, settings.additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+		renderShader->setFloat("startSize", settings.startSize);
+		renderShader->setFloat("endSize", settings.endSize);
+		renderShader->setVec4("startColor", settings.startColor);
+		renderShader->setVec4("endColor", settings.endColor);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, emitter.particles);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, emitter.visible);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, emitter.command);
+		glDrawArraysIndirect(GL_TRIANGLE_STRIP, 0);
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+	glDepthMask(GL_TRUE);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_BLEND);
+}
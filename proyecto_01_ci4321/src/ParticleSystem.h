@@ -0,0 +1,102 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include "Shader.h"
+#include "Bounds.h"
+#include "Snapshot.h"
+
+#include <vector>
+
+using namespace std;
+
+// Tipos de emisor. Cada uno tiene su propio pool de particulas en la GPU y
+// se dibuja con una sola llamada
+enum EmitterType
+{
+	EMITTER_MUZZLE_FLASH = 0,
+	EMITTER_SMOKE = 1,
+	EMITTER_EXPLOSION = 2,
+	EMITTER_COUNT
+};
+
+// Parametros de un tipo de emisor; los rangos se sortean por particula
+struct EmitterSettings
+{
+	int particlesPerBurst;
+	glm::vec2 life;      // segundos, minimo y maximo
+	glm::vec2 speed;     // unidades por segundo, minimo y maximo
+	float spread;        // 0 sigue la direccion del efecto, 1 esfera completa
+	glm::vec3 gravity;
+	float drag;
+	float startSize;
+	float endSize;
+	glm::vec4 startColor;
+	glm::vec4 endColor;
+	bool additive;
+};
+
+// Particulas enteramente en la GPU (GL 4.3): un compute shader emite,
+// integra y descarta contra el frustum, y agrega las vivas a una lista que
+// alimenta un glDrawArraysIndirect de quads orientados a la camara. El CPU
+// solo sube las rafagas nuevas y unas pocas uniformes por emisor, asi su
+// costo no depende de la cantidad de particulas.
+class ParticleSystem
+{
+public:
+
+	// 'capacity' particulas por tipo de emisor
+	ParticleSystem(int capacity);
+	~ParticleSystem();
+
+	inline bool Supported() const
+	{
+		return supported;
+	};
+
+	// Encola una rafaga; se emite en el proximo Update
+	void Emit(EmitterType type, glm::vec3 position, glm::vec3 direction);
+	// Rafagas que corresponden a un efecto de la simulacion
+	void Emit(const EffectEvent& effect);
+
+	// Simula 'deltaTime' segundos y arma las listas de particulas visibles
+	void Update(float deltaTime, const Frustum& frustum);
+
+	// Dibuja despues de los objetos opacos, con el buffer de profundidad
+	void Draw(const glm::mat4& view, const glm::mat4& projection);
+
+private:
+
+	// Rango del anillo de particulas que reinicia una rafaga
+	struct Burst
+	{
+		int first;
+		int count;
+		glm::vec3 position;
+		glm::vec3 direction;
+	};
+
+	struct Emitter
+	{
+		EmitterSettings settings;
+		unsigned int particles; // SSBO de Particle
+		unsigned int visible;   // SSBO de indices vivos y dentro del frustum
+		unsigned int command;   // DrawArraysIndirectCommand
+		int head;
+		vector<Burst> bursts;
+		float idleTime;         // segundos desde la ultima rafaga
+		bool active;
+	};
+
+	bool supported;
+	int capacity;
+	unsigned int frame;
+	unsigned int vao;
+	Shader* updateShader;
+	Shader* renderShader;
+	Emitter emitters[EMITTER_COUNT];
+};
+
+#endif
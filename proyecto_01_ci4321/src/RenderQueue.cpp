@@ -0,0 +1,245 @@
+#include "RenderQueue.h"
+
+#include <GL/glew.h>
+#include <gtc/type_ptr.hpp>
+
+#include <algorithm>
+
+// Marca de los payloads que son dibujos especiales
+const unsigned int callbackPayload = 0x80000000u;
+
+// Dibujos minimos por tramo de grabacion; con menos no conviene repartir
+const int recordSliceSize = 256;
+
+const int radixBits = 8;
+const int radixBuckets = 1 << radixBits;
+const int radixDigits = 64 / radixBits;
+
+SortKey makeSortKey(RenderPass pass, unsigned int program, unsigned int material, unsigned int mesh, float depth)
+{
+	SortKey quantized = (SortKey)(glm::clamp(depth, 0.0f, 1.0f) * (float)sortKeyDepthMask);
+	return ((SortKey)pass << sortKeyPassShift)
+		| ((SortKey)(program & 0xFF) << sortKeyProgramShift)
+		| ((SortKey)(material & 0xFF) << sortKeyMaterialShift)
+		| ((SortKey)(mesh & 0xFFFF) << sortKeyMeshShift)
+		| min(quantized, sortKeyDepthMask);
+}
+
+void radixSort(vector<SortKey>& keys, vector<unsigned int>& values,
+	vector<SortKey>& keyScratch, vector<unsigned int>& valueScratch)
+{
+	size_t count = keys.size();
+	keyScratch.resize(count);
+	valueScratch.resize(count);
+
+	// Los histogramas de todos los digitos en una sola lectura
+	unsigned int histograms[radixDigits][radixBuckets] = {};
+	for (SortKey key : keys) {
+		for (int digit = 0; digit < radixDigits; digit++) {
+			histograms[digit][(key >> (digit * radixBits)) & (radixBuckets - 1)]++;
+		}
+	}
+
+	for (int digit = 0; digit < radixDigits; digit++) {
+		unsigned int* histogram = histograms[digit];
+		int shift = digit * radixBits;
+
+		// Si todas las claves comparten el digito la pasada no cambia nada
+		if (histogram[(keys.empty() ? 0 : keys[0] >> shift) & (radixBuckets - 1)] == count) {
+			continue;
+		}
+
+		unsigned int offset = 0;
+		for (int bucket = 0; bucket < radixBuckets; bucket++) {
+			unsigned int size = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += size;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			unsigned int target = histogram[(keys[i] >> shift) & (radixBuckets - 1)]++;
+			keyScratch[target] = keys[i];
+			valueScratch[target] = values[i];
+		}
+		keys.swap(keyScratch);
+		values.swap(valueScratch);
+	}
+}
+
+RenderStats countStateChanges(const vector<SortKey>& keys)
+{
+	RenderStats stats = {};
+	SortKey previous = ~0ull;
+	for (SortKey key : keys) {
+		SortKey program = key >> sortKeyProgramShift;
+		SortKey material = key >> sortKeyMaterialShift;
+		SortKey mesh = key >> sortKeyMeshShift;
+		if (program != previous >> sortKeyProgramShift) {
+			stats.programChanges++;
+			stats.materialChanges++;
+			stats.meshChanges++;
+		}
+		else {
+			stats.materialChanges += material != previous >> sortKeyMaterialShift;
+			stats.meshChanges += (mesh & 0xFFFF) != ((previous >> sortKeyMeshShift) & 0xFFFF);
+		}
+		stats.draws++;
+		previous = key;
+	}
+	return stats;
+}
+
+RenderQueue::RenderQueue(float farPlane)
+	: farPlane(farPlane)
+{
+	stats = {};
+}
+
+void RenderQueue::Clear()
+{
+	items.clear();
+	itemPrograms.clear();
+	callbacks.clear();
+	keys.clear();
+	payloads.clear();
+}
+
+unsigned int RenderQueue::ProgramIndex(unsigned int program)
+{
+	for (unsigned int i = 0; i < programs.size(); i++) {
+		if (programs[i].id == program) {
+			return i;
+		}
+	}
+	Program added = { program, -1, -1, false };
+	programs.push_back(added);
+	return (unsigned int)programs.size() - 1;
+}
+
+void RenderQueue::Submit(RenderPass pass, unsigned int program, const DrawItem& item, float distance)
+{
+	unsigned int index = ProgramIndex(program);
+	keys.push_back(makeSortKey(pass, index + 1, item.layer, item.object->VAO, distance / farPlane));
+	payloads.push_back((unsigned int)items.size());
+	items.push_back(item);
+	itemPrograms.push_back(index);
+}
+
+void RenderQueue::Submit(unsigned int program, const vector<DrawItem>& drawList, glm::vec3 camera, JobSystem& jobs)
+{
+	unsigned int index = ProgramIndex(program);
+	size_t base = keys.size();
+	unsigned int firstItem = (unsigned int)items.size();
+	keys.resize(base + drawList.size());
+	payloads.resize(base + drawList.size());
+	items.insert(items.end(), drawList.begin(), drawList.end());
+	itemPrograms.resize(items.size(), index);
+
+	// Cada indice escribe solo su lugar
+	jobs.ParallelFor((int)drawList.size(), 1024, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			const DrawItem& item = drawList[i];
+			float distance = glm::length(glm::vec3(item.model[3]) - camera);
+			keys[base + i] = makeSortKey(PASS_OPAQUE, index + 1, item.layer, item.object->VAO, distance / farPlane);
+			payloads[base + i] = firstItem + i;
+		}
+	});
+}
+
+void RenderQueue::Submit(RenderPass pass, unsigned int order, function<void()> callback)
+{
+	keys.push_back(((SortKey)pass << sortKeyPassShift) | (order & sortKeyDepthMask));
+	payloads.push_back((unsigned int)callbacks.size() | callbackPayload);
+	callbacks.push_back(move(callback));
+}
+
+void RenderQueue::Sort()
+{
+	radixSort(keys, payloads, keyScratch, payloadScratch);
+}
+
+void RenderQueue::RecordSlice(int begin, int end, CommandBuffer& buffer) const
+{
+	buffer.Clear();
+
+	// Estado vigente en este tramo; -1 obliga a fijarlo en el proximo dibujo
+	int program = -1;
+	int material = -1;
+	long long mesh = -1;
+	const Program* current = NULL;
+
+	for (int i = begin; i < end; i++) {
+		unsigned int payload = payloads[i];
+		if (payload & callbackPayload) {
+			buffer.Callback(payload & ~callbackPayload);
+			program = -1;
+			continue;
+		}
+
+		const DrawItem& item = items[payload];
+		int itemProgram = (int)itemPrograms[payload];
+		if (itemProgram != program) {
+			current = &programs[itemProgram];
+			buffer.UseProgram(current->id);
+			program = itemProgram;
+			material = -1;
+			mesh = -1;
+		}
+		if (item.layer != material) {
+			buffer.SetLayer(current->layerLocation, item.layer);
+			material = item.layer;
+		}
+		if ((long long)item.object->VAO != mesh) {
+			buffer.BindMesh(item.object);
+			mesh = item.object->VAO;
+		}
+		buffer.Draw(item.object, current->modelLocation, item.model);
+	}
+}
+
+void RenderQueue::Execute(JobSystem& jobs)
+{
+	// Las ubicaciones de los uniforms se piden a GL antes de repartir
+	for (Program& program : programs) {
+		if (!program.located) {
+			program.modelLocation = glGetUniformLocation(program.id, "model");
+			program.layerLocation = glGetUniformLocation(program.id, "layer");
+			program.located = true;
+		}
+	}
+
+	Record(jobs);
+	Replay();
+}
+
+void RenderQueue::Record(JobSystem& jobs)
+{
+	int count = (int)payloads.size();
+	int slices = max(1, min(jobs.ThreadCount(), count / recordSliceSize));
+	if ((int)buffers.size() < slices) {
+		buffers.resize(slices);
+	}
+
+	jobs.ParallelFor(slices, 1, [&](int first, int last) {
+		for (int slice = first; slice < last; slice++) {
+			RecordSlice(count * slice / slices, count * (slice + 1) / slices, buffers[slice]);
+		}
+	});
+	recordedSlices = slices;
+
+	stats = {};
+	for (int slice = 0; slice < slices; slice++) {
+		stats.draws += buffers[slice].draws;
+		stats.programChanges += buffers[slice].programChanges;
+		stats.materialChanges += buffers[slice].materialChanges;
+		stats.meshChanges += buffers[slice].meshChanges;
+	}
+}
+
+void RenderQueue::Replay()
+{
+	for (int slice = 0; slice < recordedSlices; slice++) {
+		buffers[slice].Replay(callbacks);
+	}
+	glBindVertexArray(0);
+}
@@ -0,0 +1,137 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include "Geometry.h"
+#include "Snapshot.h"
+#include "JobSystem.h"
+#include "CommandBuffer.h"
+
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+// Pasadas, en el orden en que se ejecutan
+enum RenderPass
+{
+	PASS_OPAQUE,     // objetos, de adelante hacia atras
+	PASS_TERRAIN,    // despues de los objetos: lo que tapan no se sombrea
+	PASS_LIGHTING,   // camino diferido: ilumina el G-buffer
+	PASS_SKY,        // despues de todo lo opaco, solo donde no hay nada
+	PASS_EFFECTS,    // particulas con mezcla, al final
+	PASS_COUNT
+};
+
+// Clave de orden de 64 bits, de mas a menos significativa:
+//   pasada 4 | programa 8 | material 8 | malla 16 | profundidad 28
+// Ordenar por la clave agrupa los cambios de estado mas caros y, dentro de
+// cada grupo, dibuja de adelante hacia atras para aprovechar el early-Z
+typedef unsigned long long SortKey;
+
+const int sortKeyPassShift = 60;
+const int sortKeyProgramShift = 52;
+const int sortKeyMaterialShift = 44;
+const int sortKeyMeshShift = 28;
+const SortKey sortKeyDepthMask = (1ull << sortKeyMeshShift) - 1;
+
+// 'depth' va de 0 (camara) a 1 (plano lejano); se satura fuera de ese rango
+SortKey makeSortKey(RenderPass pass, unsigned int program, unsigned int material, unsigned int mesh, float depth);
+
+// Radix sort LSD de 8 bits por digito, estable. Ordena 'keys' y mueve
+// 'values' con ellas; los digitos iguales en todas las claves se saltan.
+// Los scratch se reutilizan entre llamadas
+void radixSort(vector<SortKey>& keys, vector<unsigned int>& values,
+	vector<SortKey>& keyScratch, vector<unsigned int>& valueScratch);
+
+// Cambios de estado y dibujos de una ejecucion
+struct RenderStats
+{
+	int draws;
+	int programChanges;
+	int materialChanges;
+	int meshChanges;
+};
+
+// Cambios de estado que implica recorrer 'keys' en orden, sin tocar GL
+RenderStats countStateChanges(const vector<SortKey>& keys);
+
+// Cola de dibujo del frame. Los objetos y los dibujos especiales (cielo,
+// terreno, particulas) se encolan en cualquier orden con su clave; Sort la
+// ordena una vez y Execute la recorre cambiando solo el estado que difiere
+// del dibujo anterior. Encolar, ordenar y grabar los comandos no tocan GL:
+// Execute reparte la cola ordenada en tramos contiguos, cada hilo graba el
+// suyo en su CommandBuffer y el hilo de GL los reproduce en orden.
+class RenderQueue
+{
+public:
+
+	// Las distancias se normalizan contra 'farPlane'
+	RenderQueue(float farPlane);
+
+	void Clear();
+
+	// 'program' es el programa de GL (Shader::ID) con los uniforms 'model' y
+	// 'layer'. Toda la lista de dibujo va en la pasada opaca, con la distancia a
+	// 'camera'. Las claves se calculan en paralelo
+	void Submit(unsigned int program, const vector<DrawItem>& drawList, glm::vec3 camera, JobSystem& jobs);
+	void Submit(RenderPass pass, unsigned int program, const DrawItem& item, float distance);
+	// Dibujo que maneja su propio estado; 'order' lo ordena dentro de la
+	// pasada. Despues de el no se asume nada del estado de GL
+	void Submit(RenderPass pass, unsigned int order, function<void()> callback);
+
+	void Sort();
+	// Record y Replay. Solo desde el hilo de GL, que debe ser el hilo 0 de
+	// 'jobs'
+	void Execute(JobSystem& jobs);
+
+	// Graba la cola ordenada en un CommandBuffer por hilo, sin tocar GL
+	void Record(JobSystem& jobs);
+	// Reproduce lo grabado, en orden. Solo desde el hilo de GL
+	void Replay();
+
+	inline const RenderStats& LastStats() const
+	{
+		return stats;
+	};
+
+	inline size_t Size() const
+	{
+		return keys.size();
+	};
+
+private:
+
+	// Indice del programa en 'programs'. En la clave va mas uno, porque el
+	// 0 queda para los dibujos especiales
+	unsigned int ProgramIndex(unsigned int program);
+
+	// Graba los dibujos [begin, end) de la cola ordenada. Cada tramo
+	// empieza sin suponer nada del estado de GL
+	void RecordSlice(int begin, int end, CommandBuffer& buffer) const;
+
+	// Programas en el orden en que aparecieron. Las ubicaciones de los
+	// uniforms se buscan una sola vez, la primera vez que se ejecutan
+	struct Program
+	{
+		unsigned int id;
+		int modelLocation;
+		int layerLocation;
+		bool located;
+	};
+
+	float farPlane;
+	vector<Program> programs;
+	vector<DrawItem> items;
+	vector<unsigned int> itemPrograms;
+	vector<function<void()>> callbacks;
+	vector<SortKey> keys;
+	vector<unsigned int> payloads;
+	vector<SortKey> keyScratch;
+	vector<unsigned int> payloadScratch;
+	// Uno por hilo del JobSystem
+	vector<CommandBuffer> buffers;
+	int recordedSlices = 0;
+	RenderStats stats;
+};
+
+#endif
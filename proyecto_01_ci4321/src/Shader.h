@@ -38,8 +38,8 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+            vertexCode = resolveIncludes(vShaderStream.str(), vertexPath);
+            fragmentCode = resolveIncludes(fShaderStream.str(), fragmentPath);
         }
         catch (std::ifstream::failure& e)
         {
@@ -73,6 +73,39 @@ public:
         glDeleteShader(vertex);
         glDeleteShader(fragment);
     }
+    // compute shader program (GL 4.3)
+    // ------------------------------------------------------------------------
+    Shader(const char* computePath)
+    {
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = cShaderStream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.code().message() << std::endl;
+        }
+
+        const char* cShaderCode = computeCode.c_str();
+
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(compute);
+    }
     // activate the shader
     // ------------------------------------------------------------------------
     void use()
@@ -95,12 +128,54 @@ public:
     {
         glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
     }
+    void setVec2(const std::string& name, const glm::vec2& value) const
+    {
+        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    }
+    void setVec3(const std::string& name, const glm::vec3& value) const
+    {
+        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    }
+    void setVec4(const std::string& name, const glm::vec4& value) const
+    {
+        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    }
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // replaces each line '#include "file"' with the contents of 'file', read
+    // from the directory of 'path'. One level only: included files are pasted
+    // as they are
+    // ------------------------------------------------------------------------
+    static std::string resolveIncludes(const std::string& code, const std::string& path)
+    {
+        std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+        std::stringstream input(code);
+        std::string result;
+        std::string line;
+        while (std::getline(input, line))
+        {
+            if (line.rfind("#include \"", 0) != 0)
+            {
+                result += line + "\n";
+                continue;
+            }
+            std::string name = line.substr(10, line.find('"', 10) - 10);
+            std::ifstream includeFile(directory + name);
+            if (!includeFile)
+            {
+                std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << directory + name << std::endl;
+                continue;
+            }
+            std::stringstream includeStream;
+            includeStream << includeFile.rdbuf();
+            result += includeStream.str() + "\n";
+        }
+        return result;
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(unsigned int shader, std::string type)
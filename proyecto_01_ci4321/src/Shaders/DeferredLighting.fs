@@ -0,0 +1,49 @@
+#version 330 core
+// Pase de luces del camino diferido: un triangulo de pantalla completa que
+// ilumina cada pixel del G-buffer una sola vez, con las luces del froxel
+// en el que cae
+out vec4 FragColor;
+
+in vec2 ScreenCoord;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+uniform mat4 inverseView;
+
+#include "Lighting.glsl"
+
+vec3 octahedralDecode(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-normal.z, 0.0);
+	normal.x += normal.x >= 0.0 ? -fold : fold;
+	normal.y += normal.y >= 0.0 ? -fold : fold;
+	return normalize(normal);
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, pixel, 0).r;
+	// Sin geometria; el cielo se dibuja despues
+	if (depth == 1.0) {
+		discard;
+	}
+
+	vec4 albedoMaterial = texelFetch(gAlbedo, pixel, 0);
+	int layer = int(albedoMaterial.a * 255.0 + 0.5);
+
+	uvec3 bytes = uvec3(texelFetch(gNormal, pixel, 0).rgb * 255.0 + 0.5);
+	uvec2 encoded = uvec2((bytes.x << 4u) | (bytes.y >> 4u), ((bytes.y & 15u) << 8u) | bytes.z);
+	vec3 normal = octahedralDecode(vec2(encoded) / 4095.0 * 2.0 - 1.0);
+
+	// Posicion reconstruida desde la profundidad
+	vec2 ndc = gl_FragCoord.xy / clusterViewport * 2.0 - 1.0;
+	vec4 viewPosition = inverseProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+	viewPosition /= viewPosition.w;
+	vec3 position = (inverseView * viewPosition).xyz;
+
+	FragColor = vec4(albedoMaterial.rgb * shade(position, -viewPosition.z, normal, layer), 1.0);
+}
@@ -2,12 +2,20 @@
 out vec4 FragColor;
 
 in vec2 TexCoord;
+in vec3 Normal;
+in vec3 WorldPosition;
+in float ViewDepth;
 
-// texture samplers
-uniform sampler2D texture1;
+// arreglo de texturas de materiales y capa del objeto actual
+uniform sampler2DArray materials;
+uniform int layer;
+
+#include "Lighting.glsl"
 
 void main()
 {
-	// linearly interpolate between both textures (80% container, 20% awesomeface)
-	FragColor = texture(texture1, TexCoord);
-}
\ No newline at end of file
+	vec3 normal = normalize(Normal);
+	vec3 light = shade(WorldPosition, ViewDepth, normal, layer);
+	vec4 color = texture(materials, vec3(TexCoord, layer));
+	FragColor = vec4(color.rgb * light, color.a);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+// Camino diferido: en lugar de iluminar se guarda lo necesario para hacerlo
+// despues, una sola vez por pixel (ver DeferredShading)
+layout (location = 0) out vec4 AlbedoMaterial; // albedo, capa de material
+layout (location = 1) out vec4 PackedNormal;   // normal octaedrica de 12:12 bits
+
+in vec2 TexCoord;
+in vec3 Normal;
+in vec3 WorldPosition;
+in float ViewDepth;
+
+// arreglo de texturas de materiales y capa del objeto actual
+uniform sampler2DArray materials;
+uniform int layer;
+
+// Proyecta la normal sobre el octaedro |x| + |y| + |z| = 1 y despliega la
+// mitad de abajo sobre las esquinas del cuadrado [-1, 1]^2
+vec2 octahedralEncode(vec3 normal)
+{
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+	if (normal.z < 0.0) {
+		vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+		return (1.0 - abs(normal.yx)) * signs;
+	}
+	return normal.xy;
+}
+
+void main()
+{
+	// Dos componentes de 12 bits repartidas en tres bytes
+	uvec2 encoded = uvec2(round((octahedralEncode(normalize(Normal)) * 0.5 + 0.5) * 4095.0));
+	uvec3 bytes = uvec3(encoded.x >> 4u, ((encoded.x & 15u) << 4u) | (encoded.y >> 8u), encoded.y & 255u);
+	PackedNormal = vec4(vec3(bytes) / 255.0, 0.0);
+
+	vec4 color = texture(materials, vec3(TexCoord, layer));
+	// La capa va en el alfa; DeferredLighting.fs la usa para la respuesta
+	// del material a la luz
+	AlbedoMaterial = vec4(color.rgb, float(layer) / 255.0);
+}
@@ -0,0 +1,103 @@
+// Iluminacion comun de FragmentShader.fs (forward) y DeferredLighting.fs.
+// Se pega con #include despues de la linea de #version
+
+// luces repartidas por froxel (ver ClusteredLighting): (inicio, cantidad)
+// por froxel, lista de indices y 3 texels por luz
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterIndices;
+uniform samplerBuffer clusterLights;
+uniform vec2 clusterViewport;
+uniform float clusterNear;
+uniform float clusterSliceScale;
+
+const ivec3 clusterSize = ivec3(16, 9, 24);
+
+// sombras del sol en cascadas (ver CascadedShadows): matriz de mundo a
+// texels de cada cascada, profundidad de vista donde termina cada una y
+// cuanto correr el punto sobre su normal
+const int shadowCascades = 3;
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[shadowCascades];
+uniform vec4 shadowSplits;
+uniform vec4 shadowNormalOffsets;
+
+// hacia el sol
+uniform vec3 sunDirection;
+const vec3 sunColor = vec3(0.65);
+const vec3 ambient = vec3(0.35);
+
+// Respuesta de cada capa de material (MaterialLayer en Texture.h) a la luz
+// del sol y a la ambiente: el metal desnudo refleja mas el sol directo y
+// recibe menos luz difusa que la pintura o los bloques
+const int materialLayers = 3;
+const float materialSun[materialLayers] = float[](1.0, 0.9, 1.3);
+const float materialAmbient[materialLayers] = float[](1.0, 1.0, 0.75);
+
+vec3 clusterLighting(vec3 position, float viewDepth, vec3 normal)
+{
+	ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterViewport * vec2(clusterSize.xy)), ivec2(0), clusterSize.xy - 1);
+	int slice = clamp(int(log(viewDepth / clusterNear) * clusterSliceScale), 0, clusterSize.z - 1);
+	uvec2 cluster = texelFetch(clusterGrid, (slice * clusterSize.y + tile.y) * clusterSize.x + tile.x).rg;
+
+	vec3 light = vec3(0.0);
+	for (uint i = 0u; i < cluster.y; i++) {
+		int index = int(texelFetch(clusterIndices, int(cluster.x + i)).r) * 3;
+		vec4 positionRadius = texelFetch(clusterLights, index);
+		vec4 colorSpot = texelFetch(clusterLights, index + 1);
+
+		vec3 toLight = positionRadius.xyz - position;
+		float distance = length(toLight);
+		if (distance >= positionRadius.w) {
+			continue;
+		}
+		vec3 direction = toLight / distance;
+
+		// Caida con el cuadrado de la distancia, llevada a cero en el radio
+		float ratio = distance / positionRadius.w;
+		float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+		float attenuation = window * window / (1.0 + distance * distance);
+
+		// Spot: borde suave en el ultimo quinto del cono
+		if (colorSpot.w > -1.0) {
+			vec3 axis = texelFetch(clusterLights, index + 2).xyz;
+			attenuation *= smoothstep(colorSpot.w, mix(colorSpot.w, 1.0, 0.2), dot(-direction, axis));
+		}
+
+		light += colorSpot.rgb * attenuation * max(dot(normal, direction), 0.0);
+	}
+	return light;
+}
+
+float sunShadow(vec3 position, float viewDepth, vec3 normal)
+{
+	int cascade = 0;
+	while (cascade < shadowCascades && viewDepth > shadowSplits[cascade]) {
+		cascade++;
+	}
+	if (cascade == shadowCascades) {
+		return 1.0;
+	}
+
+	position += normal * shadowNormalOffsets[cascade];
+	vec3 coord = (shadowMatrices[cascade] * vec4(position, 1.0)).xyz;
+
+	// PCF de 3x3 lecturas, cada una ya filtrada 2x2 por el hardware
+	vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+	float lit = 0.0;
+	for (int y = -1; y <= 1; y++) {
+		for (int x = -1; x <= 1; x++) {
+			lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(cascade), coord.z));
+		}
+	}
+	return lit / 9.0;
+}
+
+// Luz total que recibe un punto con normal unitaria 'normal' y material
+// de la capa 'layer'
+vec3 shade(vec3 position, float viewDepth, vec3 normal, int layer)
+{
+	int material = clamp(layer, 0, materialLayers - 1);
+	float sun = max(dot(normal, sunDirection), 0.0) * sunShadow(position, viewDepth, normal);
+	return ambient * materialAmbient[material] + sunColor * sun * materialSun[material]
+		+ clusterLighting(position, viewDepth, normal);
+}
@@ -0,0 +1,45 @@
+#version 430 core
+
+struct Particle
+{
+	vec4 positionAge;
+	vec4 velocityLife;
+};
+
+layout (std430, binding = 0) readonly buffer Particles
+{
+	Particle particles[];
+};
+
+layout (std430, binding = 1) readonly buffer Visible
+{
+	uint visible[];
+};
+
+out vec2 Corner;
+out vec4 Color;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float startSize;
+uniform float endSize;
+uniform vec4 startColor;
+uniform vec4 endColor;
+
+void main()
+{
+	// Una instancia por particula visible, un quad en triangle strip
+	Particle particle = particles[visible[gl_InstanceID]];
+	float t = clamp(particle.positionAge.w / particle.velocityLife.w, 0.0, 1.0);
+
+	Corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+	Color = mix(startColor, endColor, t);
+
+	// Ejes derecha y arriba de la camara, las filas de la vista
+	vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+	vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+	float halfSize = mix(startSize, endSize, t) * 0.5;
+
+	vec3 position = particle.positionAge.xyz + (right * Corner.x + up * Corner.y) * halfSize;
+	gl_Position = projection * view * vec4(position, 1.0);
+}
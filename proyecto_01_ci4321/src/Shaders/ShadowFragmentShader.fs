@@ -0,0 +1,6 @@
+#version 330 core
+
+// Solo se escribe la profundidad
+void main()
+{
+}
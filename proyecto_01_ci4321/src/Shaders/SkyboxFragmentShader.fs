@@ -7,5 +7,5 @@ uniform samplerCube skybox;
 
 void main()
 {    
-    FragColor = texture(skybox, TexCoords);
-}
\ No newline at end of file
+    FragColor = texture(skybox, normalize(TexCoords));
+}
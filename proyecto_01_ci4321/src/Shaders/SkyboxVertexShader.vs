@@ -1,13 +1,20 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
+// Triangulo que cubre la pantalla, sin atributos: los vertices salen de
+// gl_VertexID. Queda en el plano lejano (profundidad 1.0)
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+// inversa de projection * view sin la traslacion de la camara
+uniform mat4 inverseViewProjection;
 
 void main()
 {
-    TexCoords = aPos;
-    gl_Position = projection * view * vec4(aPos, 1.0);
-}  
\ No newline at end of file
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+    // Direccion del rayo de vista que pasa por este vertice; se interpola
+    // lineal porque todos los vertices tienen w = 1
+    vec4 far = inverseViewProjection * vec4(position, 1.0, 1.0);
+    TexCoords = far.xyz / far.w;
+
+    gl_Position = vec4(position, 1.0, 1.0);
+}
@@ -0,0 +1,57 @@
+#version 330 core
+layout (location = 0) in vec2 aGrid;
+
+out vec2 TexCoord;
+out vec3 Normal;
+out vec3 WorldPosition;
+out float ViewDepth;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// alturas del mapa completo, una muestra por texel
+uniform sampler2D heights;
+uniform vec3 mapOrigin;
+uniform float cellSize;
+uniform int mapSamples;
+
+// esquina y escala del trozo actual; 'stitch' es el paso de cada borde
+// (-x, +x, -z, +z) para pegarse a un vecino mas grueso
+uniform vec3 chunkOrigin;
+uniform float chunkScale;
+uniform vec4 stitch;
+
+const float quads = 32.0;
+
+float height(ivec2 texel)
+{
+	texel = clamp(texel, ivec2(0), ivec2(mapSamples - 1));
+	return texelFetch(heights, texel, 0).r;
+}
+
+void main()
+{
+	vec2 grid = aGrid;
+
+	// Los vertices de un borde con vecino mas grueso caen sobre el vertice
+	// mas cercano del vecino; los triangulos sobrantes quedan degenerados
+	if (grid.x == 0.0) grid.y = floor(grid.y / stitch.x + 0.5) * stitch.x;
+	if (grid.x == quads) grid.y = floor(grid.y / stitch.y + 0.5) * stitch.y;
+	if (grid.y == 0.0) grid.x = floor(grid.x / stitch.z + 0.5) * stitch.z;
+	if (grid.y == quads) grid.x = floor(grid.x / stitch.w + 0.5) * stitch.w;
+
+	vec2 xz = chunkOrigin.xz + grid * chunkScale;
+	ivec2 texel = ivec2(round((xz - mapOrigin.xz) / cellSize));
+
+	float left = height(texel - ivec2(1, 0));
+	float right = height(texel + ivec2(1, 0));
+	float down = height(texel - ivec2(0, 1));
+	float up = height(texel + ivec2(0, 1));
+	Normal = normalize(vec3(left - right, 2.0 * cellSize, down - up));
+
+	TexCoord = xz * 0.25;
+	WorldPosition = vec3(xz.x, height(texel), xz.y);
+	vec4 viewPosition = view * vec4(WorldPosition, 1.0);
+	ViewDepth = -viewPosition.z;
+	gl_Position = projection * viewPosition;
+}
@@ -0,0 +1,39 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 ScreenCoord;
+
+// escena dibujada en la esquina inferior izquierda de la textura
+uniform sampler2D scene;
+// fraccion de la textura que ocupa la escena
+uniform vec2 sceneScale;
+uniform float sharpness;
+
+// Lectura bilineal sin salir del rectangulo de la escena
+vec3 fetch(vec2 coord, vec2 texel)
+{
+	return texture(scene, clamp(coord, 0.5 * texel, sceneScale - 0.5 * texel)).rgb;
+}
+
+void main()
+{
+	vec2 texel = 1.0 / vec2(textureSize(scene, 0));
+	vec2 coord = ScreenCoord * sceneScale;
+
+	vec3 center = fetch(coord, texel);
+	vec3 north = fetch(coord + vec2(0.0, texel.y), texel);
+	vec3 south = fetch(coord - vec2(0.0, texel.y), texel);
+	vec3 east = fetch(coord + vec2(texel.x, 0.0), texel);
+	vec3 west = fetch(coord - vec2(texel.x, 0.0), texel);
+
+	// Nitidez adaptativa: se resta la cruz de vecinos con un peso que baja
+	// donde el contraste local ya es alto, asi los bordes no se pasan de
+	// blanco o negro ni aparecen halos
+	vec3 low = min(center, min(min(north, south), min(east, west)));
+	vec3 high = max(center, max(max(north, south), max(east, west)));
+	vec3 amount = sqrt(clamp(min(low, 1.0 - high) / max(high, vec3(1.0 / 256.0)), 0.0, 1.0));
+	vec3 weight = amount * (-1.0 / mix(8.0, 5.0, sharpness));
+
+	vec3 color = (center + (north + south + east + west) * weight) / (1.0 + 4.0 * weight);
+	FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
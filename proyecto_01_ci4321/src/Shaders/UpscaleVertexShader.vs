@@ -0,0 +1,12 @@
+#version 330 core
+// Triangulo que cubre la pantalla, sin atributos; 'ScreenCoord' va de 0 a 1
+// sobre la ventana
+
+out vec2 ScreenCoord;
+
+void main()
+{
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	ScreenCoord = position;
+	gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
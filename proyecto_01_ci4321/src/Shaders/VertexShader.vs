@@ -1,8 +1,12 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec3 aNormal;
 
 out vec2 TexCoord;
+out vec3 Normal;
+out vec3 WorldPosition;
+out float ViewDepth;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -10,6 +14,13 @@ uniform mat4 projection;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0f);
+	vec4 world = model * vec4(aPos, 1.0f);
+	vec4 viewPosition = view * world;
+	gl_Position = projection * viewPosition;
 	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
-}
\ No newline at end of file
+
+	// model solo rota y traslada: no hace falta la inversa transpuesta
+	Normal = mat3(model) * aNormal;
+	WorldPosition = world.xyz;
+	ViewDepth = -viewPosition.z;
+}
@@ -0,0 +1,433 @@
+#include "Simulation.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+
+// Celdas de la broadphase, del orden del tamanno del tanque
+const float broadphaseCellSize = 4.0f;
+
+// Efectos que viajan en cada foto
+const size_t effectHistory = 64;
+
+// Si la simulacion se atrasa mas que esto (p. ej. con el proceso suspendido)
+// se descarta el tiempo perdido en lugar de encadenar pasos para alcanzarlo
+const double maxLag = 0.25;
+
+static double elapsedMs(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+Simulation::Simulation(float step)
+	: step(step), ground(NULL), ballistics(defaultBallistics()), broadphase(broadphaseCellSize)
+{
+	stepCount = 0;
+	effectCount = 0;
+	running = false;
+	timings = {};
+}
+
+Simulation::~Simulation()
+{
+	Stop();
+}
+
+void Simulation::AddTank(Tank& tank)
+{
+	int owner = (int)tanks.size();
+	tanks.push_back(&tank);
+	tank.GetParts(objects);
+
+	// El cuerpo del tanque representa a todo el tanque en las colisiones
+	bodies.push_back({ BODY_TANK, tank.getBody(), owner });
+	bodies.push_back({ BODY_PROJECTILE, tank.getProjectile(), owner });
+}
+
+void Simulation::AddTarget(Geometry& target)
+{
+	// Los objetivos no se mueven, solo desaparecen
+	target.isStatic = true;
+	targets.push_back(&target);
+	objects.push_back(&target);
+	bodies.push_back({ BODY_TARGET, &target, -1 });
+}
+
+void Simulation::SetGround(const Heightmap* ground)
+{
+	this->ground = ground;
+}
+
+void Simulation::AddScenery(Geometry& object)
+{
+	object.isStatic = true;
+	scenery.push_back(&object);
+	objects.push_back(&object);
+}
+
+int Simulation::AddProjectile(Cylinder& projectile)
+{
+	projectile.visible = false;
+	projectiles.push_back(&projectile);
+	objects.push_back(&projectile);
+	bodies.push_back({ BODY_PROJECTILE, &projectile, -1 });
+	return (int)projectiles.size() - 1;
+}
+
+void Simulation::LaunchProjectile(int projectile, glm::vec3 position, glm::vec3 velocity)
+{
+	int tag = -(projectile + 1);
+	int index = ballistics.Find(tag);
+	if (index >= 0) {
+		ballistics.Remove(index);
+	}
+
+	Cylinder* object = projectiles[projectile];
+	object->SetPosition(position);
+	object->SetRotation(orientationAlong(velocity));
+	object->visible = true;
+	ballistics.Spawn(position, velocity, projectileLifetime, tag);
+}
+
+TankState Simulation::GetTankState(int tank) const
+{
+	TankState state = tanks[tank]->GetState();
+	int index = state.projectileFlying ? ballistics.Find(tank) : -1;
+	if (index >= 0) {
+		state.projectileVelocity = ballistics.Velocity(index);
+		state.projectileLife = ballistics.Life(index);
+	}
+	return state;
+}
+
+Cylinder* Simulation::ProjectileObject(int tag) const
+{
+	return tag >= 0 ? tanks[tag]->getProjectile() : projectiles[-tag - 1];
+}
+
+void Simulation::Capture(FrameSnapshot& snapshot) const
+{
+	captureSnapshot(objects, snapshot);
+	snapshot.effects = recentEffects;
+}
+
+void Simulation::RaiseEffect(EffectKind kind, glm::vec3 position, glm::vec3 direction)
+{
+	if (recentEffects.size() >= effectHistory) {
+		recentEffects.erase(recentEffects.begin());
+	}
+	recentEffects.push_back({ kind, position, direction, ++effectCount });
+}
+
+void Simulation::Start()
+{
+	if (running) {
+		return;
+	}
+
+	// Foto inicial para que el render tenga algo que dibujar antes del
+	// primer paso
+	FrameSnapshot& snapshot = snapshots.Back();
+	Capture(snapshot);
+	snapshot.time = glfwGetTime();
+	snapshot.step = 0;
+	snapshots.Publish();
+
+	running = true;
+	worker = thread(&Simulation::ThreadLoop, this);
+}
+
+void Simulation::Stop()
+{
+	running = false;
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void Simulation::SetInput(const TankInput& input)
+{
+	inputs.Back() = input;
+	inputs.Publish();
+}
+
+const FrameSnapshot& Simulation::LatestSnapshot()
+{
+	snapshots.Consume();
+	return snapshots.Front();
+}
+
+float Simulation::Interpolation(const FrameSnapshot& snapshot, double now) const
+{
+	float alpha = (float)((now - snapshot.time) / step);
+	return std::clamp(alpha, 0.0f, 1.0f);
+}
+
+void Simulation::ThreadLoop()
+{
+	double next = glfwGetTime() + step;
+
+	while (running) {
+		double now = glfwGetTime();
+		if (now < next) {
+			this_thread::sleep_for(chrono::duration<double>(next - now));
+			continue;
+		}
+		if (now - next > maxLag) {
+			next = now;
+		}
+
+		// Solo el primer tanque lo maneja el jugador
+		inputs.Consume();
+		tankInputs.assign(tanks.size(), TankInput());
+		if (!tankInputs.empty()) {
+			tankInputs[0] = inputs.Front();
+		}
+		Step(tankInputs);
+
+		// La foto se escribe en el buffer trasero, que el render no lee
+		FrameSnapshot& snapshot = snapshots.Back();
+		Capture(snapshot);
+		snapshot.time = next;
+		snapshot.step = ++stepCount;
+		snapshots.Publish();
+
+		next += step;
+	}
+}
+
+void Simulation::Step(const vector<TankInput>& inputs)
+{
+	auto start = chrono::steady_clock::now();
+
+	for (Tank* tank : tanks) {
+		tank->SaveState();
+	}
+	for (Geometry* object : targets) {
+		object->SaveState();
+	}
+	for (Geometry* object : scenery) {
+		object->SaveState();
+	}
+	for (Cylinder* projectile : projectiles) {
+		projectile->SaveState();
+	}
+
+	for (unsigned int i = 0; i < tanks.size(); i++) {
+		Tank* tank = tanks[i];
+		bool loaded = !tank->getProjectile()->visible;
+		tank->Update(i < inputs.size() ? inputs[i] : TankInput(), step);
+
+		// Apoya el tanque en el suelo; un proyectil recien disparado sube
+		// con el canon
+		if (ground) {
+			glm::vec3 position = tank->getPosition();
+			glm::vec3 lift(0.0f, ground->Height(position.x, position.z) + tankRideHeight - position.y, 0.0f);
+			tank->Move(lift);
+			if (loaded && tank->getProjectile()->visible) {
+				Cylinder* projectile = tank->getProjectile();
+				projectile->SetPosition(projectile->position + lift);
+			}
+		}
+
+		if (loaded && tank->getProjectile()->visible) {
+			glm::vec3 direction = tank->getMuzzleDirection();
+			ballistics.Spawn(tank->getProjectile()->position, direction * muzzleSpeed, projectileLifetime, i);
+			RaiseEffect(EFFECT_MUZZLE_FLASH, tank->getMuzzlePosition(), direction);
+		}
+	}
+	MoveProjectiles();
+	timings.movement = elapsedMs(start);
+
+	// Broadphase: solo los pares que comparten celda llegan a la prueba de
+	// cajas, que se hace por lotes. Las AABB sirven de descarte rapido; las
+	// cajas orientadas solo se prueban en ResolvePair para los que se solapan
+	start = chrono::steady_clock::now();
+	UpdateBroadphase();
+	broadphase.FindPairs(candidatePairs);
+	timings.broadphase = elapsedMs(start);
+
+	start = chrono::steady_clock::now();
+	overlapPairs(bodyBoxes, candidatePairs, contactPairs);
+	timings.narrowphase = elapsedMs(start);
+
+	start = chrono::steady_clock::now();
+	for (const pair<int, int>& contact : contactPairs) {
+		ResolvePair(contact.first, contact.second);
+	}
+	RemoveHitProjectiles();
+	timings.resolve = elapsedMs(start);
+}
+
+void Simulation::MoveProjectiles()
+{
+	expiredProjectiles.clear();
+	ballistics.Update(step, expiredProjectiles);
+
+	// Los cilindros siguen a la integracion, apuntando hacia donde van
+	for (int i = 0; i < ballistics.Count(); i++) {
+		Cylinder* object = ProjectileObject(ballistics.Tag(i));
+		object->position = ballistics.Position(i);
+		object->rotation = orientationAlong(ballistics.Velocity(i));
+
+		// Bajo el suelo: se oculta y RemoveHitProjectiles lo saca
+		if (ground && object->visible && object->position.y < ground->Height(object->position.x, object->position.z)) {
+			object->visible = false;
+			RaiseEffect(EFFECT_EXPLOSION, object->position, glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+	}
+
+	// Fuera del mundo o sin vida: el tanque vuelve a estar cargado
+	for (int tag : expiredProjectiles) {
+		if (tag >= 0) {
+			tanks[tag]->setHasBeenShot();
+		}
+		else {
+			projectiles[-tag - 1]->visible = false;
+		}
+	}
+}
+
+void Simulation::RemoveHitProjectiles()
+{
+	// Los que ocultaron las colisiones (o un tanque que se oculto) dejan de
+	// integrarse. De atras hacia adelante porque Remove mueve el ultimo
+	for (int i = ballistics.Count() - 1; i >= 0; i--) {
+		int tag = ballistics.Tag(i);
+		if (!ProjectileObject(tag)->visible) {
+			if (tag >= 0) {
+				tanks[tag]->setHasBeenShot();
+			}
+			ballistics.Remove(i);
+		}
+	}
+}
+
+void Simulation::UpdateBroadphase()
+{
+	bodyBoxes.Resize(bodies.size());
+
+	for (unsigned int i = 0; i < bodies.size(); i++) {
+		Geometry* object = bodies[i].object;
+		if (object->visible) {
+			bodies[i].world = object->ModelMatrix(object->position, object->rotation);
+			bodies[i].orientedBox = transformOrientedBounds(bodies[i].world, object->size);
+			AABB box = transformBounds(bodies[i].world, object->size);
+
+			// Los proyectiles ocupan todo el volumen barrido en el paso, asi
+			// no atraviesan objetivos delgados aunque vayan rapido
+			if (bodies[i].kind == BODY_PROJECTILE) {
+				glm::vec3 start, end;
+				projectileSweep(*(Cylinder*)object, start, end);
+				float radius = ((Cylinder*)object)->radius;
+				box.min = glm::min(start, end) - radius;
+				box.max = glm::max(start, end) + radius;
+			}
+
+			broadphase.Update(i, box);
+			bodyBoxes.Set(i, box);
+		}
+		else {
+			broadphase.Remove(i);
+		}
+	}
+}
+
+void Simulation::ResolvePair(int first, int second)
+{
+	Body* one = &bodies[first];
+	Body* two = &bodies[second];
+	if (one->kind > two->kind) {
+		swap(one, two);
+	}
+
+	// Un cuerpo pudo desaparecer por un par anterior del mismo paso
+	if (!one->object->visible || !two->object->visible) {
+		return;
+	}
+
+	// Las AABB ya se solapan; falta la prueba exacta con la rotacion
+	if (one->kind == BODY_TANK && two->kind == BODY_TARGET) {
+		Geometry* target = two->object;
+		bool touching;
+		if (target->rotation == glm::vec3(0.0f)) {
+			touching = overlapOBB(one->orientedBox, AABB{ target->position - target->size * 0.5f, target->position + target->size * 0.5f });
+		}
+		else {
+			touching = overlapOBB(one->orientedBox, two->orientedBox);
+		}
+
+		if (touching) {
+			target->visible = false;
+			RaiseEffect(EFFECT_EXPLOSION, target->position, glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+	}
+	else if (one->kind == BODY_TARGET && two->kind == BODY_PROJECTILE) {
+		// Prueba continua: esfera del radio del proyectil barriendo el
+		// segmento del paso contra la caja orientada del objetivo
+		Geometry* target = one->object;
+		Cylinder* projectile = (Cylinder*)two->object;
+
+		glm::vec3 start, end;
+		projectileSweep(*projectile, start, end);
+
+		float toi;
+		if (!sweepSphereOBB(start, end, projectile->radius, one->orientedBox, toi)) {
+			return;
+		}
+
+		// El proyectil queda con la punta en el punto de impacto
+		glm::vec3 direction = end - start;
+		float length = glm::length(direction);
+		glm::vec3 contact = glm::mix(start, end, toi);
+		projectile->position = length > 0.0f ? contact - direction / length * (projectile->height * 0.5f) : contact;
+
+		target->visible = false;
+		RaiseEffect(EFFECT_EXPLOSION, contact, length > 0.0f ? -direction / length : glm::vec3(0.0f, 1.0f, 0.0f));
+		if (two->owner >= 0) {
+			tanks[two->owner]->setHasBeenShot();
+		}
+		else {
+			projectile->visible = false;
+		}
+	}
+}
+
+AABB collisionBounds(Geometry& object)
+{
+	return transformBounds(object.ModelMatrix(object.position, object.rotation), object.size);
+}
+
+void projectileSweep(Cylinder& projectile, glm::vec3& start, glm::vec3& end)
+{
+	start = projectile.prevPosition;
+	end = projectile.position;
+
+	glm::vec3 direction = end - start;
+	float length = glm::length(direction);
+	if (length > 0.0f) {
+		glm::vec3 halfBody = direction / length * (projectile.height * 0.5f);
+		start -= halfBody;
+		end += halfBody;
+	}
+}
+
+bool CheckCollision(Cube& one, Tank& two) // AABB - AABB collision
+{
+	// Las mallas estan centradas en position: se comparan las distancias
+	// entre centros con la suma de las semiextensiones
+	glm::vec3 distance = glm::abs(one.position - two.getPosition());
+	glm::vec3 reach = (one.size + two.getSize()) * 0.5f;
+
+	// collision only if on all axes
+	return distance.x <= reach.x && distance.y <= reach.y && distance.z <= reach.z;
+}
+
+bool CheckCollisionProjectile(Cube& one, Cylinder& two) // AABB - AABB collision
+{
+	glm::vec3 distance = glm::abs(one.position - two.getPosition());
+	glm::vec3 reach = (one.size + two.getSize()) * 0.5f;
+
+	// collision only if on all axes
+	return distance.x <= reach.x && distance.y <= reach.y && distance.z <= reach.z;
+}
@@ -0,0 +1,170 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "Geometry.h"
+#include "Tank.h"
+#include "Snapshot.h"
+#include "Broadphase.h"
+#include "Narrowphase.h"
+#include "Sweep.h"
+#include "Ballistics.h"
+#include "Heightmap.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Simulacion de la escena en su propio hilo, a paso fijo. Tras cada paso
+// publica un FrameSnapshot en un triple buffer; el hilo de render dibuja la
+// ultima foto mientras se simula la siguiente. La simulacion nunca llama a
+// GL: los objetos que desaparecen solo se marcan como no visibles.
+class Simulation
+{
+public:
+
+	// Tiempo de cada etapa del ultimo paso, en milisegundos
+	struct StepTimings
+	{
+		double movement;
+		double broadphase;
+		double narrowphase;
+		double resolve;
+	};
+
+	Simulation(float step);
+	~Simulation();
+
+	// La escena se arma antes de Start. El primer tanque es el del jugador
+	void AddTank(Tank& tank);
+	// Objetivos: desaparecen al chocar con un tanque o un proyectil
+	void AddTarget(Geometry& target);
+	// Objetos que solo se dibujan
+	void AddScenery(Geometry& object);
+	// Suelo opcional: los tanques van apoyados en el y los proyectiles que
+	// lo tocan explotan. Sin suelo (NULL) la altura no cambia
+	void SetGround(const Heightmap* ground);
+	// Proyectil sin tanque; queda oculto hasta LaunchProjectile. Devuelve
+	// su indice
+	int AddProjectile(Cylinder& projectile);
+	// Lanza (o relanza) el proyectil suelto 'projectile'. Desaparece al
+	// chocar o al salir del mundo
+	void LaunchProjectile(int projectile, glm::vec3 position, glm::vec3 velocity);
+
+	void Start();
+	void Stop();
+
+	// Hilo principal: ultimo estado de las teclas
+	void SetInput(const TankInput& input);
+
+	// Hilo de render: ultima foto publicada
+	const FrameSnapshot& LatestSnapshot();
+
+	// Fraccion de paso a interpolar para dibujar 'snapshot' en el instante
+	// 'now'. El render va un paso por detras de la simulacion
+	float Interpolation(const FrameSnapshot& snapshot, double now) const;
+
+	// Copia objetos y efectos recientes en 'snapshot'
+	void Capture(FrameSnapshot& snapshot) const;
+
+	// Objetos en el orden de FrameSnapshot::objects
+	inline const vector<Geometry*>& Objects() const
+	{
+		return objects;
+	};
+
+	// Estado del tanque 'tank' con la velocidad y vida de su proyectil
+	TankState GetTankState(int tank) const;
+
+	// Un paso de simulacion: movimiento, proyectiles y colisiones.
+	// inputs[i] corresponde al tanque i; los que faltan quedan quietos
+	void Step(const vector<TankInput>& inputs);
+
+	inline const StepTimings& LastTimings() const
+	{
+		return timings;
+	};
+
+	// Celdas ocupadas de la broadphase, para medir memoria
+	inline size_t BroadphaseCells() const
+	{
+		return broadphase.CellCount();
+	};
+
+private:
+
+	enum BodyKind
+	{
+		BODY_TANK,
+		BODY_TARGET,
+		BODY_PROJECTILE
+	};
+
+	// Cuerpo registrado en la broadphase; su id es el indice en 'bodies'.
+	// 'owner' es el tanque del cuerpo o de su proyectil, -1 si no tiene.
+	// La matriz de mundo y la caja orientada se calculan una vez por paso
+	struct Body
+	{
+		BodyKind kind;
+		Geometry* object;
+		int owner;
+		// Los llena UpdateBroadphase en cada paso
+		glm::mat4 world = glm::mat4(1.0f);
+		OBB orientedBox = {};
+	};
+
+	void ThreadLoop();
+	void UpdateBroadphase();
+	void ResolvePair(int first, int second);
+	void RaiseEffect(EffectKind kind, glm::vec3 position, glm::vec3 direction);
+	void MoveProjectiles();
+	void RemoveHitProjectiles();
+	Cylinder* ProjectileObject(int tag) const;
+
+	float step;
+	const Heightmap* ground;
+	vector<Tank*> tanks;
+	vector<Geometry*> targets;
+	vector<Geometry*> scenery;
+	vector<Cylinder*> projectiles;
+	vector<Geometry*> objects;
+	vector<TankInput> tankInputs;
+	StepTimings timings;
+
+	// Todos los proyectiles en vuelo. El tag es el indice del tanque, o
+	// -(i + 1) para el proyectil suelto i
+	ProjectileSystem ballistics;
+	vector<int> expiredProjectiles;
+
+	// Solo se guardan los ultimos efectos: el render nunca se atrasa tanto
+	vector<EffectEvent> recentEffects;
+	unsigned long long effectCount;
+
+	vector<Body> bodies;
+	SpatialHashGrid broadphase;
+	vector<pair<int, int>> candidatePairs;
+	BoxSoA bodyBoxes;
+	vector<pair<int, int>> contactPairs;
+
+	TripleBuffer<TankInput> inputs;
+	TripleBuffer<FrameSnapshot> snapshots;
+	unsigned long long stepCount;
+
+	atomic<bool> running;
+	thread worker;
+};
+
+// Caja de colision alineada a los ejes que envuelve la malla con su rotacion
+AABB collisionBounds(Geometry& object);
+
+// Segmento que barre un proyectil en el ultimo paso, alargado medio cuerpo
+// hacia atras y hacia adelante para cubrir el largo del cilindro
+void projectileSweep(Cylinder& projectile, glm::vec3& start, glm::vec3& end);
+
+// Pruebas escalares de a un par; la simulacion usa overlapPairs
+bool CheckCollision(Cube& one, Tank& two);
+bool CheckCollisionProjectile(Cube& one, Cylinder& two);
+
+#endif
@@ -0,0 +1,41 @@
+#include "Skybox.h"
+
+#include <gtc/matrix_transform.hpp>
+
+Skybox::Skybox(unsigned int cubemap)
+	: cubemap(cubemap)
+{
+	shader = new Shader("src/Shaders/SkyboxVertexShader.vs", "src/Shaders/SkyboxFragmentShader.fs");
+	shader->use();
+	shader->setInt("skybox", 0);
+
+	glGenVertexArrays(1, &vao);
+}
+
+Skybox::~Skybox()
+{
+	glDeleteVertexArrays(1, &vao);
+	delete shader;
+}
+
+void Skybox::Draw(const glm::mat4& view, const glm::mat4& projection)
+{
+	// Sin la traslacion el rayo sale siempre del origen del cubemap
+	glm::mat4 rotation = glm::mat4(glm::mat3(view));
+
+	shader->use();
+	shader->setMat4("inverseViewProjection", glm::inverse(projection * rotation));
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+
+	// El plano lejano pasa con GL_LEQUAL contra el buffer limpio a 1.0 y
+	// falla donde ya se dibujo algo; no hace falta escribir profundidad
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
@@ -0,0 +1,32 @@
+#ifndef SKYBOX_H
+#define SKYBOX_H
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include "Shader.h"
+
+using namespace std;
+
+// Cielo dibujado con un solo triangulo que cubre la pantalla, despues de lo
+// opaco. Queda a profundidad 1.0 y con GL_LEQUAL solo sombrea los pixeles
+// que nada tapo. No usa vertex buffer: el VAO vacio solo lo exige el perfil
+// core para dibujar.
+class Skybox
+{
+public:
+
+	// 'cubemap' es la textura del cielo; queda a cargo de quien la creo
+	Skybox(unsigned int cubemap);
+	~Skybox();
+
+	void Draw(const glm::mat4& view, const glm::mat4& projection);
+
+private:
+
+	Shader* shader;
+	unsigned int vao;
+	unsigned int cubemap;
+};
+
+#endif
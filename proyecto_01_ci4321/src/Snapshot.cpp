@@ -0,0 +1,59 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+
+void captureSnapshot(const vector<Geometry*>& objects, FrameSnapshot& snapshot)
+{
+	snapshot.objects.resize(objects.size());
+
+	for (unsigned int i = 0; i < objects.size(); i++) {
+		const Geometry* object = objects[i];
+		ObjectState& state = snapshot.objects[i];
+
+		state.prevPosition = object->prevPosition;
+		state.position = object->position;
+		state.prevRotation = object->prevRotation;
+		state.rotation = object->rotation;
+		state.layer = object->layer;
+		state.visible = object->visible;
+	}
+}
+
+void buildDrawList(const vector<Geometry*>& objects, const FrameSnapshot& snapshot, float alpha,
+	const Frustum& frustum, JobSystem& jobs, DrawListScratch& scratch, vector<DrawItem>& drawList)
+{
+	// La foto puede estar vacia si la simulacion aun no publico nada
+	int count = (int)min(objects.size(), snapshot.objects.size());
+
+	scratch.models.resize(count);
+	scratch.bounds.resize(count);
+	scratch.inside.resize(count);
+
+	jobs.ParallelFor(count, 256, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			const ObjectState& state = snapshot.objects[i];
+			if (!state.visible) {
+				scratch.inside[i] = false;
+				continue;
+			}
+
+			glm::vec3 renderPosition = glm::mix(state.prevPosition, state.position, alpha);
+			glm::vec3 renderRotation = glm::mix(state.prevRotation, state.rotation, alpha);
+
+			// El pivote, el tamanno y la malla son fijos desde la creacion del
+			// objeto, no hace falta copiarlos en la foto
+			scratch.models[i] = objects[i]->ModelMatrix(renderPosition, renderRotation);
+			scratch.bounds[i] = transformBounds(scratch.models[i], objects[i]->size);
+			scratch.inside[i] = intersects(frustum, scratch.bounds[i]);
+		}
+	});
+
+	// Compactacion secuencial para conservar el orden de la foto
+	drawList.clear();
+	for (int i = 0; i < count; i++) {
+		if (scratch.inside[i]) {
+			DrawItem item = { objects[i], scratch.models[i], snapshot.objects[i].layer };
+			drawList.push_back(item);
+		}
+	}
+}
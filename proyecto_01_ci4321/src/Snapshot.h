@@ -0,0 +1,77 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Geometry.h"
+#include "Bounds.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+using namespace std;
+
+// Estado de dibujo de un objeto en un paso de simulacion. Guarda el paso
+// anterior y el actual para que el render interpole sin tocar el objeto
+struct ObjectState
+{
+	glm::vec3 prevPosition;
+	glm::vec3 position;
+	glm::vec3 prevRotation;
+	glm::vec3 rotation;
+	int layer;
+	bool visible;
+};
+
+// Efectos visuales que levanta la simulacion (disparos, impactos). Cada uno
+// lleva un numero de secuencia creciente para que el render los emita una
+// sola vez aunque se salte o repita fotos
+enum EffectKind
+{
+	EFFECT_MUZZLE_FLASH,
+	EFFECT_EXPLOSION
+};
+
+struct EffectEvent
+{
+	EffectKind kind;
+	glm::vec3 position;
+	glm::vec3 direction;
+	unsigned long long sequence;
+};
+
+// Foto inmutable de la escena que publica el hilo de simulacion. objects[i]
+// corresponde al i-esimo objeto de la lista registrada en la simulacion
+struct FrameSnapshot
+{
+	vector<ObjectState> objects;
+	vector<EffectEvent> effects; // ultimos efectos, del mas viejo al mas nuevo
+	double time; // instante (glfwGetTime) que representa el paso actual
+	unsigned long long step;
+};
+
+// Copia el estado de los objetos en la foto, reutilizando su memoria
+void captureSnapshot(const vector<Geometry*>& objects, FrameSnapshot& snapshot);
+
+// Un objeto que sobrevivio al culling, listo para emitir
+struct DrawItem
+{
+	Geometry* object;
+	glm::mat4 model;
+	int layer;
+};
+
+// Memoria de trabajo de buildDrawList, se reutiliza entre frames
+struct DrawListScratch
+{
+	vector<glm::mat4> models;
+	vector<AABB> bounds;
+	vector<unsigned char> inside;
+};
+
+// Etapas del frame que no tocan GL, repartidas en el JobSystem: interpola
+// las transformaciones, calcula la matriz de modelo y la caja en mundo de
+// cada objeto, descarta los que quedan fuera del frustum y arma la lista
+// de dibujo en el orden de la foto. RenderQueue la ordena y la emite
+void buildDrawList(const vector<Geometry*>& objects, const FrameSnapshot& snapshot, float alpha,
+	const Frustum& frustum, JobSystem& jobs, DrawListScratch& scratch, vector<DrawItem>& drawList);
+
+#endif
@@ -0,0 +1,181 @@
+#include "Sweep.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Metodo de las placas: se recorta el intervalo [0, 1] del segmento con el
+// par de planos de cada eje
+static bool sweepSegmentBox(glm::vec3 start, glm::vec3 delta, glm::vec3 boxMin, glm::vec3 boxMax, float& toi)
+{
+	float tMin = 0.0f;
+	float tMax = 1.0f;
+
+	for (int i = 0; i < 3; i++) {
+		if (fabsf(delta[i]) < 1e-8f) {
+			// Paralelo a las placas: o esta entre ellas o no hay choque
+			if (start[i] < boxMin[i] || start[i] > boxMax[i]) {
+				return false;
+			}
+			continue;
+		}
+
+		float inverse = 1.0f / delta[i];
+		float t1 = (boxMin[i] - start[i]) * inverse;
+		float t2 = (boxMax[i] - start[i]) * inverse;
+		if (t1 > t2) {
+			std::swap(t1, t2);
+		}
+
+		tMin = std::max(tMin, t1);
+		tMax = std::min(tMax, t2);
+		if (tMin > tMax) {
+			return false;
+		}
+	}
+
+	toi = tMin;
+	return true;
+}
+
+bool sweepSegmentAABB(glm::vec3 start, glm::vec3 end, const AABB& box, float& toi)
+{
+	return sweepSegmentBox(start, end - start, box.min, box.max, toi);
+}
+
+// Primer t en [0, 1] en que start + delta * t entra a la esfera
+static bool sweepSegmentSphere(glm::vec3 start, glm::vec3 delta, glm::vec3 center, float radius, float& toi)
+{
+	glm::vec3 offset = start - center;
+	float c = glm::dot(offset, offset) - radius * radius;
+	if (c <= 0.0f) {
+		toi = 0.0f;
+		return true;
+	}
+
+	float a = glm::dot(delta, delta);
+	float b = glm::dot(offset, delta);
+	float discriminant = b * b - a * c;
+	if (a < 1e-12f || b >= 0.0f || discriminant < 0.0f) {
+		return false;
+	}
+
+	float t = (-b - sqrtf(discriminant)) / a;
+	if (t > 1.0f) {
+		return false;
+	}
+	toi = t;
+	return true;
+}
+
+// Primer t en [0, 1] en que start + delta * t entra a la capsula de eje
+// [capA, capB] y radio 'radius' (cilindro mas dos esferas)
+static bool sweepSegmentCapsule(glm::vec3 start, glm::vec3 delta, glm::vec3 capA, glm::vec3 capB, float radius, float& toi)
+{
+	glm::vec3 axis = capB - capA;
+	glm::vec3 offset = start - capA;
+	float axisLength2 = glm::dot(axis, axis);
+
+	float best = 2.0f;
+	float t;
+
+	// Parte cilindrica: se proyecta todo sobre el plano perpendicular al eje
+	float m = glm::dot(offset, axis) / axisLength2;
+	float n = glm::dot(delta, axis) / axisLength2;
+	glm::vec3 q = delta - axis * n;
+	glm::vec3 r = offset - axis * m;
+
+	float a = glm::dot(q, q);
+	float b = glm::dot(q, r);
+	float c = glm::dot(r, r) - radius * radius;
+
+	if (c <= 0.0f && m >= 0.0f && m <= 1.0f) {
+		toi = 0.0f;
+		return true;
+	}
+	if (a > 1e-12f) {
+		float discriminant = b * b - a * c;
+		if (discriminant >= 0.0f) {
+			t = (-b - sqrtf(discriminant)) / a;
+			float along = m + n * t;
+			if (t >= 0.0f && t <= 1.0f && along >= 0.0f && along <= 1.0f) {
+				best = t;
+			}
+		}
+	}
+
+	// Tapas esfericas
+	if (sweepSegmentSphere(start, delta, capA, radius, t)) {
+		best = std::min(best, t);
+	}
+	if (sweepSegmentSphere(start, delta, capB, radius, t)) {
+		best = std::min(best, t);
+	}
+
+	if (best > 1.0f) {
+		return false;
+	}
+	toi = best;
+	return true;
+}
+
+bool sweepSphereOBB(glm::vec3 start, glm::vec3 end, float radius, const OBB& box, float& toi)
+{
+	// Se trabaja en el espacio de la caja, donde es un AABB centrado
+	glm::vec3 localStart, localEnd;
+	for (int i = 0; i < 3; i++) {
+		localStart[i] = glm::dot(start - box.center, box.axes[i]);
+		localEnd[i] = glm::dot(end - box.center, box.axes[i]);
+	}
+	glm::vec3 delta = localEnd - localStart;
+	glm::vec3 half = box.halfSize;
+
+	// La suma de Minkowski de la caja y la esfera es una caja redondeada;
+	// primero se prueba contra la caja agrandada en 'radius', que la contiene
+	float t;
+	if (!sweepSegmentBox(localStart, delta, -half - radius, half + radius, t)) {
+		return false;
+	}
+
+	// Si el punto de entrada queda fuera de la caja original en a lo sumo un
+	// eje, entro por una cara y el resultado es exacto
+	glm::vec3 point = localStart + delta * t;
+	int outsideMask = 0;
+	int outsideCount = 0;
+	for (int i = 0; i < 3; i++) {
+		if (point[i] < -half[i] || point[i] > half[i]) {
+			outsideMask |= 1 << i;
+			outsideCount++;
+		}
+	}
+	if (outsideCount <= 1) {
+		toi = t;
+		return true;
+	}
+
+	// Entro por la zona de una arista o de un vertice: ahi la caja
+	// redondeada son capsulas a lo largo de las aristas de la caja. Se
+	// prueban las aristas que salen del vertice mas cercano al punto
+	glm::vec3 corner;
+	for (int i = 0; i < 3; i++) {
+		corner[i] = point[i] < 0.0f ? -half[i] : half[i];
+	}
+
+	float best = 2.0f;
+	for (int i = 0; i < 3; i++) {
+		// En la zona de una arista solo cuenta la arista de ese eje
+		if (outsideCount == 2 && (outsideMask & (1 << i))) {
+			continue;
+		}
+		glm::vec3 other = corner;
+		other[i] = -corner[i];
+		if (sweepSegmentCapsule(localStart, delta, corner, other, radius, t)) {
+			best = std::min(best, t);
+		}
+	}
+
+	if (best > 1.0f) {
+		return false;
+	}
+	toi = best;
+	return true;
+}
@@ -0,0 +1,17 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "Bounds.h"
+
+// Pruebas continuas para objetos rapidos. Todas reciben el movimiento como
+// un segmento de 'start' a 'end' (posicion del paso anterior y del actual) y
+// devuelven en 'toi' el instante de impacto en [0, 1] a lo largo de el, de
+// modo que el punto de contacto es mix(start, end, toi). Si el segmento ya
+// empieza dentro, toi es 0.
+
+bool sweepSegmentAABB(glm::vec3 start, glm::vec3 end, const AABB& box, float& toi);
+
+// Esfera de radio 'radius' cuyo centro recorre el segmento
+bool sweepSphereOBB(glm::vec3 start, glm::vec3 end, float radius, const OBB& box, float& toi);
+
+#endif
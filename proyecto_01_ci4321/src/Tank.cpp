@@ -1,20 +1,28 @@
 #include "Tank.h"
-#include "stb_image/stb_image.h"
+#include "Ballistics.h"
+#include "Log.h"
+
+#include <cmath>
 
 Tank::Tank()
 {
+	textureArray = 0;
+	hasProjectile = false;
+	hasBeenShot = false;
+
 	body = new Cube(4.0, 1.0, 4.25);
-	body->SetupGL();
-	
+	body->SetLayer(LAYER_METAL_GREEN);
+
 	glm::vec3 topPos = body->position + glm::vec3(0.0f, 0.5f, -0.25f);
 	top = new Sphere(1.25f, 36, 18, false);
 	top->SetPosition(topPos);
-	top->SetupGL();
+	top->SetLayer(LAYER_METAL_GREEN);
 
 	glm::vec3 canonPos = top->position + glm::vec3(0.0f, 0.5f, 1.0f);
 	canon = new Cylinder(0.25f, 2.0f, 64);
 	canon->SetPosition(canonPos);
-	canon->SetupGL();
+	canon->setPivot(glm::vec3(0.0f, 0.0f, -1.0f));
+	canon->SetLayer(LAYER_METAL);
 
 	for (int i = 0; i < wheelsCount; i++) {
 
@@ -42,14 +50,13 @@ Tank::Tank()
 		wheels[i] = new Cylinder(0.52, 4, 18);
 		wheels[i]->SetPosition(wheelPos);
 		wheels[i]->SetRotation(glm::vec3(0.0, glm::radians(90.0), 0.0));
-
-		wheels[i]->SetupGL();
+		wheels[i]->SetLayer(LAYER_BLOCKS);
 
 		float centerHeight = wheels[i]->height/2;
 		float faceRadius = wheels[i]->radius/2;
 
 		for (int j = boltsCount*i; j < boltsCount*(i + 1); j++) {
-			cout << j << endl;
+			LOG_TRACE("Tank: bolt {} on wheel {}", j, i);
 			glm::vec3 boltPos = wheels[i]->position;
 
 			switch (j % boltsCount)
@@ -64,59 +71,222 @@ Tank::Tank()
 
 			bolts[j] = new Cube(0.1, 0.4, 0.4);
 			bolts[j]->SetPosition(boltPos);
-
-			bolts[j]->SetupGL();
+			bolts[j]->SetLayer(LAYER_METAL);
 		}
 	}
+
+	// El proyectil se crea una sola vez y se oculta mientras no se dispara,
+	// asi la simulacion no necesita crear recursos de GL
+	projectile = new Cylinder(0.1f, 1.0f, 64);
+	projectile->SetLayer(LAYER_METAL);
+	projectile->visible = false;
 }
 
-void Tank::Draw(const Shader& shader)
+Tank::~Tank()
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture3);
-
-	canon->DrawCanon(shader);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture1);
+	vector<Geometry*> parts;
+	GetParts(parts);
+	for (Geometry* part : parts) {
+		delete part;
+	}
+}
 
-	body->Draw(shader);
-	top->Draw(shader);
+Tank::Tank(Tank&& other) noexcept
+{
+	textureArray = other.textureArray;
+	hasProjectile = other.hasProjectile;
+	hasBeenShot = other.hasBeenShot;
+
+	// El tanque movido queda sin partes; su destructor no libera nada
+	body = other.body;
+	top = other.top;
+	canon = other.canon;
+	projectile = other.projectile;
+	other.body = NULL;
+	other.top = NULL;
+	other.canon = NULL;
+	other.projectile = NULL;
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture2);
 	for (int i = 0; i < wheelsCount; i++) {
-		wheels[i]->Draw(shader);
+		wheels[i] = other.wheels[i];
+		other.wheels[i] = NULL;
 	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture3);
 	for (int j = 0; j < boltsCount*wheelsCount; j++) {
-		bolts[j]->Draw(shader);
+		bolts[j] = other.bolts[j];
+		other.bolts[j] = NULL;
+	}
+}
+
+void Tank::SetupGL()
+{
+	vector<Geometry*> parts;
+	GetParts(parts);
+	for (Geometry* part : parts) {
+		part->SetupGL();
+	}
+}
+
+void Tank::Translate(glm::vec3 offset)
+{
+	vector<Geometry*> parts;
+	GetParts(parts);
+	for (Geometry* part : parts) {
+		part->SetPosition(part->position + offset);
+	}
+}
+
+void Tank::Move(glm::vec3 offset)
+{
+	vector<Geometry*> parts;
+	GetParts(parts);
+	parts.pop_back(); // el proyectil va aparte
+	for (Geometry* part : parts) {
+		part->position += offset;
+	}
+}
+
+TankState Tank::GetState()
+{
+	TankState state = {};
+	state.position = body->position;
+	state.bodyYaw = body->rotation.y;
+	state.canonPitch = canon->rotation.x;
+	state.canonYaw = canon->rotation.y;
+	state.projectileFlying = hasBeenShotF();
+	state.projectilePosition = projectile->position;
+	state.projectileRotation = projectile->rotation;
+	return state;
+}
+
+void Tank::SetState(const TankState& state)
+{
+	glm::vec3 offset = state.position - body->position;
+	if (offset != glm::vec3(0.0f)) {
+		Move(offset);
+		body->position = state.position;
+	}
+
+	// Mismo efecto que girar el cuerpo o el canon esa cantidad. Por red el
+	// angulo llega envuelto a [-pi, pi]: se gira por el camino corto
+	float turn = state.bodyYaw - body->rotation.y;
+	float yaw = remainderf(turn, 2.0f * numbers::pi_v<float>);
+	if (yaw != 0.0f) {
+		rotateBodyLeft(yaw);
+	}
+	if (yaw == turn) {
+		body->rotation.y = state.bodyYaw;
+	}
+	top->rotation.y += state.canonYaw - canon->rotation.y;
+	canon->rotation.x = state.canonPitch;
+	canon->rotation.y = state.canonYaw;
+
+	if (state.projectileFlying) {
+		if (!hasBeenShotF()) {
+			projectile->SetPosition(state.projectilePosition);
+			projectile->SetRotation(state.projectileRotation);
+		}
+		else {
+			projectile->position = state.projectilePosition;
+			projectile->rotation = state.projectileRotation;
+		}
+		projectile->visible = body->visible;
+		hasProjectile = true;
+		hasBeenShot = true;
+	}
+	else if (hasBeenShotF()) {
+		setHasBeenShot();
+	}
+}
+
+void Tank::SetVisible(bool visible)
+{
+	vector<Geometry*> parts;
+	GetParts(parts);
+	parts.pop_back();
+	for (Geometry* part : parts) {
+		part->visible = visible;
+	}
+	if (!visible) {
+		projectile->visible = false;
+	}
+}
+
+void Tank::Update(const TankInput& input, float deltaTime)
+{
+	if (input.canonUp) {
+		moveCanonUp(deltaTime);
+	}
+	if (input.canonDown) {
+		moveCanonDown(deltaTime);
+	}
+	if (input.canonRight) {
+		moveCanonRight(deltaTime);
+	}
+	if (input.canonLeft) {
+		moveCanonLeft(deltaTime);
+	}
+	if (input.forward) {
+		moveForward(deltaTime);
+	}
+	if (input.backwards) {
+		moveBackwards(deltaTime);
+	}
+	if (input.bodyLeft) {
+		rotateBodyLeft(deltaTime);
+	}
+	if (input.bodyRight) {
+		rotateBodyRight(deltaTime);
+	}
+	if (input.fire) {
+		fire();
 	}
 
+	// Al disparar el proyectil aparece con la cola en la punta del canon,
+	// alineado con el; a partir de ahi lo mueve la simulacion
 	if (hasProjectile && !hasBeenShot) {
-		projectile = new Cylinder(0.1f, 1.0f, 64);
-		glm::vec3 projectilePos;
-		projectilePos = canon->position;
-		projectilePos.z = 0.1f;
-		glm::vec3 projectileRot = canon->rotation;
-		projectile->SetRotation(projectileRot);
-
-		projectile->SetPosition(projectilePos);
-		projectile->SetupGL();
+		glm::vec3 direction = getMuzzleDirection();
+		projectile->SetRotation(orientationAlong(direction));
+		projectile->SetPosition(getMuzzlePosition() + direction * (projectile->height * 0.5f));
+		projectile->visible = true;
 		hasBeenShot = true;
 	}
+}
+
+void Tank::SaveState()
+{
+	canon->SaveState();
+	body->SaveState();
+	top->SaveState();
+
+	for (int i = 0; i < wheelsCount; i++) {
+		wheels[i]->SaveState();
+	}
+
+	for (int j = 0; j < boltsCount*wheelsCount; j++) {
+		bolts[j]->SaveState();
+	}
+
 	if (hasProjectile && hasBeenShot) {
-		if (projectile->rotation != glm::vec3(0.0f)) {
-			projectile->position += glm::vec3(0.0f, projectile->rotation.y, projectile->rotation.y) * 0.05f * 0.25f;
-			projectile->Draw(shader);
-		}
-		else {
-			projectile->position += glm::normalize(glm::vec3(0.0f, 0.0f, 0.50f)) * 0.05f * 0.25f;
-			projectile->Draw(shader);
-		}		
+		projectile->SaveState();
+	}
+}
+
+void Tank::GetParts(vector<Geometry*>& parts)
+{
+	parts.push_back(canon);
+	parts.push_back(body);
+	parts.push_back(top);
+
+	for (int i = 0; i < wheelsCount; i++) {
+		parts.push_back(wheels[i]);
+	}
+
+	for (int j = 0; j < boltsCount*wheelsCount; j++) {
+		parts.push_back(bolts[j]);
 	}
+
+	parts.push_back(projectile);
 }
 
 void Tank::Clear()
@@ -135,132 +305,62 @@ void Tank::Clear()
 		bolts[j]->CleanGL();
 	}
 
+	projectile->CleanGL();
 }
 
-void Tank::moveForward(const Shader& ourShader) {
+void Tank::moveForward(float deltaTime) {
 	
-	body->moveForward();
-	canon->moveForward();
-	top->moveForward();
+	float distance = tankSpeed * deltaTime;
+	float spin = wheelSpinSpeed * deltaTime;
+
+	body->moveForward(distance);
+	canon->moveForward(distance);
+	top->moveForward(distance);
 	for (int i = 0; i < wheelsCount; ++i) {
-		wheels[i]->moveForward();
-		wheels[i]->rotation -= glm::normalize(glm::vec3(0.0f, 0.0f, 1.0f)) * 0.05f;
+		wheels[i]->moveForward(distance);
+		wheels[i]->rotation -= glm::normalize(glm::vec3(0.0f, 0.0f, 1.0f)) * spin;
 
 	}
 	for (int i = 0; i < boltsCount*wheelsCount; i++) {
-		bolts[i]->moveForward();
-		bolts[i]->rotation += glm::normalize(glm::vec3(1.0f, 0.0f, 0.0f)) * 0.05f;
+		bolts[i]->moveForward(distance);
+		bolts[i]->rotation += glm::normalize(glm::vec3(1.0f, 0.0f, 0.0f)) * spin;
 	}
 	
 }
 
-void Tank::moveBackwards(const Shader& ourShader) {
+void Tank::moveBackwards(float deltaTime) {
 
-	body->moveBackwards();
-	canon->moveBackwards();
-	top->moveBackwards();
+	float distance = tankSpeed * deltaTime;
+	float spin = wheelSpinSpeed * deltaTime;
+
+	body->moveBackwards(distance);
+	canon->moveBackwards(distance);
+	top->moveBackwards(distance);
 	for (int i = 0; i < wheelsCount; ++i) {
-		wheels[i]->moveBackwards();
-		wheels[i]->rotation += glm::normalize(glm::vec3(0.0f, 0.0f, 1.0f)) * 0.05f;
+		wheels[i]->moveBackwards(distance);
+		wheels[i]->rotation += glm::normalize(glm::vec3(0.0f, 0.0f, 1.0f)) * spin;
 	}
 	for (int i = 0; i < boltsCount * wheelsCount; i++) {
-		bolts[i]->moveBackwards();
-		bolts[i]->rotation -= glm::normalize(glm::vec3(1.0f, 0.0f, 0.0f)) * 0.05f;
+		bolts[i]->moveBackwards(distance);
+		bolts[i]->rotation -= glm::normalize(glm::vec3(1.0f, 0.0f, 0.0f)) * spin;
 	}
 
 }
 
-void Tank::LoadTextures(Shader& shader)
+void Tank::LoadTextures(Shader& shader, TextureStreamer& streamer)
 {
-	// Texturas
-	glGenTextures(1, &texture1);
-	glGenTextures(1, &texture2);
-	glGenTextures(1, &texture3);
-
-	// Textura 1
-	// Seteamos a la textura 1 como textura actual
-	glBindTexture(GL_TEXTURE_2D, texture1);
-
-	// Seteamos los parametros de wrapping de la textura
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Steamos parametros de filtro en la textura
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Cargamos la imagen, creamos la textura y generamos los mipmaps
-	int width, height, nrChannels;
-	stbi_set_flip_vertically_on_load(true); // Es necesario girar la textura en el eje Y, por como funciona OpenGL
-	unsigned char* data = stbi_load("resources/textures/metal_green.png", &width, &height, &nrChannels, 0);
-
-	if (data)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
-	stbi_image_free(data);
-
-	// Textura 2
-	// Seteamos a la textura 2 como textura actual
-	glBindTexture(GL_TEXTURE_2D, texture2);
-
-	// Seteamos los parametros de wrapping de la textura
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Steamos parametros de filtro en la textura
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Cargamos la imagen, creamos la textura y generamos los mipmaps
-	stbi_set_flip_vertically_on_load(true); // Es necesario girar la textura en el eje Y, por como funciona OpenGL
-	data = stbi_load("resources/textures/blocks.png", &width, &height, &nrChannels, 0);
-
-	if (data)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
-	stbi_image_free(data);
-
-	// Textura 3
-	// Seteamos a la textura 3 como textura actual
-	glBindTexture(GL_TEXTURE_2D, texture3);
-
-	// Seteamos los parametros de wrapping de la textura
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Steamos parametros de filtro en la textura
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Cargamos la imagen, creamos la textura y generamos los mipmaps
-	stbi_set_flip_vertically_on_load(true); // Es necesario girar la textura en el eje Y, por como funciona OpenGL
-	data = stbi_load("resources/textures/metal.png", &width, &height, &nrChannels, 0);
-
-	if (data)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
+	// Texturas de materiales, una capa por textura (ver MaterialLayer).
+	// Las capas se decodifican en segundo plano y se suben por el streamer
+	vector<string> paths
 	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
-	stbi_image_free(data);
+		"resources/textures/metal_green.png",
+		"resources/textures/blocks.png",
+		"resources/textures/metal.png"
+	};
+	textureArray = streamTextureArray(paths, streamer);
 
 	shader.use();
-	shader.setInt("texture1", 0);
+	shader.setInt("materials", 0);
 }
 
 
@@ -272,7 +372,7 @@ void Tank::moveCanonUp(float deltaTime) {
 	else {
 		canon->rotation -= glm::normalize(glm::vec3(1.0f, 0.0f, 0.0f)) * deltaTime;
 	}
-	cout << canon->rotation.x << " " << canon->rotation.y << " " << canon->rotation.z << " " << endl;
+	LOG_TRACE("Tank: canon rotation {} {} {}", canon->rotation.x, canon->rotation.y, canon->rotation.z);
 }
 
 void Tank::moveCanonDown(float deltaTime) {
@@ -330,6 +430,20 @@ void Tank::rotateBodyLeft(float deltaTime) {
 	
 }
 
+glm::vec3 Tank::getMuzzlePosition()
+{
+	// El canon es un cilindro a lo largo de z, de altura 2, con el pivote en
+	// su base
+	glm::mat4 model = canon->ModelMatrix(canon->position, canon->rotation);
+	return glm::vec3(model * glm::vec4(0.0f, 0.0f, canon->height * 0.5f, 1.0f));
+}
+
+glm::vec3 Tank::getMuzzleDirection()
+{
+	glm::mat4 model = canon->ModelMatrix(canon->position, canon->rotation);
+	return glm::normalize(glm::vec3(model * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f)));
+}
+
 void Tank::fire() {
 	hasProjectile = true;
 }
\ No newline at end of file
@@ -2,24 +2,94 @@
 #define TANK_H
 
 #include "Geometry.h"
+#include "Texture.h"
+#include "TextureStreamer.h"
 
 using namespace std;
 const int wheelsCount = 5;
 const int boltsCount = 2;
 
+// Velocidades de la simulacion, por segundo. Equivalen a los pasos fijos que
+// antes se aplicaban en cada frame a 60 fps
+const float tankSpeed = 0.6f;
+const float wheelSpinSpeed = 3.0f;
+
+// Los proyectiles salen por la punta del canon y desde ahi los mueve un
+// ProjectileSystem, con gravedad y arrastre
+const float muzzleSpeed = 30.0f;
+const float projectileLifetime = 10.0f;
+
+// Altura del centro del cuerpo sobre el suelo cuando hay terreno: las
+// ruedas estan 1 mas abajo y tienen radio 0.52
+const float tankRideHeight = 1.52f;
+
+// Teclas de control del tanque, leidas una vez por frame y aplicadas en
+// cada paso de simulacion
+struct TankInput
+{
+	bool canonUp;
+	bool canonDown;
+	bool canonRight;
+	bool canonLeft;
+	bool forward;
+	bool backwards;
+	bool bodyLeft;
+	bool bodyRight;
+	bool fire;
+};
+
+// Estado que define al tanque; lo demas (giro de ruedas y pernos) es
+// cosmetico. Es lo que se replica por red
+struct TankState
+{
+	glm::vec3 position; // del cuerpo
+	float bodyYaw;
+	float canonPitch;
+	float canonYaw;
+	bool projectileFlying;
+	glm::vec3 projectilePosition;
+	glm::vec3 projectileRotation;
+	// Los llena quien integra el proyectil; el tanque no los conoce
+	glm::vec3 projectileVelocity;
+	float projectileLife;
+};
+
 class Tank
 {
 public:
 
+	// Solo arma la geometria; SetupGL crea los recursos de GL, asi los
+	// escenarios sin ventana pueden crear tanques
 	Tank();
-	void Draw(const Shader& shader);
+	// Libera las partes; los recursos de GL se liberan antes con Clear
+	~Tank();
+	// Las partes son del tanque: se puede mover, no copiar
+	Tank(Tank&& other) noexcept;
+	Tank(const Tank&) = delete;
+	Tank& operator=(const Tank&) = delete;
+	void SetupGL();
+	// Desplaza todas las partes del tanque
+	void Translate(glm::vec3 offset);
+	// Desplaza las partes menos el proyectil, sin tocar la posicion
+	// anterior: el movimiento se interpola como cualquier otro
+	void Move(glm::vec3 offset);
+	TankState GetState();
+	// Lleva el tanque a 'state' moviendo las partes desde donde estan, asi
+	// el cambio se interpola entre pasos como cualquier movimiento
+	void SetState(const TankState& state);
+	// Muestra u oculta el tanque (el proyectil sigue su propio estado)
+	void SetVisible(bool visible);
+	// Avanza la simulacion un paso de 'deltaTime' segundos
+	void Update(const TankInput& input, float deltaTime);
+	// Guarda el estado actual como anterior, antes de cada paso
+	void SaveState();
+	// Agrega todas las partes dibujables, proyectil incluido, en orden fijo
+	void GetParts(vector<Geometry*>& parts);
 	void Clear();
-	void LoadTextures(Shader& shader);
-	void moveForward(const Shader& ourShader);
-	void moveBackwards(const Shader& ourShader);
-	unsigned int texture1;
-	unsigned int texture2;
-	unsigned int texture3;
+	void LoadTextures(Shader& shader, TextureStreamer& streamer);
+	void moveForward(float deltaTime);
+	void moveBackwards(float deltaTime);
+	unsigned int textureArray;
 	void moveCanonUp(float deltaTime);
 	void moveCanonDown(float deltaTime);
 	void moveCanonRight(float deltaTime);
@@ -37,17 +107,25 @@ public:
 	{
 		return body->position;
 	};
+	inline Cube *getBody() {
+		return body;
+	}
 
 	inline bool hasBeenShotF() {
 		return hasProjectile && hasBeenShot;
 	};
 
+	// Punta del canon y direccion en la que apunta, en mundo
+	glm::vec3 getMuzzlePosition();
+	glm::vec3 getMuzzleDirection();
+
 	inline Cylinder *getProjectile() {
 		return projectile;
 	}
 	inline void setHasBeenShot() {
 		hasProjectile = false;
 		hasBeenShot = false;
+		projectile->visible = false;
 	}
 
 private:
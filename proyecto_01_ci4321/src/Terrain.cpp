@@ -0,0 +1,262 @@
+#include "Terrain.h"
+#include "Texture.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Quads por lado de cada trozo; debe coincidir con 'quads' del vertex shader
+const int chunkQuads = 32;
+// Un nodo se divide mientras la camara este a menos de lodRange lados
+const float chunkLodRange = 2.0f;
+
+TerrainQuadtree::TerrainQuadtree(const Heightmap& map, int quads, float lodRange)
+	: map(map), quads(quads), lodRange(lodRange)
+{
+	origin = map.Origin();
+	extent = map.Extent();
+
+	// El mapa debe medir 2^depth trozos por lado
+	int chunks = max(1, (map.Size() - 1) / quads);
+	depth = 0;
+	while ((2 << depth) <= chunks) {
+		depth++;
+	}
+	if ((1 << depth) * quads + 1 != map.Size()) {
+		LOG_WARNING("Terrain: heightmap of {} samples is not 2^k * {} + 1, the border is not drawn", map.Size(), quads);
+		extent = (float)((1 << depth) * quads) * map.CellSize();
+	}
+
+	// Rangos de altura de las hojas y luego de cada nivel hacia arriba
+	ranges.resize(depth + 1);
+	int leaves = 1 << depth;
+	ranges[depth].resize((size_t)leaves * leaves);
+	for (int z = 0; z < leaves; z++) {
+		for (int x = 0; x < leaves; x++) {
+			ranges[depth][(size_t)z * leaves + x] = map.Range(x * quads, z * quads, (x + 1) * quads, (z + 1) * quads);
+		}
+	}
+	for (int level = depth - 1; level >= 0; level--) {
+		int nodes = 1 << level;
+		const vector<glm::vec2>& children = ranges[level + 1];
+		ranges[level].resize((size_t)nodes * nodes);
+		for (int z = 0; z < nodes; z++) {
+			for (int x = 0; x < nodes; x++) {
+				glm::vec2 range = children[(size_t)(2 * z) * (2 * nodes) + 2 * x];
+				for (int child = 1; child < 4; child++) {
+					glm::vec2 other = children[(size_t)(2 * z + child / 2) * (2 * nodes) + 2 * x + child % 2];
+					range = glm::vec2(min(range.x, other.x), max(range.y, other.y));
+				}
+				ranges[level][(size_t)z * nodes + x] = range;
+			}
+		}
+	}
+}
+
+AABB TerrainQuadtree::NodeBounds(int level, int x, int z) const
+{
+	float size = extent / (1 << level);
+	glm::vec2 corner = origin + glm::vec2(x, z) * size;
+	glm::vec2 range = ranges[level][(size_t)z * (1 << level) + x];
+	return AABB{ glm::vec3(corner.x, range.x, corner.y), glm::vec3(corner.x + size, range.y, corner.y + size) };
+}
+
+bool TerrainQuadtree::Split(int level, int x, int z, glm::vec3 camera) const
+{
+	if (level >= depth) {
+		return false;
+	}
+	AABB bounds = NodeBounds(level, x, z);
+	glm::vec3 closest = glm::clamp(camera, bounds.min, bounds.max);
+	float size = extent / (1 << level);
+	return glm::length(camera - closest) < size * lodRange;
+}
+
+int TerrainQuadtree::LeafLevel(glm::vec2 point, glm::vec3 camera) const
+{
+	glm::vec2 local = (point - origin) / extent;
+	if (local.x < 0.0f || local.y < 0.0f || local.x >= 1.0f || local.y >= 1.0f) {
+		return -1;
+	}
+
+	// Mismas decisiones que Visit, bajando solo por el nodo que contiene
+	// el punto
+	int level = 0;
+	while (true) {
+		int nodes = 1 << level;
+		int x = min((int)(local.x * nodes), nodes - 1);
+		int z = min((int)(local.y * nodes), nodes - 1);
+		if (!Split(level, x, z, camera)) {
+			return level;
+		}
+		level++;
+	}
+}
+
+void TerrainQuadtree::Visit(int level, int x, int z, glm::vec3 camera, const Frustum* frustum, vector<TerrainChunk>& chunks) const
+{
+	// El frustum solo poda: el nivel de cada hoja depende de la camara y no
+	// de lo que se ve, asi los vecinos de un trozo visible son los mismos
+	// que si se dibujara todo
+	if (frustum && !intersects(*frustum, NodeBounds(level, x, z))) {
+		return;
+	}
+
+	if (Split(level, x, z, camera)) {
+		for (int child = 0; child < 4; child++) {
+			Visit(level + 1, 2 * x + child % 2, 2 * z + child / 2, camera, frustum, chunks);
+		}
+		return;
+	}
+
+	TerrainChunk chunk;
+	chunk.size = extent / (1 << level);
+	chunk.origin = origin + glm::vec2(x, z) * chunk.size;
+	chunk.level = level;
+
+	// Nivel del vecino en el medio de cada borde, medio paso de celda afuera
+	float outside = map.CellSize() * 0.5f;
+	glm::vec2 center = chunk.origin + glm::vec2(chunk.size * 0.5f);
+	glm::vec2 probes[4] = {
+		glm::vec2(chunk.origin.x - outside, center.y),
+		glm::vec2(chunk.origin.x + chunk.size + outside, center.y),
+		glm::vec2(center.x, chunk.origin.y - outside),
+		glm::vec2(center.x, chunk.origin.y + chunk.size + outside)
+	};
+	for (int side = 0; side < 4; side++) {
+		int neighbour = LeafLevel(probes[side], camera);
+		int coarser = neighbour >= 0 ? max(0, level - neighbour) : 0;
+		chunk.stitch[side] = (float)min(1 << coarser, quads);
+	}
+
+	chunks.push_back(chunk);
+}
+
+void TerrainQuadtree::Select(glm::vec3 camera, const Frustum* frustum, vector<TerrainChunk>& chunks) const
+{
+	chunks.clear();
+	Visit(0, 0, 0, camera, frustum, chunks);
+}
+
+Terrain::Terrain(const Heightmap& map, const char* fragmentPath)
+	: map(map), quadtree(map, chunkQuads, chunkLodRange)
+{
+	shader = new Shader("src/Shaders/TerrainVertexShader.vs", fragmentPath);
+	// Para las sombras: mismas posiciones, sin color
+	depthShader = new Shader("src/Shaders/TerrainVertexShader.vs", "src/Shaders/ShadowFragmentShader.fs");
+
+	// Malla de grilla en coordenadas enteras (x, z) de 0 a quads; el vertex
+	// shader la escala y le pone la altura
+	vector<float> vertices;
+	for (int z = 0; z <= chunkQuads; z++) {
+		for (int x = 0; x <= chunkQuads; x++) {
+			vertices.push_back((float)x);
+			vertices.push_back((float)z);
+		}
+	}
+
+	vector<GLushort> indices;
+	int row = chunkQuads + 1;
+	for (int z = 0; z < chunkQuads; z++) {
+		for (int x = 0; x < chunkQuads; x++) {
+			GLushort corner = (GLushort)(z * row + x);
+			indices.push_back(corner);
+			indices.push_back((GLushort)(corner + row));
+			indices.push_back((GLushort)(corner + 1));
+			indices.push_back((GLushort)(corner + 1));
+			indices.push_back((GLushort)(corner + row));
+			indices.push_back((GLushort)(corner + row + 1));
+		}
+	}
+	indexCount = (int)indices.size();
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vbo);
+	glGenBuffers(1, &ebo);
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glBindVertexArray(0);
+
+	// Alturas en una textura de un canal en punto flotante. El shader lee
+	// con texelFetch siempre del nivel 0: los vertices caen justo sobre las
+	// muestras y ambos lados de un borde leen el mismo valor
+	glGenTextures(1, &heightTexture);
+	glBindTexture(GL_TEXTURE_2D, heightTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, map.Size(), map.Size(), 0, GL_RED, GL_FLOAT, map.Data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	shader->use();
+	shader->setInt("materials", 0);
+	shader->setInt("layer", LAYER_BLOCKS);
+	for (Shader* program : { shader, depthShader }) {
+		program->use();
+		program->setInt("heights", 1);
+		program->setFloat("cellSize", map.CellSize());
+		program->setVec3("mapOrigin", glm::vec3(map.Origin().x, 0.0f, map.Origin().y));
+		program->setInt("mapSamples", map.Size());
+	}
+
+	LOG_INFO("Terrain: {} samples, {} m per side, {} LOD levels", map.Size(), map.Extent(), quadtree.Depth() + 1);
+}
+
+Terrain::~Terrain()
+{
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ebo);
+	glDeleteTextures(1, &heightTexture);
+	delete shader;
+	delete depthShader;
+}
+
+void Terrain::Draw(const glm::mat4& view, const glm::mat4& projection, glm::vec3 camera, const Frustum& frustum,
+	unsigned int materials)
+{
+	quadtree.Select(camera, &frustum, chunks);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, materials);
+
+	DrawChunks(*shader, view, projection, chunks);
+}
+
+void Terrain::DrawDepth(const glm::mat4& view, const glm::mat4& projection, glm::vec3 camera, const Frustum& frustum)
+{
+	quadtree.Select(camera, &frustum, depthChunks);
+	DrawChunks(*depthShader, view, projection, depthChunks);
+}
+
+void Terrain::DrawChunks(Shader& program, const glm::mat4& view, const glm::mat4& projection,
+	const vector<TerrainChunk>& selected)
+{
+	program.use();
+	program.setMat4("view", view);
+	program.setMat4("projection", projection);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, heightTexture);
+
+	glBindVertexArray(vao);
+	for (const TerrainChunk& chunk : selected) {
+		program.setVec3("chunkOrigin", glm::vec3(chunk.origin.x, 0.0f, chunk.origin.y));
+		program.setFloat("chunkScale", chunk.size / chunkQuads);
+		program.setVec4("stitch", chunk.stitch);
+		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
+	}
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE0);
+}
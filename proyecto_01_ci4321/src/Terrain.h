@@ -0,0 +1,120 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include "Shader.h"
+#include "Bounds.h"
+#include "Heightmap.h"
+
+#include <vector>
+
+using namespace std;
+
+// Trozo del quadtree elegido para dibujar. Todos tienen la misma malla de
+// quads x quads; solo cambian su esquina y su escala
+struct TerrainChunk
+{
+	glm::vec2 origin;  // esquina xz minima
+	float size;        // lado en unidades del mundo
+	int level;         // 0 es la raiz
+	// Paso de los vertices de cada borde (-x, +x, -z, +z): 2^k si el vecino
+	// de ese lado es k niveles mas grueso. Los vertices del borde se pegan
+	// a los del vecino y no quedan grietas
+	glm::vec4 stitch;
+};
+
+// Quadtree de trozos sobre un Heightmap de 2^depth * quads + 1 muestras.
+// Un nodo se divide si la camara esta a menos de lodRange veces su lado,
+// asi la cantidad de trozos crece con el logaritmo del tamanno del mapa y
+// no con su area. No usa GL.
+class TerrainQuadtree
+{
+public:
+
+	TerrainQuadtree(const Heightmap& map, int quads, float lodRange);
+
+	// Trozos a dibujar desde 'camera'. Con 'frustum' se descartan los que
+	// quedan fuera, sin cambiar el nivel de los demas
+	void Select(glm::vec3 camera, const Frustum* frustum, vector<TerrainChunk>& chunks) const;
+
+	inline int Depth() const
+	{
+		return depth;
+	};
+
+	inline int Quads() const
+	{
+		return quads;
+	};
+
+private:
+
+	bool Split(int level, int x, int z, glm::vec3 camera) const;
+	AABB NodeBounds(int level, int x, int z) const;
+	// Nivel de la hoja que contiene 'point', -1 si cae fuera del mapa
+	int LeafLevel(glm::vec2 point, glm::vec3 camera) const;
+	void Visit(int level, int x, int z, glm::vec3 camera, const Frustum* frustum, vector<TerrainChunk>& chunks) const;
+
+	const Heightmap& map;
+	int quads;
+	int depth;
+	float lodRange;
+	glm::vec2 origin;
+	float extent;
+	// Altura minima y maxima de cada nodo, por nivel, fila a fila
+	vector<vector<glm::vec2>> ranges;
+};
+
+// Terreno por trozos: una sola malla de grilla y un solo index buffer
+// compartidos por todos los trozos. Las alturas se leen de una textura en
+// el vertex shader, asi el costo de dibujo no depende del tamanno del mapa.
+class Terrain
+{
+public:
+
+	// 'fragmentPath' es el fragment shader de los objetos: el forward o el
+	// del G-buffer
+	Terrain(const Heightmap& map, const char* fragmentPath = "src/Shaders/FragmentShader.fs");
+	~Terrain();
+
+	// Dibuja los trozos visibles; 'materials' es el arreglo de texturas de
+	// los objetos, que queda en la unidad 0
+	void Draw(const glm::mat4& view, const glm::mat4& projection, glm::vec3 camera, const Frustum& frustum,
+		unsigned int materials);
+
+	// Solo profundidad, para los mapas de sombra. El nivel de detalle se
+	// elige desde 'camera', que no tiene por que ser la camara del frame
+	void DrawDepth(const glm::mat4& view, const glm::mat4& projection, glm::vec3 camera, const Frustum& frustum);
+
+	// Comparte el fragment shader de los objetos
+	inline const Shader& GetShader() const
+	{
+		return *shader;
+	};
+
+	inline size_t ChunksDrawn() const
+	{
+		return chunks.size();
+	};
+
+private:
+
+	void DrawChunks(Shader& program, const glm::mat4& view, const glm::mat4& projection,
+		const vector<TerrainChunk>& selected);
+
+	const Heightmap& map;
+	TerrainQuadtree quadtree;
+	Shader* shader;
+	Shader* depthShader;
+	unsigned int vao;
+	unsigned int vbo;
+	unsigned int ebo;
+	unsigned int heightTexture;
+	int indexCount;
+	vector<TerrainChunk> chunks;
+	vector<TerrainChunk> depthChunks;
+};
+
+#endif
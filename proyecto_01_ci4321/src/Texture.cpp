@@ -0,0 +1,71 @@
+#include "Texture.h"
+#include "TextureStreamer.h"
+#include "Mipmap.h"
+#include "stb_image/stb_image.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+// Reescalado por vecino mas cercano, solo se usa cuando una imagen no tiene
+// las dimensiones reservadas para ella
+void resizeNearest(const unsigned char* data, int width, int height, unsigned char* resized, int newWidth, int newHeight)
+{
+	for (int y = 0; y < newHeight; y++) {
+		int srcY = y * height / newHeight;
+		for (int x = 0; x < newWidth; x++) {
+			int srcX = x * width / newWidth;
+			const unsigned char* src = data + ((size_t)srcY * width + srcX) * 4;
+			unsigned char* dst = resized + ((size_t)y * newWidth + x) * 4;
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+			dst[3] = src[3];
+		}
+	}
+}
+
+unsigned int createTextureArray(int width, int height, int layers, int levels)
+{
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+	// Seteamos los parametros de wrapping de la textura
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// Steamos parametros de filtro en la textura
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+	// Los niveles se reservan vacios; el contenido (mipmaps incluidos) lo
+	// calcula y sube TextureStreamer
+	for (int level = 0; level < levels; level++) {
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	return textureID;
+}
+
+unsigned int streamTextureArray(const vector<string>& paths, TextureStreamer& streamer)
+{
+	// Solo se lee la cabecera de la primera imagen para reservar el arreglo
+	int width, height, nrChannels;
+	if (paths.empty() || !stbi_info(paths[0].c_str(), &width, &height, &nrChannels))
+	{
+		LOG_ERROR("Failed to load texture: {}", paths.empty() ? "" : paths[0].c_str());
+		width = height = 1;
+	}
+
+	unsigned int textureID = createTextureArray(width, height, (int)paths.size(), mipLevelCount(width, height));
+
+	for (unsigned int i = 0; i < paths.size(); i++) {
+		streamer.Request(paths[i], GL_TEXTURE_2D_ARRAY, textureID, i, width, height, true, true);
+	}
+
+	return textureID;
+}
@@ -0,0 +1,36 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Capas del arreglo de texturas de materiales. El orden debe coincidir con
+// el de las rutas que se pasan a loadTextureArray
+enum MaterialLayer
+{
+	LAYER_METAL_GREEN = 0,
+	LAYER_BLOCKS = 1,
+	LAYER_METAL = 2,
+	LAYER_COUNT
+};
+
+class TextureStreamer;
+
+// Carga todas las imagenes en un unico GL_TEXTURE_2D_ARRAY (una capa por
+// imagen) con su cadena de mipmaps. Reserva el arreglo con el tamano de la
+// primera imagen y encola cada capa en el streamer; las imagenes de tamano
+// distinto se reescalan para que todas las capas compartan dimensiones.
+unsigned int streamTextureArray(const vector<string>& paths, TextureStreamer& streamer);
+
+// Reserva un GL_TEXTURE_2D_ARRAY RGBA vacio con 'levels' niveles de mipmap
+// y los parametros de materiales
+unsigned int createTextureArray(int width, int height, int layers, int levels);
+
+// Reescalado RGBA por vecino mas cercano
+void resizeNearest(const unsigned char* data, int width, int height, unsigned char* resized, int newWidth, int newHeight);
+
+#endif
@@ -0,0 +1,288 @@
+#include "TextureStreamer.h"
+#include "Texture.h"
+#include "Mipmap.h"
+#include "stb_image/stb_image.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+// Los offsets de cada segmento se alinean para que cualquier formato de
+// pixel quede bien alineado dentro del PBO
+const size_t slotAlignment = 256;
+
+TextureStreamer::TextureStreamer(size_t slotSize, int slotCount, int workerCount)
+{
+	this->slotSize = (slotSize + slotAlignment - 1) / slotAlignment * slotAlignment;
+	outstanding = 0;
+	stopping = false;
+	pbo = 0;
+
+	size_t totalSize = this->slotSize * slotCount;
+
+	// El mapeo persistente requiere GL 4.4 o GL_ARB_buffer_storage
+	usePbo = GLEW_ARB_buffer_storage;
+	if (usePbo) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glGenBuffers(1, &pbo);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, totalSize, NULL, flags);
+		mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, totalSize, flags);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (!mapped) {
+			LOG_WARNING("TextureStreamer: could not map PBO, using client memory");
+			glDeleteBuffers(1, &pbo);
+			pbo = 0;
+			usePbo = false;
+		}
+	}
+	if (!usePbo) {
+		clientMemory.resize(totalSize);
+		mapped = clientMemory.data();
+	}
+
+	slots.resize(slotCount);
+	for (int i = 0; i < slotCount; i++) {
+		slots[i].offset = this->slotSize * i;
+		slots[i].state = SLOT_FREE;
+		slots[i].fence = 0;
+	}
+
+	for (int i = 0; i < workerCount; i++) {
+		workers.push_back(thread(&TextureStreamer::WorkerLoop, this));
+	}
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	{
+		lock_guard<mutex> guard(queueMutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	slotFreed.notify_all();
+
+	for (thread& worker : workers) {
+		worker.join();
+	}
+
+	for (Slot& slot : slots) {
+		if (slot.fence) {
+			glDeleteSync(slot.fence);
+		}
+	}
+
+	if (usePbo) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &pbo);
+	}
+}
+
+void TextureStreamer::Request(const string& path, GLenum target, unsigned int texture, int layer,
+	int width, int height, bool flip, bool mipmaps)
+{
+	int levels = mipmaps ? mipLevelCount(width, height) : 1;
+	Job job = { path, target, texture, layer, width, height, levels, flip };
+
+	{
+		lock_guard<mutex> guard(queueMutex);
+		pending.push_back(job);
+		outstanding++;
+	}
+	jobAvailable.notify_one();
+}
+
+void TextureStreamer::WorkerLoop()
+{
+	while (true) {
+		Job job;
+		{
+			unique_lock<mutex> guard(queueMutex);
+			jobAvailable.wait(guard, [this] { return stopping || !pending.empty(); });
+			if (stopping) {
+				return;
+			}
+			job = pending.front();
+			pending.pop_front();
+		}
+
+		int width, height, nrChannels;
+		stbi_set_flip_vertically_on_load_thread(job.flip);
+
+		// Si la imagen ya tiene el tamano pedido se decodifica directamente
+		// sobre la memoria mapeada del segmento, sin buffer intermedio
+		size_t bytes = mipChainSize(job.width, job.height, job.levels);
+		bool direct = bytes <= slotSize && stbi_info(job.path.c_str(), &width, &height, &nrChannels)
+			&& width == job.width && height == job.height;
+
+		unsigned char* data = NULL;
+		if (!direct) {
+			data = stbi_load(job.path.c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
+		}
+
+		if ((!direct && !data) || bytes > slotSize) {
+			LOG_ERROR("Failed to stream texture: {}", job.path);
+			stbi_image_free(data);
+
+			lock_guard<mutex> guard(queueMutex);
+			outstanding--;
+			continue;
+		}
+
+		int slot = AcquireSlot();
+		if (slot < 0) {
+			stbi_image_free(data);
+			return;
+		}
+
+		unsigned char* dst = mapped + slots[slot].offset;
+		bool ok = true;
+		if (direct) {
+			ok = stbi_load_into(job.path.c_str(), dst, slotSize, &width, &height, &nrChannels, STBI_rgb_alpha);
+		}
+		else {
+			resizeNearest(data, width, height, dst, job.width, job.height);
+			stbi_image_free(data);
+		}
+
+		// Los mipmaps se calculan aqui, fuera del hilo de GL
+		if (ok && job.levels > 1) {
+			buildMipChain(dst, job.width, job.height, job.levels);
+		}
+
+		{
+			lock_guard<mutex> guard(queueMutex);
+			if (ok) {
+				slots[slot].job = job;
+				slots[slot].state = SLOT_READY;
+			}
+			else {
+				LOG_ERROR("Failed to stream texture: {}", job.path);
+				slots[slot].state = SLOT_FREE;
+				outstanding--;
+			}
+		}
+		if (!ok) {
+			slotFreed.notify_one();
+		}
+	}
+}
+
+// Espera a que haya un segmento libre y lo reserva. Devuelve -1 si el
+// streamer se esta cerrando
+int TextureStreamer::AcquireSlot()
+{
+	unique_lock<mutex> guard(queueMutex);
+	slotFreed.wait(guard, [this] { return stopping || FindFreeSlot() >= 0; });
+	if (stopping) {
+		return -1;
+	}
+	int slot = FindFreeSlot();
+	slots[slot].state = SLOT_WRITING;
+	return slot;
+}
+
+int TextureStreamer::FindFreeSlot()
+{
+	for (unsigned int i = 0; i < slots.size(); i++) {
+		if (slots[i].state == SLOT_FREE) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void TextureStreamer::Update()
+{
+	bool freed = false;
+	{
+		lock_guard<mutex> guard(queueMutex);
+
+		// Reciclamos los segmentos cuya copia ya termino en la GPU
+		for (Slot& slot : slots) {
+			if (slot.state != SLOT_IN_FLIGHT) {
+				continue;
+			}
+			GLenum status = glClientWaitSync(slot.fence, 0, 0);
+			if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+				glDeleteSync(slot.fence);
+				slot.fence = 0;
+				slot.state = SLOT_FREE;
+				freed = true;
+			}
+		}
+
+		for (Slot& slot : slots) {
+			if (slot.state == SLOT_READY) {
+				Upload(slot);
+				slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				slot.state = SLOT_IN_FLIGHT;
+				outstanding--;
+			}
+		}
+	}
+
+	if (freed) {
+		slotFreed.notify_all();
+	}
+}
+
+void TextureStreamer::Upload(Slot& slot)
+{
+	const Job& job = slot.job;
+
+	if (usePbo) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	}
+
+	if (job.target == GL_TEXTURE_2D_ARRAY) {
+		glBindTexture(GL_TEXTURE_2D_ARRAY, job.texture);
+	}
+	else if (job.target == GL_TEXTURE_2D) {
+		glBindTexture(GL_TEXTURE_2D, job.texture);
+	}
+	else {
+		// Caras de un cubemap
+		glBindTexture(GL_TEXTURE_CUBE_MAP, job.texture);
+	}
+
+	int width = job.width;
+	int height = job.height;
+	for (int level = 0; level < job.levels; level++) {
+		// Con PBO el "puntero" de glTexSubImage es un offset dentro del buffer
+		size_t offset = slot.offset + mipLevelOffset(job.width, job.height, level);
+		const void* pixels = usePbo ? (const void*)offset : (const void*)(mapped + offset);
+
+		if (job.target == GL_TEXTURE_2D_ARRAY) {
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, job.layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+		else {
+			glTexSubImage2D(job.target, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	if (usePbo) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+}
+
+void TextureStreamer::Finish()
+{
+	while (!Idle()) {
+		Update();
+		this_thread::yield();
+	}
+}
+
+bool TextureStreamer::Idle()
+{
+	lock_guard<mutex> guard(queueMutex);
+	return outstanding == 0;
+}
@@ -0,0 +1,97 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Subida de texturas en segundo plano a traves de un anillo de PBOs mapeados
+// de forma persistente. Los hilos decodificadores escriben (o decodifican, con
+// stbi_load_into) directamente en la memoria mapeada, construyen ahi mismo la
+// cadena de mipmaps y el hilo de GL solo emite glTexSubImage desde offsets
+// del buffer. Cada segmento del anillo queda protegido por un fence hasta que
+// la GPU termina de leerlo.
+class TextureStreamer
+{
+public:
+
+	TextureStreamer(size_t slotSize, int slotCount, int workerCount = 1);
+	~TextureStreamer();
+
+	// Encola la imagen 'path' para la textura 'texture'. 'target' puede ser
+	// GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY (se usa 'layer') o una cara de un
+	// cubemap. La imagen se reescala a width x height si no coincide. Con
+	// 'mipmaps' se suben todos los niveles, que la textura ya debe tener
+	// reservados (ver mipLevelCount).
+	void Request(const string& path, GLenum target, unsigned int texture, int layer,
+		int width, int height, bool flip, bool mipmaps);
+
+	// Sube los segmentos listos y recicla los que la GPU ya leyo.
+	// Solo se llama desde el hilo del contexto de GL, una vez por frame
+	void Update();
+
+	// Bloquea hasta que todas las peticiones se hayan subido
+	void Finish();
+
+	bool Idle();
+
+private:
+
+	enum SlotState
+	{
+		SLOT_FREE,
+		SLOT_WRITING,
+		SLOT_READY,
+		SLOT_IN_FLIGHT
+	};
+
+	struct Job
+	{
+		string path;
+		GLenum target;
+		unsigned int texture;
+		int layer;
+		int width;
+		int height;
+		int levels;
+		bool flip;
+	};
+
+	struct Slot
+	{
+		size_t offset;
+		SlotState state;
+		GLsync fence;
+		Job job;
+	};
+
+	void WorkerLoop();
+	int AcquireSlot();
+	int FindFreeSlot();
+	void Upload(Slot& slot);
+
+	size_t slotSize;
+	bool usePbo;
+	unsigned int pbo;
+	unsigned char* mapped;
+	vector<unsigned char> clientMemory; // respaldo si no hay GL_ARB_buffer_storage
+	vector<Slot> slots;
+
+	deque<Job> pending;
+	int outstanding;
+	bool stopping;
+
+	mutex queueMutex;
+	condition_variable jobAvailable;
+	condition_variable slotFreed;
+	vector<thread> workers;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+using namespace std;
+
+// Triple buffer sin locks para un productor y un consumidor. El productor
+// escribe en Back() y llama a Publish(); el consumidor llama a Consume() y
+// lee Front(). Cada lado es duenno de su buffer y solo el indice del medio se
+// intercambia atomicamente, asi que ninguno de los dos espera nunca al otro:
+// el consumidor siempre ve el ultimo valor publicado completo.
+template <typename T>
+class TripleBuffer
+{
+public:
+
+	TripleBuffer() : back(0), middle(1), front(2) {}
+
+	// Solo el productor
+	T& Back()
+	{
+		return buffers[back];
+	}
+
+	void Publish()
+	{
+		back = middle.exchange(back | freshBit, memory_order_acq_rel) & indexMask;
+	}
+
+	// Solo el consumidor. Devuelve true si habia un valor nuevo
+	bool Consume()
+	{
+		if (!(middle.load(memory_order_relaxed) & freshBit)) {
+			return false;
+		}
+		front = middle.exchange(front, memory_order_acq_rel) & indexMask;
+		return true;
+	}
+
+	const T& Front() const
+	{
+		return buffers[front];
+	}
+
+private:
+
+	static const int indexMask = 3;
+	static const int freshBit = 4;
+
+	T buffers[3] = {};
+	int back;
+	atomic<int> middle;
+	int front;
+};
+
+#endif
@@ -9,9 +9,27 @@
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
 #include <filesystem>
+#include <algorithm>
 
 #include "Geometry.h"
 #include "Tank.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "JobSystem.h"
+#include "Benchmark.h"
+#include "TextureStreamer.h"
+#include "Mipmap.h"
+#include "ParticleSystem.h"
+#include "Log.h"
+#include "FramePacer.h"
+#include "NetGame.h"
+#include "Terrain.h"
+#include "RenderQueue.h"
+#include "Skybox.h"
+#include "ClusteredLighting.h"
+#include "CascadedShadows.h"
+#include "DynamicResolution.h"
+#include "DeferredShading.h"
 
 using namespace std;
 
@@ -36,8 +54,8 @@ float fov = 45.0f;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-bool CheckCollision(Cube& one, Tank& two);
-bool CheckCollisionProjectile(Cube& one, Cylinder& two);
+// La simulacion avanza en pasos fijos, independientes de la tasa de frames
+const float SIMULATION_STEP = 1.0f / 60.0f;
 
 // Metodos
 void processInput(GLFWwindow* window) {
@@ -61,6 +79,20 @@ void processInput(GLFWwindow* window) {
 
 }
 
+TankInput readTankInput(GLFWwindow* window) {
+	TankInput input;
+	input.canonUp = glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS;
+	input.canonDown = glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS;
+	input.canonRight = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+	input.canonLeft = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+	input.forward = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+	input.backwards = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+	input.bodyLeft = glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS;
+	input.bodyRight = glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS;
+	input.fire = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+	return input;
+}
+
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 
 
@@ -104,31 +136,40 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 		fov = 45.0f;
 }
 
-unsigned int loadSkybox(vector<std::string> faces)
+unsigned int loadSkybox(vector<std::string> faces, TextureStreamer& streamer)
 {
 
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
+	// Las caras de un cubemap deben ser cuadradas; se reservan con el lado
+	// menor de la primera imagen y el streamer reescala el contenido
 	int width, height, nrChannels;
+	int faceSize = 1;
+	if (stbi_info(faces[0].c_str(), &width, &height, &nrChannels))
+	{
+		faceSize = std::min(width, height);
+	}
+	else
+	{
+		LOG_ERROR("Cubemap tex failed to load at path: {}", faces[0]);
+	}
+
+	// Se reservan todos los niveles; la cadena de mipmaps se calcula en CPU
+	int levels = mipLevelCount(faceSize, faceSize);
 	for (unsigned int i = 0; i < faces.size(); i++)
 	{
-		unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-		if (data)
+		for (int level = 0, size = faceSize; level < levels; level++, size = std::max(1, size / 2))
 		{
 			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-				0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
+				level, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL
 			);
-			stbi_image_free(data);
-		}
-		else
-		{
-			std::cout << "Cubemap tex failed to load at path: " << faces[i] << std::endl;
-			stbi_image_free(data);
 		}
+		streamer.Request(faces[i], GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, textureID, 0, faceSize, faceSize, true, true);
 	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -137,7 +178,100 @@ unsigned int loadSkybox(vector<std::string> faces)
 	return textureID;
 };
 
-int main(void) {
+int main(int argc, char** argv) {
+
+	// Modo de benchmark sin ventana: --bench-jobs [entidades] [frames]
+	if (argc > 1 && string(argv[1]) == "--bench-jobs") {
+		int entities = argc > 2 ? atoi(argv[2]) : 10000;
+		int frames = argc > 3 ? atoi(argv[3]) : 300;
+		return runJobBenchmark(entities, frames);
+	}
+
+	// --bench-broadphase [frames]: 1k, 10k y 100k cuerpos
+	if (argc > 1 && string(argv[1]) == "--bench-broadphase") {
+		int frames = argc > 2 ? atoi(argv[2]) : 60;
+		int result = 0;
+		for (int bodies : { 1000, 10000, 100000 }) {
+			result |= runBroadphaseBenchmark(bodies, frames);
+		}
+		return result;
+	}
+
+	// --bench-narrowphase [objetivos] [frames]
+	if (argc > 1 && string(argv[1]) == "--bench-narrowphase") {
+		int boxes = argc > 2 ? atoi(argv[2]) : 10000;
+		int frames = argc > 3 ? atoi(argv[3]) : 20;
+		return runNarrowphaseBenchmark(boxes, frames);
+	}
+
+	// --bench-ballistics [proyectiles] [pasos]
+	if (argc > 1 && string(argv[1]) == "--bench-ballistics") {
+		int projectiles = argc > 2 ? atoi(argv[2]) : 1000000;
+		int steps = argc > 3 ? atoi(argv[3]) : 60;
+		return runBallisticsBenchmark(projectiles, steps);
+	}
+
+	// --bench-render-queue [dibujos] [frames]
+	if (argc > 1 && string(argv[1]) == "--bench-render-queue") {
+		int draws = argc > 2 ? atoi(argv[2]) : 100000;
+		int frames = argc > 3 ? atoi(argv[3]) : 60;
+		return runRenderQueueBenchmark(draws, frames);
+	}
+
+	// --bench-lights [luces] [frames]
+	if (argc > 1 && string(argv[1]) == "--bench-lights") {
+		int lights = argc > 2 ? atoi(argv[2]) : 500;
+		int frames = argc > 3 ? atoi(argv[3]) : 200;
+		return runLightBinningBenchmark(lights, frames);
+	}
+
+	// --bench-deferred [frames]: forward contra diferido, en la GPU
+	if (argc > 1 && string(argv[1]) == "--bench-deferred") {
+		int frames = argc > 2 ? atoi(argv[2]) : 200;
+		return runDeferredBenchmark(frames);
+	}
+
+	// --scenario [tanques] [objetivos] [proyectiles] [frames] [semilla] [salida.json]
+	if (argc > 1 && string(argv[1]) == "--scenario") {
+		ScenarioConfig config;
+		config.tankCount = argc > 2 ? atoi(argv[2]) : 100;
+		config.targetCount = argc > 3 ? atoi(argv[3]) : 1000;
+		config.projectileCount = argc > 4 ? atoi(argv[4]) : 1000;
+		config.frames = argc > 5 ? atoi(argv[5]) : 600;
+		config.seed = argc > 6 ? (unsigned int)atoi(argv[6]) : 1234;
+		config.outputPath = argc > 7 ? argv[7] : "scenario.json";
+		return runScenario(config);
+	}
+
+	// --net-loopback [clientes] [segundos] [latencia ms] [perdida %]
+	if (argc > 1 && string(argv[1]) == "--net-loopback") {
+		int clients = argc > 2 ? atoi(argv[2]) : 8;
+		double seconds = argc > 3 ? atof(argv[3]) : 10.0;
+		double latency = argc > 4 ? atof(argv[4]) / 1000.0 : 0.05;
+		double loss = argc > 5 ? atof(argv[5]) / 100.0 : 0.05;
+		return runLoopbackMatch(clients, seconds, latency, loss);
+	}
+
+	// --server [puerto] [jugadores]: servidor dedicado sin ventana
+	if (argc > 1 && string(argv[1]) == "--server") {
+		int port = argc > 2 ? atoi(argv[2]) : 27015;
+		int players = argc > 3 ? atoi(argv[3]) : 32;
+		return runDedicatedServer((uint16_t)port, players);
+	}
+
+	// --connect host [puerto]: los tanques vienen del servidor en lugar de
+	// la simulacion local
+	NetAddress serverAddress;
+	bool networked = false;
+	if (argc > 2 && string(argv[1]) == "--connect") {
+		int port = argc > 3 ? atoi(argv[3]) : 27015;
+		if (!parseAddress(argv[2], (uint16_t)port, serverAddress)) {
+			LOG_ERROR("Invalid server address: {}", argv[2]);
+			flushLog();
+			return EXIT_FAILURE;
+		}
+		networked = true;
+	}
 
 	GLFWwindow* window;
 
@@ -163,42 +297,74 @@ int main(void) {
 	/* Iniciacion de libreria de glew */
 	GLenum glew_status = glewInit();
 	if (glew_status != GLEW_OK) {
-		cerr << "Error: glewInit: " << glewGetErrorString(glew_status) << endl;
+		LOG_ERROR("Error: glewInit: {}", (const char*)glewGetErrorString(glew_status));
 		return EXIT_FAILURE;
 	}
 
+	// Vsync, limite de frames y modo de espera sin foco:
+	// --vsync off|on|adaptive, --fps N, --idle-fps N
+	FramePacer pacer(window, parseFramePacing(argc, argv));
+
+	// --frames N: cierra la ventana despues de N frames dibujados, para
+	// correr el juego en pruebas automaticas (tambien con render por software)
+	int frameLimit = 0;
+	for (int i = 1; i + 1 < argc; i++) {
+		if (string(argv[i]) == "--frames") {
+			frameLimit = atoi(argv[i + 1]);
+		}
+	}
+	int framesDrawn = 0;
+
+	// --deferred: los objetos van a un G-buffer y las luces se aplican en
+	// un pase aparte, una vez por pixel
+	bool deferred = false;
+	for (int i = 1; i < argc; i++) {
+		deferred |= string(argv[i]) == "--deferred";
+	}
+	const char* fragmentPath = deferred ? "src/Shaders/GBufferFragmentShader.fs" : "src/Shaders/FragmentShader.fs";
+
 	// Habilitamos la profundidad
 	glEnable(GL_DEPTH_TEST);
 
-	Shader shader("src/Shaders/VertexShader.vs", "src/Shaders/FragmentShader.fs");
+	Shader shader("src/Shaders/VertexShader.vs", fragmentPath);
+
+	// Anillo de PBOs para subir texturas sin bloquear el hilo de GL.
+	// Cada segmento alcanza para una imagen RGBA de 1920x1080, o para una
+	// de 1024x1024 con toda su cadena de mipmaps
+	TextureStreamer* streamer = new TextureStreamer(1920 * 1080 * 4, 3, 2);
 
 	Tank tank;
+	tank.SetupGL();
 	Cube cube = Cube(2.0f, 2.0f, 2.0f);
 	cube.SetPosition(glm::vec3(0.0f, 0.0f, 15.0f));
+	cube.SetLayer(LAYER_METAL);
 	cube.SetupGL();
 
-	Cube floor = Cube(20.0f, 0.5f, 20.0f);
-	cube.SetPosition(glm::vec3(0.0f, -1.0f, 0.0f));
-	cube.SetupGL();
+	// Terreno de 2 km por lado; cerca del origen queda plano a la altura
+	// de las ruedas del tanque. Si hay una imagen de alturas se usa esa
+	Heightmap heightmap;
+	const char* heightmapPath = "resources/textures/heightmap.png";
+	if (!filesystem::exists(heightmapPath) || !heightmap.Load(heightmapPath, 1025, 2.0f, -tankRideHeight, 40.0f)) {
+		heightmap.Generate(1025, 2.0f, -tankRideHeight, 40.0f, 1234);
+	}
+	Terrain* terrain = new Terrain(heightmap, fragmentPath);
 
 	Sphere sphere2 = Sphere(1.0f, 36, 18, true);
 	sphere2.SetPosition(glm::vec3(3.0f, 0.0f, 15.0f));
+	sphere2.SetLayer(LAYER_METAL);
 	sphere2.SetupGL();
 
 	//Cylinder cylinder = Cylinder(2.0f, 3.0f, 36, glm::vec3(0.0f, 0.0f, 3.0f));
 
 	//cylinder.SetupGL();
-	tank.LoadTextures(shader);
+	tank.LoadTextures(shader, *streamer);
 
-	glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+	float nearPlane = 0.1f;
+	float farPlane = 1000.0f;
+	glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WIDTH / (float)HEIGHT, nearPlane, farPlane);
 	shader.setMat4("projection", projection);
 
 	// Skybox area
-	Shader skyboxShader("src/Shaders/SkyboxVertexShader.vs", "src/Shaders/SkyboxFragmentShader.fs");
-
-	unsigned int skyboxVAO;
-	glGenVertexArrays(1, &skyboxVAO);
-
 	vector<std::string> faces
 	{
 		"resources/textures/skybox.png",
@@ -209,29 +375,98 @@ int main(void) {
 			"resources/textures/skybox.png"
 	};
 
-	unsigned int cubemapTexture = loadSkybox(faces);
+	unsigned int cubemapTexture = loadSkybox(faces, *streamer);
+	Skybox* skybox = new Skybox(cubemapTexture);
+
+	// La simulacion corre en su propio hilo; este hilo solo lee input y
+	// dibuja la ultima foto publicada mientras se simula el paso siguiente
+	Simulation simulation(SIMULATION_STEP);
+	simulation.AddTank(tank);
+	simulation.AddTarget(cube);
+	simulation.AddScenery(sphere2);
+	simulation.SetGround(&heightmap);
+	if (!networked) {
+		simulation.Start();
+	}
+
+	GameClient* client = NULL;
+	FrameSnapshot clientSnapshot;
+	if (networked) {
+		LinkConditions conditions = { 0.0, 0.0, 0.0 };
+		client = new GameClient(SIMULATION_STEP, true);
+		client->Connect(serverAddress, conditions, 1);
+	}
+
+	// Trabajadores para las etapas del frame que no tocan GL. Se dejan
+	// nucleos libres para el hilo de simulacion y los del streamer
+	JobSystem jobs(max(0, (int)thread::hardware_concurrency() - 2));
+	DrawListScratch drawListScratch;
+	vector<DrawItem> drawList;
+
+	// Todo el dibujo del frame pasa por la cola, ordenado por estado
+	RenderQueue renderQueue(farPlane);
+
+	// Fogonazos, humo y explosiones; el pool de cada tipo vive en la GPU
+	ParticleSystem* particles = new ParticleSystem(1 << 18);
+	unsigned long long lastEffect = 0;
+
+	// Fogonazos y explosiones tambien iluminan, repartidos por froxels
+	ClusteredLighting* lighting = new ClusteredLighting(nearPlane, farPlane);
+
+	// Sombras del sol; terreno, objetivos y escenario quedan en cache
+	CascadedShadows* shadows = new CascadedShadows(nearPlane);
+	shadows->SetLightDirection(glm::vec3(0.4f, 1.0f, 0.3f));
+
+	// La escena se dibuja a la escala que permita el presupuesto de GPU:
+	// --gpu-budget MS, --min-scale F, --max-scale F, --render-scale F
+	DynamicResolution* resolution = new DynamicResolution(WIDTH, HEIGHT, parseResolution(argc, argv));
+	DeferredShading* deferredShading = deferred ? new DeferredShading(WIDTH, HEIGHT) : NULL;
 
 	/* Ciclo hasta que el usuario cierre la ventana */
 	while (!glfwWindowShouldClose(window))
 	{
+		// Minimizada no se dibuja; la simulacion sigue en su hilo
+		if (!pacer.BeginFrame()) {
+			continue;
+		}
+
 		// Clock
 		float currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
+		// Texturas que terminaron de decodificarse en segundo plano
+		streamer->Update();
+
 		// input
 		processInput(window);
 
+		// Ultimo estado simulado, interpolado entre sus dos pasos. En red el
+		// cliente avanza en este hilo y su foto reemplaza a la local
+		const FrameSnapshot* latest;
+		const vector<Geometry*>* objects;
+		float alpha;
+		if (client) {
+			client->Update(readTankInput(window), glfwGetTime());
+			client->Capture(clientSnapshot);
+			latest = &clientSnapshot;
+			objects = &client->Objects();
+			alpha = client->Interpolation(glfwGetTime());
+		}
+		else {
+			simulation.SetInput(readTankInput(window));
+			latest = &simulation.LatestSnapshot();
+			objects = &simulation.Objects();
+			alpha = simulation.Interpolation(*latest, glfwGetTime());
+		}
+		const FrameSnapshot& snapshot = *latest;
+
 
 		/* Limpieza del buffer y el buffer de profundidad */
 		//glClearColor(0.761f, 1.0f, 0.992f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
+		resolution->BeginScene();
+		glm::vec2 renderSize = glm::vec2(resolution->RenderSize());
 
-		glDepthMask(GL_FALSE);
-		skyboxShader.use();
-
-		shader.use();
 
 		// Aplicamos la matriz del view (hacia donde esta viendo la camara)
 		glm::mat4 view = glm::mat4(1.0f);
@@ -240,88 +475,99 @@ int main(void) {
 			cameraPos + cameraFront,
 			cameraUp
 		);
+		shader.use();
 		shader.setMat4("view", view);
-		if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS) {
-			tank.moveCanonUp(deltaTime);
-		}
 
-		if (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS) {
-			//cube.moveForward(ourShader);
-			tank.moveCanonDown(deltaTime);
-		}
-		if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS) {
-			//cube.moveForward(ourShader);
-			tank.moveCanonRight(deltaTime);
-		}
-		if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS) {
-			//cube.moveForward(ourShader);
-			tank.moveCanonLeft(deltaTime);
-		}
-		if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-			//cube.moveForward(ourShader);
-			tank.moveForward(shader);
+		renderQueue.Clear();
+
+		Frustum frustum = extractFrustum(projection * view);
+		buildDrawList(*objects, snapshot, alpha, frustum, jobs, drawListScratch, drawList);
+		renderQueue.Submit(shader.ID, drawList, cameraPos, jobs);
+
+		renderQueue.Submit(PASS_TERRAIN, 0, [&]() {
+			terrain->Draw(view, projection, cameraPos, frustum, tank.textureArray);
+		});
+		renderQueue.Submit(PASS_SKY, 0, [&]() {
+			skybox->Draw(view, projection);
+		});
+
+		// Efectos nuevos desde la ultima foto dibujada
+		for (const EffectEvent& effect : snapshot.effects) {
+			if (effect.sequence > lastEffect) {
+				particles->Emit(effect);
+				lighting->Emit(effect);
+				lastEffect = effect.sequence;
+			}
 		}
-		if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-			//cube.moveForward(ourShader);
-			tank.moveBackwards(shader);
+		particles->Update(deltaTime, frustum);
+
+		lighting->Update(deltaTime);
+		lighting->Build(view, projection, jobs);
+		lighting->Upload();
+		// En diferido solo el pase de luces las necesita
+		if (deferredShading) {
+			lighting->Apply(deferredShading->GetLightingShader(), renderSize);
 		}
-
-		if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
-			//cube.moveForward(ourShader);
-			tank.rotateBodyLeft(deltaTime);
+		else {
+			lighting->Apply(shader, renderSize);
+			lighting->Apply(terrain->GetShader(), renderSize);
 		}
 
-		if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
-			//cube.moveForward(ourShader);
-			tank.rotateBodyRight(deltaTime);
-			
+		shadows->Fit(view, projection);
+		shadows->SelectCasters(*objects, snapshot, alpha, jobs);
+		shadows->Render(*terrain);
+		if (deferredShading) {
+			shadows->Apply(deferredShading->GetLightingShader());
+			renderQueue.Submit(PASS_LIGHTING, 0, [&]() {
+				deferredShading->Resolve(view, projection);
+			});
 		}
-
-		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-			//cube.moveForward(ourShader);
-			tank.fire();
-
+		else {
+			shadows->Apply(shader);
+			shadows->Apply(terrain->GetShader());
 		}
+		renderQueue.Submit(PASS_EFFECTS, 0, [&]() {
+			particles->Draw(view, projection);
+		});
 
-		if (CheckCollision(cube, tank)) {
-			cube.CleanGL();
-		}
+		// Todos los objetos comparten el arreglo de texturas del tanque, cada
+		// uno elige su capa
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, tank.textureArray);
 
-		if (tank.hasBeenShotF()) {
-			Cylinder *projectile = tank.getProjectile();
-			if (CheckCollisionProjectile(cube, *projectile)) {
-				projectile->CleanGL();
-				cube.CleanGL();
-				tank.setHasBeenShot();
-			}
-			if (projectile->position.z >= 40.0f) {
-				projectile->CleanGL();
-				tank.setHasBeenShot();
-			}
+		if (deferredShading) {
+			deferredShading->BeginGeometry();
 		}
-		
+		renderQueue.Sort();
+		renderQueue.Execute(jobs);
 
-		glBindVertexArray(skyboxVAO);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glDepthMask(GL_TRUE);
+		// Escala la escena a la ventana con el filtro de nitidez
+		resolution->EndScene();
 
-		//cylinder.Draw(ourShader);
-		cube.Draw(shader);
-		sphere2.Draw(shader);
-		tank.Draw(shader);
-		glBindVertexArray(0);
+		/* Intercambio entre buffers y recepcion de eventos */
+		pacer.EndFrame();
 
-		/* Intercambio entre buffers */
-		glfwSwapBuffers(window);
+		if (frameLimit > 0 && ++framesDrawn >= frameLimit) {
+			glfwSetWindowShouldClose(window, true);
+		}
+	}
 
-		/* Recepcion de eventos */
-		glfwPollEvents();
+	LOG_INFO("Resolution: scale {} at {} ms GPU", resolution->Scale(), resolution->GpuTime());
 
-	}
+	// La simulacion debe terminar antes de liberar los objetos que usa
+	simulation.Stop();
+	delete client;
 
 	// Borramos el contenido de los buffers
 	tank.Clear();
+	delete terrain;
+	delete skybox;
+	delete particles;
+	delete lighting;
+	delete shadows;
+	delete deferredShading;
+	delete resolution;
+	delete streamer;
 
 	/* Cierre de glfw */
 	glfwTerminate();
@@ -329,33 +575,3 @@ int main(void) {
 	return 0;
 }
 
-
-bool CheckCollision(Cube& one, Tank& two) // AABB - AABB collision
-{
-	// collision x-axis?
-	bool collisionX = one.position.x + one.size.x >= two.getPosition().x &&
-		two.getPosition().x + two.getSize().x >= one.position.x;
-	// collision y-axis?
-	bool collisionY = one.position.y + one.size.y >= two.getPosition().y &&
-		two.getPosition().y + two.getSize().y >= one.position.y;
-
-	bool collisionZ = one.position.z + one.size.z >= two.getPosition().z &&
-		two.getPosition().z + two.getSize().z >= one.position.z;
-	// collision only if on both axes
-	return collisionX && collisionY && collisionZ;
-}
-
-bool CheckCollisionProjectile(Cube& one, Cylinder& two) // AABB - AABB collision
-{
-	// collision x-axis?
-	bool collisionX = one.position.x + one.size.x >= two.getPosition().x &&
-		two.getPosition().x + two.getSize().x >= one.position.x;
-	// collision y-axis?
-	bool collisionY = one.position.y + one.size.y >= two.getPosition().y &&
-		two.getPosition().y + two.getSize().y >= one.position.y;
-
-	bool collisionZ = one.position.z + one.size.z >= two.getPosition().z &&
-		two.getPosition().z + two.getSize().z >= one.position.z;
-	// collision only if on both axes
-	return collisionX && collisionY && collisionZ;
-}
\ No newline at end of file
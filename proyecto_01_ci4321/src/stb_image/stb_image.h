@@ -428,6 +428,13 @@ extern "C" {
     STBIDEF stbi_uc* stbi_load(char const* filename, int* x, int* y, int* channels_in_file, int desired_channels);
     STBIDEF stbi_uc* stbi_load_from_file(FILE* f, int* x, int* y, int* channels_in_file, int desired_channels);
     // for stbi_load_from_file, file pointer is left pointing immediately after image
+
+    // decode into a caller-provided buffer of buffer_size bytes. desired_channels must be
+    // nonzero. 8-bit non-interlaced, non-paletted PNGs are decoded straight into 'buffer'
+    // with no intermediate allocation; everything else is decoded normally and copied.
+    // returns 1 on success, 0 on failure (including a buffer smaller than x*y*desired_channels)
+    STBIDEF int stbi_load_into(char const* filename, stbi_uc* buffer, size_t buffer_size, int* x, int* y, int* channels_in_file, int desired_channels);
+    STBIDEF int stbi_load_from_file_into(FILE* f, stbi_uc* buffer, size_t buffer_size, int* x, int* y, int* channels_in_file, int desired_channels);
 #endif
 
 #ifndef STBI_NO_GIF
@@ -818,6 +825,10 @@ typedef struct
 
     stbi_uc* img_buffer, * img_buffer_end;
     stbi_uc* img_buffer_original, * img_buffer_original_end;
+
+    // optional caller-provided output buffer (see stbi_load_into)
+    stbi_uc* user_out;
+    size_t user_out_size;
 } stbi__context;
 
 
@@ -831,6 +842,8 @@ static void stbi__start_mem(stbi__context* s, stbi_uc const* buffer, int len)
     s->callback_already_read = 0;
     s->img_buffer = s->img_buffer_original = (stbi_uc*)buffer;
     s->img_buffer_end = s->img_buffer_original_end = (stbi_uc*)buffer + len;
+    s->user_out = NULL;
+    s->user_out_size = 0;
 }
 
 // initialize a callback-based context
@@ -842,6 +855,8 @@ static void stbi__start_callbacks(stbi__context* s, stbi_io_callbacks* c, void*
     s->read_from_callbacks = 1;
     s->callback_already_read = 0;
     s->img_buffer = s->img_buffer_original = s->buffer_start;
+    s->user_out = NULL;
+    s->user_out_size = 0;
     stbi__refill_buffer(s);
     s->img_buffer_original_end = s->img_buffer_end;
 }
@@ -1387,6 +1402,41 @@ STBIDEF stbi_uc* stbi_load_from_file(FILE* f, int* x, int* y, int* comp, int req
     return result;
 }
 
+STBIDEF int stbi_load_into(char const* filename, stbi_uc* buffer, size_t buffer_size, int* x, int* y, int* comp, int req_comp)
+{
+    FILE* f = stbi__fopen(filename, "rb");
+    int result;
+    if (!f) return stbi__err("can't fopen", "Unable to open file");
+    result = stbi_load_from_file_into(f, buffer, buffer_size, x, y, comp, req_comp);
+    fclose(f);
+    return result;
+}
+
+STBIDEF int stbi_load_from_file_into(FILE* f, stbi_uc* buffer, size_t buffer_size, int* x, int* y, int* comp, int req_comp)
+{
+    unsigned char* result;
+    stbi__context s;
+    if (req_comp < 1 || req_comp > 4) return stbi__err("bad req_comp", "Internal error");
+    stbi__start_file(&s, f);
+    s.user_out = buffer;
+    s.user_out_size = buffer_size;
+    result = stbi__load_and_postprocess_8bit(&s, x, y, comp, req_comp);
+    if (!result) return 0;
+
+    // need to 'unget' all the characters in the IO buffer
+    fseek(f, -(int)(s.img_buffer_end - s.img_buffer), SEEK_CUR);
+    if (result == buffer) return 1;
+
+    // the loader could not decode in place; fall back to a copy
+    if ((size_t)*x * *y * req_comp > buffer_size) {
+        STBI_FREE(result);
+        return stbi__err("buffer too small", "Output buffer too small");
+    }
+    memcpy(buffer, result, (size_t)*x * *y * req_comp);
+    STBI_FREE(result);
+    return 1;
+}
+
 STBIDEF stbi__uint16* stbi_load_from_file_16(FILE* f, int* x, int* y, int* comp, int req_comp)
 {
     stbi__uint16* result;
@@ -4383,7 +4433,19 @@ static int stbi__parse_huffman_block(stbi__zbuf* a)
             p = (stbi_uc*)(zout - dist);
             if (dist == 1) { // run of one byte; common in images.
                 stbi_uc v = *p;
-                if (len) { do *zout++ = v; while (--len); }
+                memset(zout, v, len);
+                zout += len;
+            }
+            else if (dist >= len) { // source and destination don't overlap
+                memcpy(zout, p, len);
+                zout += len;
+            }
+            else if (dist >= 8) { // overlapping, but each 8-byte chunk reads bytes already written
+                while (len >= 8) {
+                    memcpy(zout, p, 8);
+                    zout += 8; p += 8; len -= 8;
+                }
+                if (len) { do *zout++ = *p++; while (--len); }
             }
             else {
                 if (len) { do *zout++ = *p++; while (--len); }
@@ -4677,6 +4739,7 @@ typedef struct
     stbi__context* s;
     stbi_uc* idata, * expanded, * out;
     int depth;
+    int out_direct; // out is the caller's buffer (s->user_out), never freed here
 } stbi__png;
 
 
@@ -4712,6 +4775,117 @@ static int stbi__paeth(int a, int b, int c)
     return t1;
 }
 
+// SIMD unfiltering for 8-bit PNG rows. Up is data-parallel across the whole row;
+// Sub/Avg/Paeth carry a dependency on the previous pixel, so they process one
+// 3- or 4-byte pixel per vector (same approach as libpng's SSE2 filters).
+// All of them produce exactly the same bytes as the scalar loops.
+#if defined(STBI_SSE2) && (defined(STBI__X64_TARGET) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define STBI__PNG_SSE2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// 3-byte pixels are assembled in registers; a 3-byte memcpy through the stack
+// would stall on store forwarding in the serial filters
+stbi_inline static __m128i stbi__png_load_px(const stbi_uc* p, int bpp)
+{
+    int v;
+    if (bpp == 4)
+        memcpy(&v, p, 4);
+    else
+        v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return _mm_cvtsi32_si128(v);
+}
+
+stbi_inline static void stbi__png_store_px(stbi_uc* p, __m128i v, int bpp)
+{
+    int x = _mm_cvtsi128_si32(v);
+    if (bpp == 4) {
+        memcpy(p, &x, 4);
+    }
+    else {
+        p[0] = STBI__BYTECAST(x);
+        p[1] = STBI__BYTECAST(x >> 8);
+        p[2] = STBI__BYTECAST(x >> 16);
+    }
+}
+
+static void stbi__png_unfilter_up_simd(stbi_uc* cur, const stbi_uc* raw, const stbi_uc* prior, int nk)
+{
+    int k = 0;
+#if defined(__AVX2__)
+    for (; k + 32 <= nk; k += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(raw + k));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(prior + k));
+        _mm256_storeu_si256((__m256i*)(cur + k), _mm256_add_epi8(x, b));
+    }
+#endif
+    for (; k + 16 <= nk; k += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(raw + k));
+        __m128i b = _mm_loadu_si128((const __m128i*)(prior + k));
+        _mm_storeu_si128((__m128i*)(cur + k), _mm_add_epi8(x, b));
+    }
+    for (; k < nk; ++k)
+        cur[k] = STBI__BYTECAST(raw[k] + prior[k]);
+}
+
+static void stbi__png_unfilter_sub_simd(stbi_uc* cur, const stbi_uc* raw, int nk, int bpp)
+{
+    __m128i a = _mm_setzero_si128();
+    int k;
+    for (k = 0; k < nk; k += bpp) {
+        a = _mm_add_epi8(a, stbi__png_load_px(raw + k, bpp));
+        stbi__png_store_px(cur + k, a, bpp);
+    }
+}
+
+static void stbi__png_unfilter_avg_simd(stbi_uc* cur, const stbi_uc* raw, const stbi_uc* prior, int nk, int bpp)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i a = _mm_setzero_si128();
+    int k;
+    for (k = 0; k < nk; k += bpp) {
+        __m128i b = stbi__png_load_px(prior + k, bpp);
+        // _mm_avg_epu8 rounds up; PNG's average truncates
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        a = _mm_add_epi8(stbi__png_load_px(raw + k, bpp), avg);
+        stbi__png_store_px(cur + k, a, bpp);
+    }
+}
+
+static void stbi__png_unfilter_paeth_simd(stbi_uc* cur, const stbi_uc* raw, const stbi_uc* prior, int nk, int bpp)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = zero, b = zero, c;
+    int k;
+    for (k = 0; k < nk; k += bpp) {
+        __m128i d, pa, pb, pc, smallest, nearest, is_a, is_b;
+        c = b;
+        b = _mm_unpacklo_epi8(stbi__png_load_px(prior + k, bpp), zero);
+        d = _mm_unpacklo_epi8(stbi__png_load_px(raw + k, bpp), zero);
+
+        // with p = a + b - c: |p-a| = |b-c|, |p-b| = |a-c|, |p-c| = |(b-c) + (a-c)|
+        pa = _mm_sub_epi16(b, c);
+        pb = _mm_sub_epi16(a, c);
+        pc = _mm_add_epi16(pa, pb);
+        pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+        pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+        pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+        smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+        // ties favour a, then b, then c
+        is_a = _mm_cmpeq_epi16(smallest, pa);
+        is_b = _mm_cmpeq_epi16(smallest, pb);
+        nearest = _mm_or_si128(_mm_and_si128(is_b, b), _mm_andnot_si128(is_b, c));
+        nearest = _mm_or_si128(_mm_and_si128(is_a, a), _mm_andnot_si128(is_a, nearest));
+
+        // 8-bit add so the high byte of each 16-bit lane stays zero
+        a = _mm_add_epi8(d, nearest);
+        stbi__png_store_px(cur + k, _mm_packus_epi16(a, a), bpp);
+    }
+}
+#endif // STBI__PNG_SSE2
+
 static const stbi_uc stbi__depth_scale_table[9] = { 0, 0xff, 0x55, 0, 0x11, 0,0,0, 0x01 };
 
 // adds an extra all-255 alpha channel
@@ -4755,7 +4929,10 @@ static int stbi__create_png_image_raw(stbi__png* a, stbi_uc* raw, stbi__uint32 r
     int width = x;
 
     STBI_ASSERT(out_n == s->img_n || out_n == s->img_n + 1);
-    a->out = (stbi_uc*)stbi__malloc_mad3(x, y, output_bytes, 0); // extra bytes to write off the end into
+    if (a->out_direct)
+        a->out = s->user_out;
+    else
+        a->out = (stbi_uc*)stbi__malloc_mad3(x, y, output_bytes, 0); // extra bytes to write off the end into
     if (!a->out) return stbi__err("outofmem", "Out of memory");
 
     // note: error exits here don't need to clean up a->out individually,
@@ -4797,6 +4974,22 @@ static int stbi__create_png_image_raw(stbi__png* a, stbi_uc* raw, stbi__uint32 r
         // if first row, use special filter that doesn't sample previous row
         if (j == 0) filter = first_row_filter[filter];
 
+#ifdef STBI__PNG_SSE2
+        if ((filter_bytes == 3 || filter_bytes == 4) && filter != STBI__F_none && filter != STBI__F_avg_first) {
+            switch (filter) {
+            case STBI__F_sub:   stbi__png_unfilter_sub_simd(cur, raw, nk, filter_bytes); break;
+            case STBI__F_up:    stbi__png_unfilter_up_simd(cur, raw, prior, nk); break;
+            case STBI__F_avg:   stbi__png_unfilter_avg_simd(cur, raw, prior, nk, filter_bytes); break;
+            case STBI__F_paeth: stbi__png_unfilter_paeth_simd(cur, raw, prior, nk, filter_bytes); break;
+            }
+            filter = -1; // handled
+        }
+        else if (filter == STBI__F_up) {
+            stbi__png_unfilter_up_simd(cur, raw, prior, nk);
+            filter = -1;
+        }
+#endif
+
         // perform actual filtering
         switch (filter) {
         case STBI__F_none:
@@ -5145,6 +5338,7 @@ static int stbi__parse_png_file(stbi__png* z, int scan, int req_comp)
     z->expanded = NULL;
     z->idata = NULL;
     z->out = NULL;
+    z->out_direct = 0;
 
     if (!stbi__check_png_header(s)) return 0;
 
@@ -5272,6 +5466,10 @@ static int stbi__parse_png_file(stbi__png* z, int scan, int req_comp)
                 s->img_out_n = s->img_n + 1;
             else
                 s->img_out_n = s->img_n;
+            // decode straight into the caller's buffer when nothing after this point
+            // needs to reallocate the image (palette expansion, 16-bit, format conversion)
+            z->out_direct = s->user_out != NULL && z->depth == 8 && !interlace && !pal_img_n &&
+                s->img_out_n == req_comp && (size_t)s->img_x * s->img_y * req_comp <= s->user_out_size;
             if (!stbi__create_png_image(z, z->expanded, raw_len, s->img_out_n, z->depth, color, interlace)) return 0;
             if (has_trans) {
                 if (z->depth == 16) {
@@ -5348,7 +5546,8 @@ static void* stbi__do_png(stbi__png* p, int* x, int* y, int* n, int req_comp, st
         *y = p->s->img_y;
         if (n) *n = p->s->img_n;
     }
-    STBI_FREE(p->out);      p->out = NULL;
+    if (!p->out_direct) STBI_FREE(p->out);
+    p->out = NULL;
     STBI_FREE(p->expanded); p->expanded = NULL;
     STBI_FREE(p->idata);    p->idata = NULL;
 